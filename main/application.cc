@@ -2,13 +2,28 @@
 #include "board.h"
 #include "display.h"
 #include "system_info.h"
-#include "ml307_ssl_transport.h"
 #include "audio_codec.h"
 #include "mqtt_protocol.h"
 #include "websocket_protocol.h"
 #include "font_awesome_symbols.h"
 #include "iot/thing_manager.h"
 #include "assets/lang_config.h"
+#include "console.h"
+#include "tracer.h"
+#include "memory_plan.h"
+#include "task_stacks.h"
+#if CONFIG_USE_AUDIO_BENCHMARK
+#include "audio_benchmark.h"
+#endif
+#if CONFIG_USE_SESSION_RECORDER
+#include "session_recorder.h"
+#endif
+#if CONFIG_USE_STACK_PROFILER
+#include "stack_profiler.h"
+#endif
+#if CONFIG_USE_STALL_DETECTOR
+#include "stall_detector.h"
+#endif
 
 #include <cstring>
 #include <esp_log.h>
@@ -19,24 +34,103 @@
 
 #define TAG "Application"
 
+#if CONFIG_AUDIO_SEND_QUEUE_DROP_OLDEST
+#define AUDIO_SEND_QUEUE_POLICY kAudioSendQueueDropOldest
+#elif CONFIG_AUDIO_SEND_QUEUE_PAUSE_CAPTURE
+#define AUDIO_SEND_QUEUE_POLICY kAudioSendQueuePauseCapture
+#else
+#define AUDIO_SEND_QUEUE_POLICY kAudioSendQueueDropSilence
+#endif
 
-static const char* const STATE_STRINGS[] = {
-    "unknown",
-    "starting",
-    "configuring",
-    "idle",
-    "connecting",
-    "listening",
-    "speaking",
-    "upgrading",
-    "activating",
-    "fatal_error",
-    "invalid_state"
+#define STATE_BIT(state) (1 << (state))
+
+// 没有正在进行的音频通道连接
+#define AUDIO_CHANNEL_IDLE_EVENT (1 << 0)
+
+// 进入状态时执行的动作，涉及编解码器的动作放到对应的后台 lane 上执行，不阻塞主循环
+enum DeviceStateAction : uint16_t {
+    kStateActionClearChatMessage = 1 << 0,
+    kStateActionResetDecoder = 1 << 1,      // 丢弃待播放的音频，已提交的解码任务完成后重置解码器
+    kStateActionResetEncoder = 1 << 2,      // 已提交的编码任务完成后重置编码器
+    kStateActionClearSendQueue = 1 << 3,    // 已提交的编码任务完成后清空上行队列
+    kStateActionEnableOutput = 1 << 4,
+    kStateActionStartProcessor = 1 << 5,
+    kStateActionStopProcessor = 1 << 6,
+    kStateActionStartWakeWord = 1 << 7,
+    kStateActionStopWakeWord = 1 << 8,
+    kStateActionSendIotStates = 1 << 9,
+    kStateActionEndTurn = 1 << 10,          // 一轮对话结束，输出临时缓冲区的用量和内存碎片情况
+    kStateActionLowRefresh = 1 << 11,       // 音频处理期间降低界面刷新率
+    kStateActionBeginTurn = 1 << 12,        // 离开空闲状态，记录对话开始前的内存碎片情况
 };
 
-Application::Application() {
-    event_group_ = xEventGroupCreate();
-    background_task_ = new BackgroundTask(4096 * 8);
+struct DeviceStateInfo {
+    const char* name;
+    uint16_t next_states;   // 允许切换到的状态
+    uint16_t actions;       // 进入状态时执行的动作
+    const char* status;     // 进入状态时显示的状态文字，为空则不修改
+    const char* emotion;
+};
+
+// 按 DeviceState 的顺序排列
+static const DeviceStateInfo kDeviceStates[] = {
+    {"unknown", STATE_BIT(kDeviceStateStarting), 0, nullptr, nullptr},
+    {"starting",
+        STATE_BIT(kDeviceStateWifiConfiguring) | STATE_BIT(kDeviceStateIdle) | STATE_BIT(kDeviceStateActivating) |
+        STATE_BIT(kDeviceStateUpgrading) | STATE_BIT(kDeviceStateFatalError),
+        0, nullptr, nullptr},
+    {"configuring", STATE_BIT(kDeviceStateIdle) | STATE_BIT(kDeviceStateFatalError), 0, nullptr, nullptr},
+    {"idle",
+        STATE_BIT(kDeviceStateConnecting) | STATE_BIT(kDeviceStateListening) | STATE_BIT(kDeviceStateSpeaking) |
+        STATE_BIT(kDeviceStateActivating) | STATE_BIT(kDeviceStateUpgrading) | STATE_BIT(kDeviceStateWifiConfiguring) |
+        STATE_BIT(kDeviceStateFatalError),
+        kStateActionClearSendQueue | kStateActionStopProcessor | kStateActionStartWakeWord | kStateActionEndTurn,
+        Lang::Strings::STANDBY, "neutral"},
+    {"connecting",
+        STATE_BIT(kDeviceStateIdle) | STATE_BIT(kDeviceStateListening) | STATE_BIT(kDeviceStateFatalError),
+        kStateActionClearChatMessage | kStateActionBeginTurn,
+        Lang::Strings::CONNECTING, "neutral"},
+    {"listening",
+        STATE_BIT(kDeviceStateIdle) | STATE_BIT(kDeviceStateSpeaking) | STATE_BIT(kDeviceStateFatalError),
+        kStateActionResetDecoder | kStateActionResetEncoder | kStateActionStartProcessor | kStateActionStopWakeWord |
+        kStateActionSendIotStates | kStateActionLowRefresh | kStateActionBeginTurn,
+        Lang::Strings::LISTENING, "neutral"},
+    {"speaking",
+        STATE_BIT(kDeviceStateIdle) | STATE_BIT(kDeviceStateListening) | STATE_BIT(kDeviceStateFatalError),
+        kStateActionResetDecoder | kStateActionEnableOutput | kStateActionStopProcessor | kStateActionStartWakeWord |
+        kStateActionLowRefresh | kStateActionBeginTurn,
+        Lang::Strings::SPEAKING, nullptr},
+    {"upgrading", STATE_BIT(kDeviceStateFatalError), 0, nullptr, nullptr},
+    {"activating",
+        STATE_BIT(kDeviceStateIdle) | STATE_BIT(kDeviceStateUpgrading) | STATE_BIT(kDeviceStateFatalError),
+        0, nullptr, nullptr},
+    {"fatal_error", 0, 0, nullptr, nullptr},
+};
+static_assert(sizeof(kDeviceStates) / sizeof(kDeviceStates[0]) == kDeviceStateFatalError + 1,
+    "kDeviceStates must cover every DeviceState");
+
+Application::Application()
+    : audio_send_queue_(CONFIG_AUDIO_SEND_QUEUE_MAX_BYTES, AUDIO_SEND_QUEUE_POLICY) {
+    event_group_ = MemoryPlan::GetInstance().CreateEventGroup();
+    audio_channel_event_.Set(AUDIO_CHANNEL_IDLE_EVENT);
+    // 只注册一次，之后直接使用返回的指针，不必每次按名字查找
+    auto& metrics = Metrics::GetInstance();
+    // 单位微秒，60ms 一帧，超过 60ms 说明编解码跟不上实时
+    encode_time_ = metrics.RegisterHistogram("encode_us", {2000, 5000, 10000, 20000, 40000, 60000});
+    decode_time_ = metrics.RegisterHistogram("decode_us", {2000, 5000, 10000, 20000, 40000, 60000});
+    network_errors_ = metrics.RegisterCounter("network_errors");
+    main_tasks_peak_ = metrics.RegisterGauge("main_tasks_peak");
+    main_tasks_latency_max_ = metrics.RegisterGauge("main_tasks_latency_max_us");
+    send_queue_bytes_ = metrics.RegisterGauge("send_queue_bytes");
+    send_queue_peak_bytes_ = metrics.RegisterGauge("send_queue_peak_bytes");
+    send_dropped_packets_ = metrics.RegisterGauge("send_dropped_packets");
+    decode_queue_ = metrics.RegisterGauge("decode_queue");
+    background_task_ = new BackgroundTask(BACKGROUND_TASK_STACK_SIZE, CONFIG_BACKGROUND_TASK_WORKERS);
+#if CONFIG_USE_STATIC_ALLOCATION
+    // 按 48kHz 预留解码缓冲区，之后播放时不再扩容
+    decode_pcm_.reserve(48000 * OPUS_MAX_FRAME_MS / 1000);
+    decode_resampled_.reserve(48000 * 60 / 1000);
+#endif
 
     esp_timer_create_args_t clock_timer_args = {
         .callback = [](void* arg) {
@@ -59,10 +153,24 @@ Application::~Application() {
     if (background_task_ != nullptr) {
         delete background_task_;
     }
+    if (opus_decoder_ != nullptr) {
+        opus_decoder_destroy(opus_decoder_);
+    }
     vEventGroupDelete(event_group_);
 }
 
-void Application::CheckNewVersion() {
+// 单声道解码器，失败时返回 nullptr，解码任务跳过数据包
+static OpusDecoder* CreateOpusDecoder(int sample_rate) {
+    int error = OPUS_OK;
+    OpusDecoder* decoder = opus_decoder_create(sample_rate, 1, &error);
+    if (decoder == nullptr) {
+        ESP_LOGE(TAG, "Failed to create opus decoder at %d Hz: %s", sample_rate, opus_strerror(error));
+    }
+    return decoder;
+}
+
+// 在主循环中运行的协程，HTTP 请求放到阻塞调用任务中，重试和等待都不占用单独的任务栈
+CoTask<void> Application::CheckNewVersion() {
     auto& board = Board::GetInstance();
     auto display = board.GetDisplay();
     // Check if there is a new firmware version available
@@ -70,67 +178,32 @@ void Application::CheckNewVersion() {
 
     const int MAX_RETRY = 10;
     int retry_count = 0;
+    bool activation_shown = false;
 
     while (true) {
-        if (!ota_.CheckVersion()) {
+        bool success = co_await CoRunBlocking([this]() {
+            return ota_.CheckVersion();
+        });
+        if (!success) {
             retry_count++;
             if (retry_count >= MAX_RETRY) {
                 ESP_LOGE(TAG, "Too many retries, exit version check");
-                return;
+                co_return;
             }
             ESP_LOGW(TAG, "Check new version failed, retry in %d seconds (%d/%d)", 60, retry_count, MAX_RETRY);
-            vTaskDelay(pdMS_TO_TICKS(60000));
+            co_await CoDelay(60000);
             continue;
         }
         retry_count = 0;
 
         if (ota_.HasNewVersion()) {
             Alert(Lang::Strings::OTA_UPGRADE, Lang::Strings::UPGRADING, "happy", Lang::Sounds::P3_UPGRADE);
-            // Wait for the chat state to be idle
-            do {
-                vTaskDelay(pdMS_TO_TICKS(3000));
-            } while (GetDeviceState() != kDeviceStateIdle);
-
-            // Use main task to do the upgrade, not cancelable
-            Schedule([this, display]() {
-                SetDeviceState(kDeviceStateUpgrading);
-                
-                display->SetIcon(FONT_AWESOME_DOWNLOAD);
-                std::string message = std::string(Lang::Strings::NEW_VERSION) + ota_.GetFirmwareVersion();
-                display->SetChatMessage("system", message.c_str());
-
-                auto& board = Board::GetInstance();
-                board.SetPowerSaveMode(false);
-#if CONFIG_USE_WAKE_WORD_DETECT
-                wake_word_detect_.StopDetection();
-#endif
-                // 预先关闭音频输出，避免升级过程有音频操作
-                auto codec = board.GetAudioCodec();
-                codec->EnableInput(false);
-                codec->EnableOutput(false);
-                {
-                    std::lock_guard<std::mutex> lock(mutex_);
-                    audio_decode_queue_.clear();
-                }
-                background_task_->WaitForCompletion();
-                delete background_task_;
-                background_task_ = nullptr;
-                vTaskDelay(pdMS_TO_TICKS(1000));
-
-                ota_.StartUpgrade([display](int progress, size_t speed) {
-                    char buffer[64];
-                    snprintf(buffer, sizeof(buffer), "%d%% %zuKB/s", progress, speed / 1024);
-                    display->SetChatMessage("system", buffer);
-                });
-
-                // If upgrade success, the device will reboot and never reach here
-                display->SetStatus(Lang::Strings::UPGRADE_FAILED);
-                ESP_LOGI(TAG, "Firmware upgrade failed...");
-                vTaskDelay(pdMS_TO_TICKS(3000));
-                Reboot();
-            });
-
-            return;
+            // 不轮询设备状态，设备空闲时由 SetDeviceState 开始升级
+            upgrade_pending_ = true;
+            if (device_state_ == kDeviceStateIdle) {
+                StartUpgrade();
+            }
+            co_return;
         }
 
         // No new version, mark the current version as valid
@@ -140,28 +213,82 @@ void Application::CheckNewVersion() {
     
         if (ota_.HasActivationCode()) {
             // Activation code is valid
-            SetDeviceState(kDeviceStateActivating);
-            ShowActivationCode();
+            // Start 已经进入空闲状态，检查期间可能开始了对话，只在空闲时显示激活码
+            if (device_state_ == kDeviceStateIdle) {
+                SetDeviceState(kDeviceStateActivating);
+                activation_shown = true;
+                co_await ShowActivationCode();
+            }
 
             // Check again in 60 seconds or until the device is idle
             for (int i = 0; i < 60; ++i) {
                 if (device_state_ == kDeviceStateIdle) {
                     break;
                 }
-                vTaskDelay(pdMS_TO_TICKS(1000));
+                co_await CoDelay(1000);
             }
             continue;
         }
 
-        SetDeviceState(kDeviceStateIdle);
-        display->SetChatMessage("system", "");
-        PlaySound(Lang::Sounds::P3_SUCCESS);
+        // 只有显示过激活码时才回到空闲状态，不打断检查期间开始的对话
+        if (activation_shown) {
+            if (device_state_ == kDeviceStateActivating) {
+                SetDeviceState(kDeviceStateIdle);
+            }
+            display->SetChatMessage("system", "");
+            PlaySound(Lang::Sounds::P3_SUCCESS);
+        }
         // Exit the loop if upgrade or idle
         break;
     }
 }
 
-void Application::ShowActivationCode() {
+// Use main task to do the upgrade, not cancelable
+void Application::StartUpgrade() {
+    upgrade_pending_ = false;
+    SetDeviceState(kDeviceStateUpgrading);
+
+    auto& board = Board::GetInstance();
+    auto display = board.GetDisplay();
+    {
+        DisplayTransaction transaction(display);
+        display->SetIcon(FONT_AWESOME_DOWNLOAD);
+        std::string message = std::string(Lang::Strings::NEW_VERSION) + ota_.GetFirmwareVersion();
+        display->SetChatMessage("system", message.c_str());
+    }
+
+    board.SetPowerSaveMode(false);
+#if CONFIG_USE_WAKE_WORD_DETECT
+    wake_word_detect_.StopDetection();
+#endif
+    // 预先关闭音频输出，避免升级过程有音频操作
+    auto codec = board.GetAudioCodec();
+    codec->EnableInput(false);
+    codec->EnableOutput(false);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        audio_decode_queue_.clear();
+    }
+    audio_send_queue_.Clear();
+    background_task_->WaitForCompletion();
+    delete background_task_;
+    background_task_ = nullptr;
+    vTaskDelay(pdMS_TO_TICKS(1000));
+
+    ota_.StartUpgrade([display](int progress, size_t speed) {
+        char buffer[64];
+        snprintf(buffer, sizeof(buffer), "%d%% %zuKB/s", progress, speed / 1024);
+        display->SetChatMessage("system", buffer);
+    });
+
+    // If upgrade success, the device will reboot and never reach here
+    display->SetStatus(Lang::Strings::UPGRADE_FAILED);
+    ESP_LOGI(TAG, "Firmware upgrade failed...");
+    vTaskDelay(pdMS_TO_TICKS(3000));
+    Reboot();
+}
+
+CoTask<void> Application::ShowActivationCode() {
     auto& message = ota_.GetActivationMessage();
     auto& code = ota_.GetActivationCode();
 
@@ -184,8 +311,8 @@ void Application::ShowActivationCode() {
 
     // This sentence uses 9KB of SRAM, so we need to wait for it to finish
     Alert(Lang::Strings::ACTIVATION, message.c_str(), "happy", Lang::Sounds::P3_ACTIVATION);
-    vTaskDelay(pdMS_TO_TICKS(1000));
-    background_task_->WaitForCompletion();
+    co_await CoDelay(1000);
+    co_await CoWaitForLane(background_task_, kBackgroundLaneDecode);
 
     for (const auto& digit : code) {
         auto it = std::find_if(digit_sounds.begin(), digit_sounds.end(),
@@ -199,9 +326,12 @@ void Application::ShowActivationCode() {
 void Application::Alert(const char* status, const char* message, const char* emotion, const std::string_view& sound) {
     ESP_LOGW(TAG, "Alert %s: %s [%s]", status, message, emotion);
     auto display = Board::GetInstance().GetDisplay();
-    display->SetStatus(status);
-    display->SetEmotion(emotion);
-    display->SetChatMessage("system", message);
+    {
+        DisplayTransaction transaction(display);
+        display->SetStatus(status);
+        display->SetEmotion(emotion);
+        display->SetChatMessage("system", message);
+    }
     if (!sound.empty()) {
         PlaySound(sound);
     }
@@ -210,6 +340,7 @@ void Application::Alert(const char* status, const char* message, const char* emo
 void Application::DismissAlert() {
     if (device_state_ == kDeviceStateIdle) {
         auto display = Board::GetInstance().GetDisplay();
+        DisplayTransaction transaction(display);
         display->SetStatus(Lang::Strings::STANDBY);
         display->SetEmotion("neutral");
         display->SetChatMessage("system", "");
@@ -227,9 +358,7 @@ void Application::PlaySound(const std::string_view& sound) {
         p += sizeof(BinaryProtocol3);
 
         auto payload_size = ntohs(p3->payload_size);
-        std::vector<uint8_t> opus;
-        opus.resize(payload_size);
-        memcpy(opus.data(), p3->payload, payload_size);
+        TurnVector<uint8_t> opus(p3->payload, p3->payload + payload_size);
         p += payload_size;
 
         std::lock_guard<std::mutex> lock(mutex_);
@@ -238,8 +367,13 @@ void Application::PlaySound(const std::string_view& sound) {
 }
 
 void Application::ToggleChatState() {
+#if CONFIG_USE_SESSION_RECORDER
+    SessionRecorder::GetInstance().Record(kSessionEventCommand, "toggle");
+#endif
     if (device_state_ == kDeviceStateActivating) {
-        SetDeviceState(kDeviceStateIdle);
+        Schedule([this]() {
+            SetDeviceState(kDeviceStateIdle);
+        });
         return;
     }
 
@@ -250,14 +384,15 @@ void Application::ToggleChatState() {
 
     if (device_state_ == kDeviceStateIdle) {
         Schedule([this]() {
-            SetDeviceState(kDeviceStateConnecting);
-            if (!protocol_->OpenAudioChannel()) {
-                return;
-            }
-
-            keep_listening_ = true;
-            protocol_->SendStartListening(kListeningModeAutoStop);
-            SetDeviceState(kDeviceStateListening);
+            ConnectAudioChannel([this]() {
+                keep_listening_ = true;
+                protocol_->SendStartListening(kListeningModeAutoStop);
+                SetDeviceState(kDeviceStateListening);
+            });
+        });
+    } else if (device_state_ == kDeviceStateConnecting) {
+        Schedule([this]() {
+            CancelConnecting();
         });
     } else if (device_state_ == kDeviceStateSpeaking) {
         Schedule([this]() {
@@ -265,14 +400,22 @@ void Application::ToggleChatState() {
         });
     } else if (device_state_ == kDeviceStateListening) {
         Schedule([this]() {
-            protocol_->CloseAudioChannel();
+            // 排队期间状态可能已经改变，例如开始了新的连接
+            if (device_state_ == kDeviceStateListening) {
+                protocol_->CloseAudioChannel();
+            }
         });
     }
 }
 
 void Application::StartListening() {
+#if CONFIG_USE_SESSION_RECORDER
+    SessionRecorder::GetInstance().Record(kSessionEventCommand, "start");
+#endif
     if (device_state_ == kDeviceStateActivating) {
-        SetDeviceState(kDeviceStateIdle);
+        Schedule([this]() {
+            SetDeviceState(kDeviceStateIdle);
+        });
         return;
     }
 
@@ -284,14 +427,15 @@ void Application::StartListening() {
     keep_listening_ = false;
     if (device_state_ == kDeviceStateIdle) {
         Schedule([this]() {
-            if (!protocol_->IsAudioChannelOpened()) {
-                SetDeviceState(kDeviceStateConnecting);
-                if (!protocol_->OpenAudioChannel()) {
-                    return;
-                }
+            auto start_listening = [this]() {
+                protocol_->SendStartListening(kListeningModeManualStop);
+                SetDeviceState(kDeviceStateListening);
+            };
+            if (protocol_->IsAudioChannelOpened()) {
+                start_listening();
+            } else {
+                ConnectAudioChannel(start_listening);
             }
-            protocol_->SendStartListening(kListeningModeManualStop);
-            SetDeviceState(kDeviceStateListening);
         });
     } else if (device_state_ == kDeviceStateSpeaking) {
         Schedule([this]() {
@@ -303,14 +447,63 @@ void Application::StartListening() {
 }
 
 void Application::StopListening() {
+#if CONFIG_USE_SESSION_RECORDER
+    SessionRecorder::GetInstance().Record(kSessionEventCommand, "stop");
+#endif
     Schedule([this]() {
         if (device_state_ == kDeviceStateListening) {
             protocol_->SendStopListening();
             SetDeviceState(kDeviceStateIdle);
+        } else if (device_state_ == kDeviceStateConnecting) {
+            // 连接完成前就松开了按键，还没有录到声音，直接取消
+            CancelConnecting();
         }
     });
 }
 
+// 打开音频通道，成功后执行 on_opened
+// 连接期间主循环不阻塞，按键等输入可以随时通过 CancelConnecting 取消
+void Application::ConnectAudioChannel(std::function<void()> on_opened) {
+    SetDeviceState(kDeviceStateConnecting);
+    CoSpawn(OpenAudioChannel(++connect_generation_, std::move(on_opened)));
+}
+
+CoTask<void> Application::OpenAudioChannel(uint32_t generation, std::function<void()> on_opened) {
+    // 上一次（已经取消的）连接还没有结束时先等它完成，同一时间只有一个连接在进行
+    while (!(audio_channel_event_.Get() & AUDIO_CHANNEL_IDLE_EVENT)) {
+        co_await audio_channel_event_.Wait(AUDIO_CHANNEL_IDLE_EVENT);
+    }
+    if (generation != connect_generation_) {
+        co_return;
+    }
+
+    audio_channel_event_.Clear(AUDIO_CHANNEL_IDLE_EVENT);
+    bool success = co_await protocol_->OpenAudioChannel();
+    audio_channel_event_.Set(AUDIO_CHANNEL_IDLE_EVENT);
+
+    if (generation != connect_generation_ || device_state_ != kDeviceStateConnecting) {
+        // 连接过程中被取消，或者网络错误已经切回空闲状态
+        if (success) {
+            protocol_->CloseAudioChannel();
+        }
+        co_return;
+    }
+    if (!success) {
+        SetDeviceState(kDeviceStateIdle);
+        co_return;
+    }
+    on_opened();
+}
+
+void Application::CancelConnecting() {
+    if (device_state_ != kDeviceStateConnecting) {
+        return;
+    }
+    ESP_LOGI(TAG, "Connecting cancelled");
+    connect_generation_++;
+    SetDeviceState(kDeviceStateIdle);
+}
+
 void Application::Start() {
     auto& board = Board::GetInstance();
     SetDeviceState(kDeviceStateStarting);
@@ -321,17 +514,25 @@ void Application::Start() {
     /* Setup the audio codec */
     auto codec = board.GetAudioCodec();
     opus_decode_sample_rate_ = codec->output_sample_rate();
-    opus_decoder_ = std::make_unique<OpusDecoderWrapper>(opus_decode_sample_rate_, 1);
+    opus_decoder_ = CreateOpusDecoder(opus_decode_sample_rate_);
     opus_encoder_ = std::make_unique<OpusEncoderWrapper>(16000, 1, OPUS_FRAME_DURATION_MS);
     // For ML307 boards, we use complexity 5 to save bandwidth
     // For other boards, we use complexity 3 to save CPU
     if (board.GetBoardType() == "ml307") {
         ESP_LOGI(TAG, "ML307 board detected, setting opus encoder complexity to 5");
-        opus_encoder_->SetComplexity(5);
+        opus_encode_complexity_ = 5;
     } else {
         ESP_LOGI(TAG, "WiFi board detected, setting opus encoder complexity to 3");
-        opus_encoder_->SetComplexity(3);
+        opus_encode_complexity_ = 3;
     }
+    opus_encoder_->SetComplexity(opus_encode_complexity_);
+
+    // 上行拥塞时降低编码复杂度，减少后台编码任务的积压
+    audio_send_queue_.OnCongestionChange([this](bool congested) {
+        background_task_->Schedule([this, congested]() {
+            opus_encoder_->SetComplexity(congested ? 0 : opus_encode_complexity_);
+        }, kBackgroundLaneEncode);
+    });
 
     if (codec->input_sample_rate() != 16000) {
         input_resampler_.Configure(codec->input_sample_rate(), 16000);
@@ -347,36 +548,55 @@ void Application::Start() {
         xEventGroupSetBitsFromISR(event_group_, AUDIO_OUTPUT_READY_EVENT, &higher_priority_task_woken);
         return higher_priority_task_woken == pdTRUE;
     });
+#if CONFIG_SESSION_RECORDER_AUTO_START
+    SessionRecorder::GetInstance().Start(codec->input_sample_rate(), codec->input_channels(), codec->output_sample_rate());
+#endif
+#if CONFIG_TRACER_AUTO_START
+    Tracer::GetInstance().Start();
+#endif
     codec->Start();
 
     /* Start the main loop */
-    xTaskCreate([](void* arg) {
+    MemoryPlan::GetInstance().CreateTask([](void* arg) {
         Application* app = (Application*)arg;
         app->MainLoop();
         vTaskDelete(NULL);
-    }, "main_loop", 4096 * 2, this, 4, nullptr);
+    }, "main_loop", MAIN_LOOP_STACK_SIZE, this, 4);
 
     /* Wait for the network to be ready */
     board.StartNetwork();
 
     // Initialize the protocol
     display->SetStatus(Lang::Strings::LOADING_PROTOCOL);
+    protocol_.reset(board.CreateProtocol());
+    if (!protocol_) {
 #ifdef CONFIG_CONNECTION_TYPE_WEBSOCKET
-    protocol_ = std::make_unique<WebsocketProtocol>();
+        protocol_ = std::make_unique<WebsocketProtocol>();
 #else
-    protocol_ = std::make_unique<MqttProtocol>();
+        protocol_ = std::make_unique<MqttProtocol>();
 #endif
+    }
     protocol_->OnNetworkError([this](const std::string& message) {
-        SetDeviceState(kDeviceStateIdle);
-        Alert(Lang::Strings::ERROR, message.c_str(), "sad", Lang::Sounds::P3_EXCLAMATION);
+        network_errors_->Add();
+        Schedule([this, message]() {
+            SetDeviceState(kDeviceStateIdle);
+            Alert(Lang::Strings::ERROR, message.c_str(), "sad", Lang::Sounds::P3_EXCLAMATION);
+        });
     });
     protocol_->OnIncomingAudio([this](std::vector<uint8_t>&& data) {
+#if CONFIG_USE_SESSION_RECORDER
+        SessionRecorder::GetInstance().Record(kSessionEventIncomingAudio, data.data(), data.size());
+#endif
         std::lock_guard<std::mutex> lock(mutex_);
         if (device_state_ == kDeviceStateSpeaking) {
-            audio_decode_queue_.emplace_back(std::move(data));
+            audio_decode_queue_.emplace_back(data.begin(), data.end());
         }
     });
     protocol_->OnAudioChannelOpened([this, codec, &board]() {
+#if CONFIG_USE_SESSION_RECORDER
+        uint32_t server_sample_rate = protocol_->server_sample_rate();
+        SessionRecorder::GetInstance().Record(kSessionEventChannelOpened, &server_sample_rate, sizeof(server_sample_rate));
+#endif
         board.SetPowerSaveMode(false);
         if (protocol_->server_sample_rate() != codec->output_sample_rate()) {
             ESP_LOGW(TAG, "Server sample rate %d does not match device output sample rate %d, resampling may cause distortion",
@@ -389,16 +609,32 @@ void Application::Start() {
         if (thing_manager.GetStatesJson(states, false)) {
             protocol_->SendIotStates(states);
         }
+        ReportMetrics();
     });
     protocol_->OnAudioChannelClosed([this, &board]() {
+#if CONFIG_USE_SESSION_RECORDER
+        SessionRecorder::GetInstance().Record(kSessionEventChannelClosed, nullptr, 0);
+#endif
         board.SetPowerSaveMode(true);
         Schedule([this]() {
+            // 连接中收到的关闭事件来自已经取消的上一次连接
+            if (device_state_ == kDeviceStateConnecting) {
+                return;
+            }
             auto display = Board::GetInstance().GetDisplay();
             display->SetChatMessage("system", "");
             SetDeviceState(kDeviceStateIdle);
         });
     });
     protocol_->OnIncomingJson([this, display](const cJSON* root) {
+#if CONFIG_USE_SESSION_RECORDER
+        auto& recorder = SessionRecorder::GetInstance();
+        if (recorder.IsRecording()) {
+            auto json = cJSON_PrintUnformatted(root);
+            recorder.Record(kSessionEventIncomingJson, json, strlen(json));
+            cJSON_free(json);
+        }
+#endif
         // Parse JSON data
         auto type = cJSON_GetObjectItem(root, "type");
         if (strcmp(type->valuestring, "tts") == 0) {
@@ -413,22 +649,28 @@ void Application::Start() {
             } else if (strcmp(state->valuestring, "stop") == 0) {
                 Schedule([this]() {
                     if (device_state_ == kDeviceStateSpeaking) {
-                        background_task_->WaitForCompletion();
-                        if (keep_listening_) {
-                            protocol_->SendStartListening(kListeningModeAutoStop);
-                            SetDeviceState(kDeviceStateListening);
-                        } else {
-                            SetDeviceState(kDeviceStateIdle);
-                        }
+                        CoSpawn(FinishSpeaking());
                     }
                 });
             } else if (strcmp(state->valuestring, "sentence_start") == 0) {
                 auto text = cJSON_GetObjectItem(root, "text");
                 if (text != NULL) {
                     ESP_LOGI(TAG, "<< %s", text->valuestring);
+#if CONFIG_USE_STREAMING_TEXT
+                    // 这句话的音频排在解码队列中已有的帧之后
+                    uint32_t start_ms;
+                    {
+                        std::lock_guard<std::mutex> lock(mutex_);
+                        start_ms = (output_frames_ + audio_decode_queue_.size()) * OPUS_FRAME_DURATION_MS;
+                    }
+                    Schedule([this, display, message = std::string(text->valuestring), start_ms]() {
+                        display->AppendChatMessage(message.c_str(), start_ms);
+                    });
+#else
                     Schedule([this, display, message = std::string(text->valuestring)]() {
                         display->SetChatMessage("assistant", message.c_str());
                     });
+#endif
                 }
             }
         } else if (strcmp(type->valuestring, "stt") == 0) {
@@ -467,22 +709,14 @@ void Application::Start() {
     auto app_desc = esp_app_get_description();
     ota_.SetHeader("User-Agent", std::string(BOARD_NAME "/") + app_desc->version);
 
-    // xTaskCreate([](void* arg) {
-    //     Application* app = (Application*)arg;
-    //     app->CheckNewVersion();
-    //     vTaskDelete(NULL);
-    // }, "check_new_version", 4096 * 2, this, 2, nullptr);
+    // Schedule([this]() {
+    //     CoSpawn(CheckNewVersion());
+    // });
 
 #if CONFIG_USE_AUDIO_PROCESSOR
     audio_processor_.Initialize(codec->input_channels(), codec->input_reference());
     audio_processor_.OnOutput([this](std::vector<int16_t>&& data) {
-        background_task_->Schedule([this, data = std::move(data)]() mutable {
-            opus_encoder_->Encode(std::move(data), [this](std::vector<uint8_t>&& opus) {
-                Schedule([this, opus = std::move(opus)]() {
-                    protocol_->SendAudio(opus);
-                });
-            });
-        });
+        EncodeAudio(std::move(data));
     });
     audio_processor_.OnVadStateChange([this](bool speaking) {
         if (device_state_ == kDeviceStateListening) {
@@ -502,26 +736,27 @@ void Application::Start() {
 #if CONFIG_USE_WAKE_WORD_DETECT
     wake_word_detect_.Initialize(codec->input_channels(), codec->input_reference());
     wake_word_detect_.OnWakeWordDetected([this](const std::string& wake_word) {
-        Schedule([this, &wake_word]() {
+#if CONFIG_USE_SESSION_RECORDER
+        SessionRecorder::GetInstance().Record(kSessionEventCommand, "wake " + wake_word);
+#endif
+        Schedule([this, wake_word]() {
             if (device_state_ == kDeviceStateIdle) {
-                SetDeviceState(kDeviceStateConnecting);
                 wake_word_detect_.EncodeWakeWordData();
-
-                if (!protocol_->OpenAudioChannel()) {
-                    wake_word_detect_.StartDetection();
-                    return;
-                }
-                
-                std::vector<uint8_t> opus;
-                // Encode and send the wake word data to the server
-                while (wake_word_detect_.GetWakeWordOpus(opus)) {
-                    protocol_->SendAudio(opus);
-                }
-                // Set the chat state to wake word detected
-                protocol_->SendWakeWordDetected(wake_word);
-                ESP_LOGI(TAG, "Wake word detected: %s", wake_word.c_str());
-                keep_listening_ = true;
-                SetDeviceState(kDeviceStateIdle);
+                // 连接失败或被取消时回到空闲状态，会重新开始唤醒词检测
+                ConnectAudioChannel([this, wake_word]() {
+                    std::vector<uint8_t> opus;
+                    // Encode and send the wake word data to the server
+                    while (wake_word_detect_.GetWakeWordOpus(opus)) {
+                        protocol_->SendAudio(opus);
+                    }
+                    // Set the chat state to wake word detected
+                    protocol_->SendWakeWordDetected(wake_word);
+                    ESP_LOGI(TAG, "Wake word detected: %s", wake_word.c_str());
+                    keep_listening_ = true;
+                    SetDeviceState(kDeviceStateIdle);
+                });
+            } else if (device_state_ == kDeviceStateConnecting) {
+                ESP_LOGI(TAG, "Wake word detected while connecting, ignored");
             } else if (device_state_ == kDeviceStateSpeaking) {
                 AbortSpeaking(kAbortReasonWakeWordDetected);
             } else if (device_state_ == kDeviceStateActivating) {
@@ -534,10 +769,42 @@ void Application::Start() {
 
     SetDeviceState(kDeviceStateIdle);
     esp_timer_start_periodic(clock_timer_handle_, 1000000);
+
+#if CONFIG_USE_AUDIO_BENCHMARK
+    AudioBenchmark::RegisterConsoleCommand();
+#endif
+#if CONFIG_USE_SESSION_RECORDER
+    SessionRecorder::GetInstance().RegisterConsoleCommand();
+#endif
+#if CONFIG_USE_TRACER
+    Tracer::GetInstance().RegisterConsoleCommand();
+#endif
+    Metrics::GetInstance().RegisterConsoleCommand();
+#if CONFIG_USE_STACK_PROFILER
+    StackProfiler::GetInstance().RegisterConsoleCommand();
+#endif
+#if CONFIG_USE_STALL_DETECTOR
+    StallDetector::GetInstance().RegisterConsoleCommand();
+#endif
+    Console::GetInstance().Start();
 }
 
 void Application::OnClockTimer() {
     clock_ticks_++;
+    TRACE_COUNTER("free_sram", heap_caps_get_free_size(MALLOC_CAP_INTERNAL));
+#if CONFIG_USE_STACK_PROFILER
+    StackProfiler::GetInstance().Sample();
+#endif
+
+#if CONFIG_METRICS_REPORT_INTERVAL > 0
+    // 音频通道没有打开时保留到下次打开通道时上报
+    if (clock_ticks_ % CONFIG_METRICS_REPORT_INTERVAL == 0) {
+        Schedule([this]() {
+            metrics_report_due_ = true;
+            ReportMetrics();
+        });
+    }
+#endif
 
     // Print the debug info every 10 seconds
     if (clock_ticks_ % 10 == 0) {
@@ -546,6 +813,24 @@ void Application::OnClockTimer() {
         int min_free_sram = heap_caps_get_minimum_free_size(MALLOC_CAP_INTERNAL);
         ESP_LOGI(TAG, "Free internal: %u minimal internal: %u", free_sram, min_free_sram);
 
+        auto task_stats = main_tasks_.GetStats();
+        if (task_stats.overflows > 0 || task_stats.heap_allocations > 0) {
+            ESP_LOGW(TAG, "Main tasks: executed %lu overflows %lu heap %lu peak %lu, latency avg %lld max %lld us",
+                (unsigned long)task_stats.executed, (unsigned long)task_stats.overflows,
+                (unsigned long)task_stats.heap_allocations, (unsigned long)task_stats.peak_depth,
+                (long long)(task_stats.executed > 0 ? task_stats.total_latency_us / task_stats.executed : 0),
+                (long long)task_stats.max_latency_us);
+        }
+
+        auto send_stats = audio_send_queue_.GetStats();
+        if (send_stats.dropped_packets > 0 || send_stats.paused_frames > 0) {
+            ESP_LOGW(TAG, "Upstream audio: sent %lu dropped %lu (%lu bytes) paused %lu peak %zu bytes",
+                (unsigned long)send_stats.sent_packets, (unsigned long)send_stats.dropped_packets,
+                (unsigned long)send_stats.dropped_bytes, (unsigned long)send_stats.paused_frames, send_stats.peak_bytes);
+        }
+
+        CollectMetrics();
+
         // If we have synchronized server time, set the status to clock "HH:MM" if the device is idle
         if (ota_.HasServerTime()) {
             if (device_state_ == kDeviceStateIdle) {
@@ -561,12 +846,27 @@ void Application::OnClockTimer() {
     }
 }
 
-void Application::Schedule(std::function<void()> callback) {
-    {
-        std::lock_guard<std::mutex> lock(mutex_);
-        main_tasks_.push_back(std::move(callback));
+void Application::CollectMetrics() {
+    Metrics::GetInstance().CollectSystemMetrics();
+
+    auto task_stats = main_tasks_.GetStats();
+    main_tasks_peak_->Set(task_stats.peak_depth);
+    main_tasks_latency_max_->Set(task_stats.max_latency_us);
+    auto send_stats = audio_send_queue_.GetStats();
+    send_queue_bytes_->Set(send_stats.queued_bytes);
+    send_queue_peak_bytes_->Set(send_stats.peak_bytes);
+    send_dropped_packets_->Set(send_stats.dropped_packets);
+    std::lock_guard<std::mutex> lock(mutex_);
+    decode_queue_->Set(audio_decode_queue_.size());
+}
+
+// 在主循环中调用，音频通道打开时才上报
+void Application::ReportMetrics() {
+    if (!metrics_report_due_ || !protocol_ || !protocol_->IsAudioChannelOpened()) {
+        return;
     }
-    xEventGroupSetBits(event_group_, SCHEDULE_EVENT);
+    metrics_report_due_ = false;
+    protocol_->SendMetrics(Metrics::GetInstance().ToJson(true));
 }
 
 // The Main Loop controls the chat state and websocket connection
@@ -575,31 +875,40 @@ void Application::Schedule(std::function<void()> callback) {
 void Application::MainLoop() {
     while (true) {
         auto bits = xEventGroupWaitBits(event_group_,
-            SCHEDULE_EVENT | AUDIO_INPUT_READY_EVENT | AUDIO_OUTPUT_READY_EVENT,
+            SCHEDULE_EVENT | AUDIO_INPUT_READY_EVENT | AUDIO_OUTPUT_READY_EVENT | AUDIO_SEND_READY_EVENT,
             pdTRUE, pdFALSE, portMAX_DELAY);
 
         if (bits & AUDIO_INPUT_READY_EVENT) {
+            TRACE_SCOPE("input_audio");
             InputAudio();
         }
         if (bits & AUDIO_OUTPUT_READY_EVENT) {
+            TRACE_SCOPE("output_audio");
             OutputAudio();
         }
+        if (bits & AUDIO_SEND_READY_EVENT) {
+            TRACE_SCOPE("send_audio");
+            SendAudio();
+        }
         if (bits & SCHEDULE_EVENT) {
-            std::unique_lock<std::mutex> lock(mutex_);
-            std::list<std::function<void()>> tasks = std::move(main_tasks_);
-            lock.unlock();
-            for (auto& task : tasks) {
-                task();
-            }
+            TRACE_SCOPE("main_tasks");
+            main_tasks_.Drain();
         }
     }
 }
 
+// 丢弃还没提交的音频，解码器在已提交的解码任务之后重置
 void Application::ResetDecoder() {
-    std::lock_guard<std::mutex> lock(mutex_);
-    opus_decoder_->ResetState();
-    audio_decode_queue_.clear();
-    last_output_time_ = std::chrono::steady_clock::now();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        audio_decode_queue_.clear();
+        last_output_time_ = std::chrono::steady_clock::now();
+    }
+    background_task_->Schedule([this]() {
+        if (opus_decoder_ != nullptr) {
+            opus_decoder_ctl(opus_decoder_, OPUS_RESET_STATE);
+        }
+    }, kBackgroundLaneDecode);
 }
 
 void Application::OutputAudio() {
@@ -627,6 +936,8 @@ void Application::OutputAudio() {
     last_output_time_ = now;
     auto opus = std::move(audio_decode_queue_.front());
     audio_decode_queue_.pop_front();
+    output_frames_.fetch_add(1, std::memory_order_relaxed);
+    TRACE_COUNTER("decode_queue", audio_decode_queue_.size());
     lock.unlock();
 
     background_task_->Schedule([this, codec, opus = std::move(opus)]() mutable {
@@ -634,21 +945,31 @@ void Application::OutputAudio() {
             return;
         }
 
-        std::vector<int16_t> pcm;
-        if (!opus_decoder_->Decode(std::move(opus), pcm)) {
+        if (opus_decoder_ == nullptr) {
+            return;
+        }
+
+        auto start_time = esp_timer_get_time();
+        auto& pcm = decode_pcm_;
+        pcm.resize(opus_decode_sample_rate_ * OPUS_MAX_FRAME_MS / 1000);
+        int samples = opus_decode(opus_decoder_, opus.data(), opus.size(), pcm.data(), pcm.size(), 0);
+        if (samples < 0) {
+            ESP_LOGE(TAG, "Failed to decode audio: %s", opus_strerror(samples));
             return;
         }
+        pcm.resize(samples);
 
         // Resample if the sample rate is different
         if (opus_decode_sample_rate_ != codec->output_sample_rate()) {
             int target_size = output_resampler_.GetOutputSamples(pcm.size());
-            std::vector<int16_t> resampled(target_size);
-            output_resampler_.Process(pcm.data(), pcm.size(), resampled.data());
-            pcm = std::move(resampled);
+            decode_resampled_.resize(target_size);
+            output_resampler_.Process(pcm.data(), pcm.size(), decode_resampled_.data());
+            pcm.swap(decode_resampled_);
         }
+        decode_time_->Record(esp_timer_get_time() - start_time);
         
         codec->OutputData(pcm);
-    });
+    }, kBackgroundLaneDecode);
 }
 
 void Application::InputAudio() {
@@ -657,6 +978,9 @@ void Application::InputAudio() {
     if (!codec->InputData(data)) {
         return;
     }
+#if CONFIG_USE_SESSION_RECORDER
+    SessionRecorder::GetInstance().Record(kSessionEventMicFrame, data.data(), data.size() * sizeof(int16_t));
+#endif
 
     if (codec->input_sample_rate() != 16000) {
         if (codec->input_channels() == 2) {
@@ -693,15 +1017,39 @@ void Application::InputAudio() {
     }
 #else
     if (device_state_ == kDeviceStateListening) {
-        background_task_->Schedule([this, data = std::move(data)]() mutable {
-            opus_encoder_->Encode(std::move(data), [this](std::vector<uint8_t>&& opus) {
-                Schedule([this, opus = std::move(opus)]() {
-                    protocol_->SendAudio(opus);
-                });
-            });
-        });
+        EncodeAudio(std::move(data));
+    }
+#endif
+}
+
+void Application::EncodeAudio(std::vector<int16_t>&& data) {
+    if (!audio_send_queue_.AllowCapture()) {
+        return;
     }
+
+#if CONFIG_USE_AUDIO_PROCESSOR
+    bool voice = voice_detected_;
+#else
+    // 没有音频处理器（AFE）就没有人声检测，全部按人声处理，不能把所有帧都当成静音优先丢弃
+    bool voice = true;
 #endif
+    background_task_->Schedule([this, voice, data = std::move(data)]() mutable {
+        auto start_time = esp_timer_get_time();
+        opus_encoder_->Encode(std::move(data), [this, voice](std::vector<uint8_t>&& opus) {
+            audio_send_queue_.Push(std::move(opus), voice);
+            xEventGroupSetBits(event_group_, AUDIO_SEND_READY_EVENT);
+        });
+        encode_time_->Record(esp_timer_get_time() - start_time);
+    }, kBackgroundLaneEncode);
+}
+
+void Application::SendAudio() {
+    std::vector<uint8_t> opus;
+    while (audio_send_queue_.Pop(opus)) {
+        if (protocol_) {
+            protocol_->SendAudio(opus);
+        }
+    }
 }
 
 void Application::AbortSpeaking(AbortReason reason) {
@@ -710,88 +1058,165 @@ void Application::AbortSpeaking(AbortReason reason) {
     protocol_->SendAbortSpeaking(reason);
 }
 
+// 状态切换由 kDeviceStates 表驱动：先检查切换是否合法，再执行新状态的进入动作
+// 这里不会等待后台任务，需要等待的动作作为任务提交到对应的 lane 上，按顺序在已提交的任务之后执行
 void Application::SetDeviceState(DeviceState state) {
     if (device_state_ == state) {
         return;
     }
-    
-    clock_ticks_ = 0;
+
     auto previous_state = device_state_;
+    auto& info = kDeviceStates[state];
+    if (!(kDeviceStates[previous_state].next_states & STATE_BIT(state))) {
+        ESP_LOGW(TAG, "Invalid state transition: %s -> %s", kDeviceStates[previous_state].name, info.name);
+        return;
+    }
+
+    auto now = esp_timer_get_time();
+    int previous_duration_ms = state_enter_time_ > 0 ? (now - state_enter_time_) / 1000 : 0;
+    clock_ticks_ = 0;
     device_state_ = state;
-    ESP_LOGI(TAG, "STATE: %s", STATE_STRINGS[device_state_]);
-    // The state is changed, wait for all background tasks to finish
-    background_task_->WaitForCompletion();
+    state_epoch_++;
+    state_enter_time_ = now;
+#if CONFIG_USE_SESSION_RECORDER
+    uint8_t recorded_state = state;
+    SessionRecorder::GetInstance().Record(kSessionEventState, &recorded_state, sizeof(recorded_state));
+#endif
 
     auto& board = Board::GetInstance();
     auto codec = board.GetAudioCodec();
     auto display = board.GetDisplay();
     auto led = board.GetLed();
     led->OnStateChanged();
-    switch (state) {
-        case kDeviceStateUnknown:
-        case kDeviceStateIdle:
-            display->SetStatus(Lang::Strings::STANDBY);
-            display->SetEmotion("neutral");
-#if CONFIG_USE_AUDIO_PROCESSOR
-            audio_processor_.Stop();
-#endif
-#if CONFIG_USE_WAKE_WORD_DETECT
-            wake_word_detect_.StartDetection();
-#endif
-            break;
-        case kDeviceStateConnecting:
-            display->SetStatus(Lang::Strings::CONNECTING);
-            display->SetEmotion("neutral");
+    {
+        // 状态、表情和消息在一次加锁内更新，合并为一次重绘
+        DisplayTransaction transaction(display);
+        if (info.status != nullptr) {
+            display->SetStatus(info.status);
+        }
+        if (info.emotion != nullptr) {
+            display->SetEmotion(info.emotion);
+        }
+        if (info.actions & kStateActionClearChatMessage) {
             display->SetChatMessage("system", "");
-            break;
-        case kDeviceStateListening:
-            display->SetStatus(Lang::Strings::LISTENING);
-            display->SetEmotion("neutral");
-            ResetDecoder();
+        }
+#if CONFIG_USE_REFRESH_GOVERNOR
+        display->SetRefreshState(info.name, info.actions & kStateActionLowRefresh);
+#endif
+    }
+
+    if (info.actions & kStateActionResetDecoder) {
+        ResetDecoder();
+    }
+    if (info.actions & kStateActionResetEncoder) {
+        background_task_->Schedule([this]() {
             opus_encoder_->ResetState();
+        }, kBackgroundLaneEncode);
+    }
+    if (info.actions & kStateActionClearSendQueue) {
+        background_task_->Schedule([this]() {
+            audio_send_queue_.Clear();
+        }, kBackgroundLaneEncode);
+    }
+    if (info.actions & kStateActionEnableOutput) {
+        codec->EnableOutput(true);
+    }
 #if CONFIG_USE_AUDIO_PROCESSOR
+    if (info.actions & kStateActionStopProcessor) {
+        audio_processor_.Stop();
+    }
+    if (info.actions & kStateActionStartProcessor) {
+        if (previous_state == kDeviceStateSpeaking) {
+            CoSpawn(StartCaptureAfterSpeaking());
+        } else {
             audio_processor_.Start();
+        }
+    }
 #endif
 #if CONFIG_USE_WAKE_WORD_DETECT
-            wake_word_detect_.StopDetection();
+    if (info.actions & kStateActionStopWakeWord) {
+        wake_word_detect_.StopDetection();
+    }
+    if (info.actions & kStateActionStartWakeWord) {
+        wake_word_detect_.StartDetection();
+    }
 #endif
-            UpdateIotStates();
-            if (previous_state == kDeviceStateSpeaking) {
-                // FIXME: Wait for the speaker to empty the buffer
-                vTaskDelay(pdMS_TO_TICKS(120));
+    if (info.actions & kStateActionSendIotStates) {
+        UpdateIotStates();
+    }
+    if (info.actions & kStateActionBeginTurn) {
+        // 与 EndTurn 在同一条 lane 上按顺序执行
+        background_task_->Schedule([]() {
+            TurnArena::GetInstance().BeginTurn();
+        }, kBackgroundLaneEncode);
+    }
+    if (info.actions & kStateActionEndTurn) {
+        // 排在清空上行队列之后
+        background_task_->Schedule([]() {
+            TurnArena::GetInstance().EndTurn();
+        }, kBackgroundLaneEncode);
+    }
+
+    if (state == kDeviceStateIdle && upgrade_pending_) {
+        Schedule([this]() {
+            if (device_state_ == kDeviceStateIdle) {
+                StartUpgrade();
             }
-            break;
-        case kDeviceStateSpeaking:
-            display->SetStatus(Lang::Strings::SPEAKING);
-            ResetDecoder();
-            codec->EnableOutput(true);
+        });
+    }
+
+    ESP_LOGI(TAG, "STATE: %s (from %s after %d ms, entered in %d us)", info.name, kDeviceStates[previous_state].name,
+        previous_duration_ms, (int)(esp_timer_get_time() - now));
+}
+
+// 已经提交的解码任务播放完后再结束说话状态，等待期间主循环继续处理按键和网络事件
+CoTask<void> Application::FinishSpeaking() {
+    auto epoch = state_epoch_;
+    co_await CoWaitForLane(background_task_, kBackgroundLaneDecode);
+    if (state_epoch_ != epoch) {
+        co_return;
+    }
+    if (keep_listening_) {
+        protocol_->SendStartListening(kListeningModeAutoStop);
+        SetDeviceState(kDeviceStateListening);
+    } else {
+        SetDeviceState(kDeviceStateIdle);
+    }
+}
+
 #if CONFIG_USE_AUDIO_PROCESSOR
-            audio_processor_.Stop();
-#endif
-#if CONFIG_USE_WAKE_WORD_DETECT
-            wake_word_detect_.StartDetection();
-#endif
-            break;
-        default:
-            // Do nothing
-            break;
+// 等扬声器把剩余的声音播完再开始采集，避免把自己的声音发给服务器
+CoTask<void> Application::StartCaptureAfterSpeaking() {
+    auto epoch = state_epoch_;
+    co_await CoWaitForLane(background_task_, kBackgroundLaneDecode);
+    co_await CoDelay(120);
+    if (state_epoch_ == epoch) {
+        audio_processor_.Start();
     }
 }
+#endif
 
+// 解码器和重采样器只在解码 lane 上使用，替换也放到这条 lane 上执行。
+// lane 按顺序执行，之后提交的音频包使用新的采样率解码，不需要等待，
+// 从主循环和 esp_timer 任务（低电量提示音）调用时都不会阻塞
 void Application::SetDecodeSampleRate(int sample_rate) {
-    if (opus_decode_sample_rate_ == sample_rate) {
-        return;
-    }
+    background_task_->Schedule([this, sample_rate]() {
+        if (opus_decode_sample_rate_ == sample_rate) {
+            return;
+        }
 
-    opus_decode_sample_rate_ = sample_rate;
-    opus_decoder_.reset();
-    opus_decoder_ = std::make_unique<OpusDecoderWrapper>(opus_decode_sample_rate_, 1);
+        opus_decode_sample_rate_ = sample_rate;
+        if (opus_decoder_ != nullptr) {
+            opus_decoder_destroy(opus_decoder_);
+        }
+        opus_decoder_ = CreateOpusDecoder(opus_decode_sample_rate_);
 
-    auto codec = Board::GetInstance().GetAudioCodec();
-    if (opus_decode_sample_rate_ != codec->output_sample_rate()) {
-        ESP_LOGI(TAG, "Resampling audio from %d to %d", opus_decode_sample_rate_, codec->output_sample_rate());
-        output_resampler_.Configure(opus_decode_sample_rate_, codec->output_sample_rate());
-    }
+        auto codec = Board::GetInstance().GetAudioCodec();
+        if (opus_decode_sample_rate_ != codec->output_sample_rate()) {
+            ESP_LOGI(TAG, "Resampling audio from %d to %d", opus_decode_sample_rate_, codec->output_sample_rate());
+            output_resampler_.Configure(opus_decode_sample_rate_, codec->output_sample_rate());
+        }
+    }, kBackgroundLaneDecode);
 }
 
 void Application::UpdateIotStates() {
@@ -808,20 +1233,35 @@ void Application::Reboot() {
 }
 
 void Application::WakeWordInvoke(const std::string& wake_word) {
+#if CONFIG_USE_SESSION_RECORDER
+    SessionRecorder::GetInstance().Record(kSessionEventCommand, "wake " + wake_word);
+#endif
+    if (!protocol_) {
+        ESP_LOGE(TAG, "Protocol not initialized");
+        return;
+    }
+
     if (device_state_ == kDeviceStateIdle) {
-        ToggleChatState();
         Schedule([this, wake_word]() {
-            if (protocol_) {
-                protocol_->SendWakeWordDetected(wake_word); 
-            }
-        }); 
+            ConnectAudioChannel([this, wake_word]() {
+                keep_listening_ = true;
+                protocol_->SendStartListening(kListeningModeAutoStop);
+                SetDeviceState(kDeviceStateListening);
+                protocol_->SendWakeWordDetected(wake_word);
+            });
+        });
+    } else if (device_state_ == kDeviceStateConnecting) {
+        Schedule([this]() {
+            CancelConnecting();
+        });
     } else if (device_state_ == kDeviceStateSpeaking) {
         Schedule([this]() {
             AbortSpeaking(kAbortReasonNone);
         });
     } else if (device_state_ == kDeviceStateListening) {   
         Schedule([this]() {
-            if (protocol_) {
+            // 排队期间状态可能已经改变，例如开始了新的连接
+            if (protocol_ && device_state_ == kDeviceStateListening) {
                 protocol_->CloseAudioChannel();
             }
         });
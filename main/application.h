@@ -8,15 +8,22 @@
 
 #include <string>
 #include <mutex>
+#include <atomic>
 #include <list>
+#include <functional>
 
+#include <opus.h>
 #include <opus_encoder.h>
-#include <opus_decoder.h>
 #include <opus_resampler.h>
 
 #include "protocol.h"
 #include "ota.h"
 #include "background_task.h"
+#include "audio_send_queue.h"
+#include "task_queue.h"
+#include "coroutine.h"
+#include "metrics.h"
+#include "turn_arena.h"
 
 #if CONFIG_USE_WAKE_WORD_DETECT
 #include "wake_word_detect.h"
@@ -28,6 +35,7 @@
 #define SCHEDULE_EVENT (1 << 0)
 #define AUDIO_INPUT_READY_EVENT (1 << 1)
 #define AUDIO_OUTPUT_READY_EVENT (1 << 2)
+#define AUDIO_SEND_READY_EVENT (1 << 3)
 
 enum DeviceState {
     kDeviceStateUnknown,
@@ -43,6 +51,10 @@ enum DeviceState {
 };
 
 #define OPUS_FRAME_DURATION_MS 60
+// 服务器下发的一个 Opus 包最长 120ms，解码缓冲区按这个长度准备
+#define OPUS_MAX_FRAME_MS 120
+// 主循环任务队列的槽位数，满了之后退化为加锁的链表
+#define MAIN_TASK_QUEUE_CAPACITY 32
 
 class Application {
 public:
@@ -57,7 +69,14 @@ public:
     void Start();
     DeviceState GetDeviceState() const { return device_state_; }
     bool IsVoiceDetected() const { return voice_detected_; }
-    void Schedule(std::function<void()> callback);
+    // 已经取出解码播放的下行音频时长，用于让界面文字与语音同步
+    uint32_t GetPlayoutPositionMs() const { return output_frames_.load(std::memory_order_relaxed) * OPUS_FRAME_DURATION_MS; }
+    // 可以在任意任务中调用，捕获不超过 8 个指针大小（ESP32 上为 32 字节）时不分配堆内存
+    template <typename F>
+    void Schedule(F&& callback, const CallSite& site = CallSite::current()) {
+        main_tasks_.Push(std::forward<F>(callback), site);
+        xEventGroupSetBits(event_group_, SCHEDULE_EVENT);
+    }
     void SetDeviceState(DeviceState state);
     void Alert(const char* status, const char* message, const char* emotion = "", const std::string_view& sound = "");
     void DismissAlert();
@@ -83,11 +102,23 @@ private:
 #endif
     Ota ota_;
     std::mutex mutex_;
-    std::list<std::function<void()>> main_tasks_;
+#if CONFIG_USE_STALL_DETECTOR
+    TaskQueue<MAIN_TASK_QUEUE_CAPACITY> main_tasks_{"main_loop", CONFIG_STALL_MAIN_LOOP_BUDGET_MS * 1000};
+#else
+    TaskQueue<MAIN_TASK_QUEUE_CAPACITY> main_tasks_;
+#endif
     std::unique_ptr<Protocol> protocol_;
     EventGroupHandle_t event_group_ = nullptr;
     esp_timer_handle_t clock_timer_handle_ = nullptr;
     volatile DeviceState device_state_ = kDeviceStateUnknown;
+    // 每次状态变化加一，延迟执行的动作用它判断状态是否已经改变
+    uint32_t state_epoch_ = 0;
+    int64_t state_enter_time_ = 0;
+    // 每次开始或取消连接加一，旧的连接完成后据此判断是否已经被取消
+    uint32_t connect_generation_ = 0;
+    AsyncEvent audio_channel_event_;
+    bool upgrade_pending_ = false;
+    bool metrics_report_due_ = false;
     bool keep_listening_ = false;
     bool aborted_ = false;
     bool voice_detected_ = false;
@@ -96,12 +127,29 @@ private:
     // Audio encode / decode
     BackgroundTask* background_task_ = nullptr;
     std::chrono::steady_clock::time_point last_output_time_;
-    std::list<std::vector<uint8_t>> audio_decode_queue_;
+    TurnList<TurnVector<uint8_t>> audio_decode_queue_;
+    std::atomic<uint32_t> output_frames_{0};
+    AudioSendQueue audio_send_queue_;
+    MetricHistogram* encode_time_ = nullptr;
+    MetricHistogram* decode_time_ = nullptr;
+    MetricCounter* network_errors_ = nullptr;
+    // CollectMetrics 定期更新的队列状态
+    MetricGauge* main_tasks_peak_ = nullptr;
+    MetricGauge* main_tasks_latency_max_ = nullptr;
+    MetricGauge* send_queue_bytes_ = nullptr;
+    MetricGauge* send_queue_peak_bytes_ = nullptr;
+    MetricGauge* send_dropped_packets_ = nullptr;
+    MetricGauge* decode_queue_ = nullptr;
+    // 只在解码通道中使用，复用容量避免每帧在内部 SRAM 中分配和释放
+    std::vector<int16_t> decode_pcm_;
+    std::vector<int16_t> decode_resampled_;
 
     std::unique_ptr<OpusEncoderWrapper> opus_encoder_;
-    std::unique_ptr<OpusDecoderWrapper> opus_decoder_;
+    // 直接使用 libopus 的解码器，从 TurnArena 中的数据包解码，不必先拷贝到 std::vector
+    OpusDecoder* opus_decoder_ = nullptr;
 
     int opus_decode_sample_rate_ = -1;
+    int opus_encode_complexity_ = 3;
     OpusResampler input_resampler_;
     OpusResampler reference_resampler_;
     OpusResampler output_resampler_;
@@ -109,11 +157,23 @@ private:
     void MainLoop();
     void InputAudio();
     void OutputAudio();
+    void EncodeAudio(std::vector<int16_t>&& data);
+    void SendAudio();
     void ResetDecoder();
     void SetDecodeSampleRate(int sample_rate);
-    void CheckNewVersion();
-    void ShowActivationCode();
+    CoTask<void> CheckNewVersion();
+    void StartUpgrade();
+    void ConnectAudioChannel(std::function<void()> on_opened);
+    CoTask<void> OpenAudioChannel(uint32_t generation, std::function<void()> on_opened);
+    void CancelConnecting();
+    CoTask<void> FinishSpeaking();
+#if CONFIG_USE_AUDIO_PROCESSOR
+    CoTask<void> StartCaptureAfterSpeaking();
+#endif
+    CoTask<void> ShowActivationCode();
     void OnClockTimer();
+    void CollectMetrics();
+    void ReportMetrics();
 };
 
 #endif // _APPLICATION_H_
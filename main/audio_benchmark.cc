@@ -0,0 +1,259 @@
+#include "audio_benchmark.h"
+#include "console.h"
+
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <cJSON.h>
+#include <mbedtls/aes.h>
+#include <opus_encoder.h>
+#include <opus_decoder.h>
+#include <opus_resampler.h>
+
+#include <cmath>
+#include <cstring>
+#include <cstdlib>
+#include <algorithm>
+
+#define TAG "AudioBenchmark"
+
+// 与 Application 中的帧长保持一致
+#define INPUT_FRAME_MS 30
+#define OPUS_FRAME_MS 60
+// esp-sr AFE 的 feed 分块大小（每声道采样数）
+#define AFE_FEED_CHUNK_SAMPLES 512
+
+// 生成可复现的类语音信号：几个谐波叠加少量噪声，避免全零输入让编码器走捷径
+static std::vector<int16_t> GenerateSignal(int sample_rate, int channels, int duration_ms) {
+    int samples = sample_rate / 1000 * duration_ms;
+    std::vector<int16_t> pcm(samples * channels);
+    uint32_t seed = 12345;
+    for (int i = 0; i < samples; i++) {
+        float t = (float)i / sample_rate;
+        float value = 0.3f * sinf(2 * M_PI * 220 * t) + 0.2f * sinf(2 * M_PI * 440 * t) + 0.1f * sinf(2 * M_PI * 1250 * t);
+        seed = seed * 1103515245 + 12345;
+        value += ((int)(seed >> 16) % 2000 - 1000) / 20000.0f;
+        for (int c = 0; c < channels; c++) {
+            pcm[i * channels + c] = (int16_t)(value * 16000);
+        }
+    }
+    return pcm;
+}
+
+AudioBenchmark::AudioBenchmark(int iterations) : iterations_(iterations) {
+}
+
+void AudioBenchmark::Measure(const std::string& name, int frame_ms, std::function<void()> kernel) {
+    // 预热，排除首次调用时的内存分配和缓存影响
+    kernel();
+    kernel();
+
+    AudioBenchmarkResult result = { name, frame_ms, iterations_, 0, 0 };
+    for (int i = 0; i < iterations_; i++) {
+        auto start = esp_timer_get_time();
+        kernel();
+        auto elapsed = esp_timer_get_time() - start;
+        result.total_us += elapsed;
+        result.max_us = std::max(result.max_us, elapsed);
+    }
+    ESP_LOGI(TAG, "%-32s avg %6d us  max %6d us", name.c_str(),
+        (int)(result.total_us / result.iterations), (int)result.max_us);
+    results_.push_back(result);
+}
+
+void AudioBenchmark::BenchmarkInputAudio() {
+    // 与 Application::InputAudio 相同：双声道拆分为麦克风和参考信号后分别重采样到 16kHz
+    for (int sample_rate : {24000, 48000}) {
+        auto data = GenerateSignal(sample_rate, 2, INPUT_FRAME_MS);
+        OpusResampler mic_resampler;
+        OpusResampler reference_resampler;
+        mic_resampler.Configure(sample_rate, 16000);
+        reference_resampler.Configure(sample_rate, 16000);
+        Measure("input_deinterleave_resample_" + std::to_string(sample_rate / 1000) + "k_stereo", INPUT_FRAME_MS, [&]() {
+            auto mic_channel = std::vector<int16_t>(data.size() / 2);
+            auto reference_channel = std::vector<int16_t>(data.size() / 2);
+            for (size_t i = 0, j = 0; i < mic_channel.size(); ++i, j += 2) {
+                mic_channel[i] = data[j];
+                reference_channel[i] = data[j + 1];
+            }
+            auto resampled_mic = std::vector<int16_t>(mic_resampler.GetOutputSamples(mic_channel.size()));
+            auto resampled_reference = std::vector<int16_t>(reference_resampler.GetOutputSamples(reference_channel.size()));
+            mic_resampler.Process(mic_channel.data(), mic_channel.size(), resampled_mic.data());
+            reference_resampler.Process(reference_channel.data(), reference_channel.size(), resampled_reference.data());
+            std::vector<int16_t> output(resampled_mic.size() + resampled_reference.size());
+            for (size_t i = 0, j = 0; i < resampled_mic.size(); ++i, j += 2) {
+                output[j] = resampled_mic[i];
+                output[j + 1] = resampled_reference[i];
+            }
+        });
+
+        auto mono = GenerateSignal(sample_rate, 1, INPUT_FRAME_MS);
+        OpusResampler resampler;
+        resampler.Configure(sample_rate, 16000);
+        Measure("input_resample_" + std::to_string(sample_rate / 1000) + "k_mono", INPUT_FRAME_MS, [&]() {
+            auto resampled = std::vector<int16_t>(resampler.GetOutputSamples(mono.size()));
+            resampler.Process(mono.data(), mono.size(), resampled.data());
+        });
+    }
+}
+
+void AudioBenchmark::BenchmarkOutputAudio() {
+    // 与 Application::OutputAudio 相同：解码后的 60ms 帧重采样到 Codec 输出采样率
+    auto pcm = GenerateSignal(16000, 1, OPUS_FRAME_MS);
+    for (int sample_rate : {24000, 48000}) {
+        OpusResampler resampler;
+        resampler.Configure(16000, sample_rate);
+        Measure("output_resample_16k_" + std::to_string(sample_rate / 1000) + "k", OPUS_FRAME_MS, [&]() {
+            int target_size = resampler.GetOutputSamples(pcm.size());
+            std::vector<int16_t> resampled(target_size);
+            resampler.Process(pcm.data(), pcm.size(), resampled.data());
+        });
+    }
+}
+
+void AudioBenchmark::BenchmarkResampler() {
+    // 单独测试 OpusResampler，不含 vector 分配
+    const int pairs[][2] = { {16000, 24000}, {24000, 16000}, {16000, 48000}, {48000, 16000}, {44100, 16000} };
+    for (auto& pair : pairs) {
+        auto pcm = GenerateSignal(pair[0], 1, OPUS_FRAME_MS);
+        OpusResampler resampler;
+        resampler.Configure(pair[0], pair[1]);
+        std::vector<int16_t> output(resampler.GetOutputSamples(pcm.size()));
+        Measure("opus_resampler_" + std::to_string(pair[0]) + "_" + std::to_string(pair[1]), OPUS_FRAME_MS, [&]() {
+            resampler.Process(pcm.data(), pcm.size(), output.data());
+        });
+    }
+}
+
+void AudioBenchmark::BenchmarkOpus() {
+    auto pcm = GenerateSignal(16000, 1, OPUS_FRAME_MS);
+    std::vector<std::vector<uint8_t>> packets;
+
+    for (int complexity = 0; complexity <= 10; complexity++) {
+        OpusEncoderWrapper encoder(16000, 1, OPUS_FRAME_MS);
+        encoder.SetComplexity(complexity);
+        size_t encoded_bytes = 0;
+        Measure("opus_encode_c" + std::to_string(complexity), OPUS_FRAME_MS, [&]() {
+            auto frame = pcm;
+            encoder.Encode(std::move(frame), [&](std::vector<uint8_t>&& opus) {
+                encoded_bytes = opus.size();
+                if (complexity == 3 && packets.size() < 16) {
+                    packets.push_back(std::move(opus));
+                }
+            });
+        });
+        ESP_LOGI(TAG, "opus_encode_c%d packet size %zu bytes", complexity, encoded_bytes);
+    }
+
+    // 解码使用默认复杂度编码出的数据包，覆盖 16k 与 24k 两种服务端采样率
+    for (int sample_rate : {16000, 24000}) {
+        OpusDecoderWrapper decoder(sample_rate, 1);
+        size_t index = 0;
+        Measure("opus_decode_" + std::to_string(sample_rate / 1000) + "k", OPUS_FRAME_MS, [&]() {
+            auto opus = packets[index++ % packets.size()];
+            std::vector<int16_t> output;
+            decoder.Decode(std::move(opus), output);
+        });
+    }
+}
+
+void AudioBenchmark::BenchmarkAfeFeed() {
+    // 与 AudioProcessor::Input 相同的 vector 追加 + 头部擦除，feed 本身用 memcpy 代替
+    for (int channels : {1, 2}) {
+        auto data = GenerateSignal(16000, channels, INPUT_FRAME_MS);
+        std::vector<int16_t> input_buffer;
+        std::vector<int16_t> afe_input(AFE_FEED_CHUNK_SAMPLES * channels);
+        Measure("afe_feed_chunking_" + std::to_string(channels) + "ch", INPUT_FRAME_MS, [&]() {
+            input_buffer.insert(input_buffer.end(), data.begin(), data.end());
+            size_t feed_size = AFE_FEED_CHUNK_SAMPLES * channels;
+            while (input_buffer.size() >= feed_size) {
+                memcpy(afe_input.data(), input_buffer.data(), feed_size * sizeof(int16_t));
+                input_buffer.erase(input_buffer.begin(), input_buffer.begin() + feed_size);
+            }
+        });
+    }
+}
+
+void AudioBenchmark::BenchmarkAesCtr() {
+    // 与 MqttProtocol::SendAudio 相同：复制 nonce、写入长度和序号后 AES-128-CTR 加密
+    uint8_t key[16];
+    for (int i = 0; i < 16; i++) {
+        key[i] = i * 7 + 1;
+    }
+    mbedtls_aes_context aes_ctx;
+    mbedtls_aes_init(&aes_ctx);
+    mbedtls_aes_setkey_enc(&aes_ctx, key, 128);
+    std::string aes_nonce(16, '\0');
+    aes_nonce[0] = 0x01;
+    uint32_t local_sequence = 0;
+
+    for (size_t packet_size : {64, 160, 320}) {
+        std::vector<uint8_t> data(packet_size, 0x5a);
+        Measure("mqtt_aes_ctr_" + std::to_string(packet_size) + "b", OPUS_FRAME_MS, [&]() {
+            std::string nonce(aes_nonce);
+            *(uint16_t*)&nonce[2] = __builtin_bswap16(data.size());
+            *(uint32_t*)&nonce[12] = __builtin_bswap32(++local_sequence);
+
+            std::string encrypted;
+            encrypted.resize(aes_nonce.size() + data.size());
+            memcpy(encrypted.data(), nonce.data(), nonce.size());
+
+            size_t nc_off = 0;
+            uint8_t stream_block[16] = {0};
+            mbedtls_aes_crypt_ctr(&aes_ctx, data.size(), &nc_off, (uint8_t*)nonce.data(), stream_block,
+                data.data(), (uint8_t*)&encrypted[nonce.size()]);
+        });
+    }
+    mbedtls_aes_free(&aes_ctx);
+}
+
+std::string AudioBenchmark::ToJson() {
+    cJSON* root = cJSON_CreateObject();
+    cJSON_AddNumberToObject(root, "version", 1);
+    cJSON_AddStringToObject(root, "target", CONFIG_IDF_TARGET);
+    cJSON_AddStringToObject(root, "board", BOARD_NAME);
+    cJSON_AddNumberToObject(root, "iterations", iterations_);
+    cJSON* results = cJSON_AddArrayToObject(root, "results");
+    for (auto& result : results_) {
+        cJSON* item = cJSON_CreateObject();
+        double avg_us = (double)result.total_us / result.iterations;
+        cJSON_AddStringToObject(item, "name", result.name.c_str());
+        cJSON_AddNumberToObject(item, "frame_ms", result.frame_ms);
+        cJSON_AddNumberToObject(item, "avg_us", round(avg_us * 10) / 10);
+        cJSON_AddNumberToObject(item, "max_us", result.max_us);
+        // 每秒可处理的音频秒数，越大越好，回归检查以此为准
+        cJSON_AddNumberToObject(item, "realtime_factor", avg_us > 0 ? round(result.frame_ms * 1000.0 / avg_us * 10) / 10 : 0);
+        cJSON_AddItemToArray(results, item);
+    }
+    auto json = cJSON_PrintUnformatted(root);
+    std::string output(json);
+    cJSON_free(json);
+    cJSON_Delete(root);
+    return output;
+}
+
+std::string AudioBenchmark::Run() {
+    ESP_LOGI(TAG, "Running audio benchmark, %d iterations per kernel", iterations_);
+    results_.clear();
+    BenchmarkInputAudio();
+    BenchmarkOutputAudio();
+    BenchmarkResampler();
+    BenchmarkOpus();
+    BenchmarkAfeFeed();
+    BenchmarkAesCtr();
+    return ToJson();
+}
+
+void AudioBenchmark::RegisterConsoleCommand() {
+    Console::GetInstance().RegisterCommand("audio_bench", "Run audio DSP benchmark and print JSON: audio_bench [iterations]",
+        [](int argc, char** argv) {
+            int iterations = argc > 1 ? atoi(argv[1]) : 50;
+            if (iterations <= 0) {
+                iterations = 50;
+            }
+            AudioBenchmark benchmark(iterations);
+            auto json = benchmark.Run();
+            // 加上标记方便脚本从串口日志中提取
+            printf("AUDIO_BENCHMARK_BEGIN\n%s\nAUDIO_BENCHMARK_END\n", json.c_str());
+            return 0;
+        });
+}
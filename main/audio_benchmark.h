@@ -0,0 +1,42 @@
+#ifndef AUDIO_BENCHMARK_H
+#define AUDIO_BENCHMARK_H
+
+#include <string>
+#include <vector>
+#include <functional>
+#include <cstdint>
+
+struct AudioBenchmarkResult {
+    std::string name;
+    int frame_ms;
+    int iterations;
+    int64_t total_us;
+    int64_t max_us;
+};
+
+// 音频 DSP 热点内核的基准测试，覆盖 InputAudio/OutputAudio 的重采样、Opus 编解码、AFE 分块和 UDP 加密
+// 结果以 JSON 输出，由 scripts/audio_benchmark/check_regression.py 与基线比较
+class AudioBenchmark {
+public:
+    AudioBenchmark(int iterations = 50);
+
+    // 运行全部内核并返回 JSON，耗时较长，需要在栈足够大（Opus 编码需要约 24KB）的任务中调用
+    std::string Run();
+    // 注册 audio_bench 控制台命令
+    static void RegisterConsoleCommand();
+
+private:
+    int iterations_;
+    std::vector<AudioBenchmarkResult> results_;
+
+    void Measure(const std::string& name, int frame_ms, std::function<void()> kernel);
+    void BenchmarkInputAudio();
+    void BenchmarkOutputAudio();
+    void BenchmarkResampler();
+    void BenchmarkOpus();
+    void BenchmarkAfeFeed();
+    void BenchmarkAesCtr();
+    std::string ToJson();
+};
+
+#endif // AUDIO_BENCHMARK_H
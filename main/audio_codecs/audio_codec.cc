@@ -4,7 +4,9 @@
 
 #include <esp_log.h>
 #include <cstring>
+#ifndef CONFIG_IDF_TARGET_LINUX
 #include <driver/i2s_common.h>
+#endif
 
 #define TAG "AudioCodec"
 
@@ -38,6 +40,7 @@ bool AudioCodec::InputData(std::vector<int16_t>& data) {
     return false;
 }
 
+#ifndef CONFIG_IDF_TARGET_LINUX
 IRAM_ATTR bool AudioCodec::on_sent(i2s_chan_handle_t handle, i2s_event_data_t *event, void *user_ctx) {
     auto audio_codec = (AudioCodec*)user_ctx;
     if (audio_codec->output_enabled_ && audio_codec->on_output_ready_) {
@@ -53,6 +56,21 @@ IRAM_ATTR bool AudioCodec::on_recv(i2s_chan_handle_t handle, i2s_event_data_t *e
     }
     return false;
 }
+#else
+bool AudioCodec::NotifyInputReady() {
+    if (input_enabled_ && on_input_ready_) {
+        return on_input_ready_();
+    }
+    return false;
+}
+
+bool AudioCodec::NotifyOutputReady() {
+    if (output_enabled_ && on_output_ready_) {
+        return on_output_ready_();
+    }
+    return false;
+}
+#endif
 
 void AudioCodec::Start() {
     Settings settings("audio", false);
@@ -62,6 +80,7 @@ void AudioCodec::Start() {
         output_volume_ = 10;
     }
 
+#ifndef CONFIG_IDF_TARGET_LINUX
     // 注册音频数据回调
     i2s_event_callbacks_t rx_callbacks = {};
     rx_callbacks.on_recv = on_recv;
@@ -73,6 +92,7 @@ void AudioCodec::Start() {
 
     ESP_ERROR_CHECK(i2s_channel_enable(tx_handle_));
     ESP_ERROR_CHECK(i2s_channel_enable(rx_handle_));
+#endif
 
     EnableInput(true);
     EnableOutput(true);
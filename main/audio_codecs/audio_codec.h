@@ -3,7 +3,9 @@
 
 #include <freertos/FreeRTOS.h>
 #include <freertos/event_groups.h>
+#ifndef CONFIG_IDF_TARGET_LINUX
 #include <driver/i2s_std.h>
+#endif
 
 #include <vector>
 #include <string>
@@ -37,13 +39,21 @@ public:
 private:
     std::function<bool()> on_input_ready_;
     std::function<bool()> on_output_ready_;
-    
+
+#ifndef CONFIG_IDF_TARGET_LINUX
     IRAM_ATTR static bool on_recv(i2s_chan_handle_t handle, i2s_event_data_t *event, void *user_ctx);
     IRAM_ATTR static bool on_sent(i2s_chan_handle_t handle, i2s_event_data_t *event, void *user_ctx);
+#endif
 
 protected:
+#ifndef CONFIG_IDF_TARGET_LINUX
     i2s_chan_handle_t tx_handle_ = nullptr;
     i2s_chan_handle_t rx_handle_ = nullptr;
+#else
+    // 主机构建没有 I2S 中断，由具体的 Codec 按实时节奏通知
+    bool NotifyInputReady();
+    bool NotifyOutputReady();
+#endif
 
     bool duplex_ = false;
     bool input_reference_ = false;
@@ -1,4 +1,7 @@
 #include "audio_processor.h"
+#include "tracer.h"
+#include "memory_plan.h"
+#include "task_stacks.h"
 #include <esp_log.h>
 
 #define PROCESSOR_RUNNING 0x01
@@ -7,7 +10,7 @@ static const char* TAG = "AudioProcessor";
 
 AudioProcessor::AudioProcessor()
     : afe_data_(nullptr) {
-    event_group_ = xEventGroupCreate();
+    event_group_ = MemoryPlan::GetInstance().CreateEventGroup();
 }
 
 void AudioProcessor::Initialize(int channels, bool reference) {
@@ -40,11 +43,11 @@ void AudioProcessor::Initialize(int channels, bool reference) {
     afe_iface_ = esp_afe_handle_from_config(afe_config);
     afe_data_ = afe_iface_->create_from_config(afe_config);
     
-    xTaskCreate([](void* arg) {
+    MemoryPlan::GetInstance().CreateTask([](void* arg) {
         auto this_ = (AudioProcessor*)arg;
         this_->AudioProcessorTask();
         vTaskDelete(NULL);
-    }, "audio_communication", 4096, this, 3, NULL);
+    }, "audio_communication", AUDIO_PROCESSOR_STACK_SIZE, this, 3);
 }
 
 AudioProcessor::~AudioProcessor() {
@@ -59,6 +62,7 @@ void AudioProcessor::Input(const std::vector<int16_t>& data) {
 
     auto feed_size = afe_iface_->get_feed_chunksize(afe_data_) * channels_;
     while (input_buffer_.size() >= feed_size) {
+        TRACE_SCOPE("processor_feed");
         auto chunk = input_buffer_.data();
         afe_iface_->feed(afe_data_, chunk);
         input_buffer_.erase(input_buffer_.begin(), input_buffer_.begin() + feed_size);
@@ -105,6 +109,7 @@ void AudioProcessor::AudioProcessorTask() {
             }
             continue;
         }
+        TRACE_SCOPE("processor_fetched");
 
         // VAD state change
         if (vad_state_change_callback_) {
@@ -1,5 +1,11 @@
 #include "wake_word_detect.h"
 #include "application.h"
+#include "tracer.h"
+#include "memory_plan.h"
+#include "task_stacks.h"
+#if CONFIG_USE_STACK_PROFILER
+#include "stack_profiler.h"
+#endif
 
 #include <esp_log.h>
 #include <model_path.h>
@@ -15,7 +21,7 @@ WakeWordDetect::WakeWordDetect()
       wake_word_pcm_(),
       wake_word_opus_() {
 
-    event_group_ = xEventGroupCreate();
+    event_group_ = MemoryPlan::GetInstance().CreateEventGroup();
 }
 
 WakeWordDetect::~WakeWordDetect() {
@@ -23,9 +29,8 @@ WakeWordDetect::~WakeWordDetect() {
         afe_iface_->destroy(afe_data_);
     }
 
-    if (wake_word_encode_task_stack_ != nullptr) {
-        heap_caps_free(wake_word_encode_task_stack_);
-    }
+    // 计划内的栈保留，计划用完退回堆上分配的栈在这里释放
+    MemoryPlan::GetInstance().Free(wake_word_encode_task_stack_);
 
     vEventGroupDelete(event_group_);
 }
@@ -67,11 +72,11 @@ void WakeWordDetect::Initialize(int channels, bool reference) {
     afe_iface_ = esp_afe_handle_from_config(afe_config);
     afe_data_ = afe_iface_->create_from_config(afe_config);
 
-    xTaskCreate([](void* arg) {
+    MemoryPlan::GetInstance().CreateTask([](void* arg) {
         auto this_ = (WakeWordDetect*)arg;
         this_->AudioDetectionTask();
         vTaskDelete(NULL);
-    }, "audio_detection", 4096, this, 3, nullptr);
+    }, "audio_detection", WAKE_WORD_DETECT_STACK_SIZE, this, 3);
 }
 
 void WakeWordDetect::OnWakeWordDetected(std::function<void(const std::string& wake_word)> callback) {
@@ -96,6 +101,7 @@ void WakeWordDetect::Feed(const std::vector<int16_t>& data) {
 
     auto feed_size = afe_iface_->get_feed_chunksize(afe_data_) * channels_;
     while (input_buffer_.size() >= feed_size) {
+        TRACE_SCOPE("wake_word_feed");
         afe_iface_->feed(afe_data_, input_buffer_.data());
         input_buffer_.erase(input_buffer_.begin(), input_buffer_.begin() + feed_size);
     }
@@ -114,6 +120,7 @@ void WakeWordDetect::AudioDetectionTask() {
         if (res == nullptr || res->ret_value == ESP_FAIL) {
             continue;;
         }
+        TRACE_SCOPE("wake_word_fetched");
 
         // Store the wake word data for voice recognition, like who is speaking
         StoreWakeWordData((uint16_t*)res->data, res->data_size / sizeof(uint16_t));
@@ -141,7 +148,7 @@ void WakeWordDetect::StoreWakeWordData(uint16_t* data, size_t samples) {
 void WakeWordDetect::EncodeWakeWordData() {
     wake_word_opus_.clear();
     if (wake_word_encode_task_stack_ == nullptr) {
-        wake_word_encode_task_stack_ = (StackType_t*)heap_caps_malloc(4096 * 8, MALLOC_CAP_SPIRAM);
+        wake_word_encode_task_stack_ = (StackType_t*)MemoryPlan::GetInstance().Allocate("wake_word_encode_stack", WAKE_WORD_ENCODE_STACK_SIZE);
     }
     wake_word_encode_task_ = xTaskCreateStatic([](void* arg) {
         auto this_ = (WakeWordDetect*)arg;
@@ -167,8 +174,12 @@ void WakeWordDetect::EncodeWakeWordData() {
             this_->wake_word_opus_.push_back(std::vector<uint8_t>());
             this_->wake_word_cv_.notify_all();
         }
+#if CONFIG_USE_STACK_PROFILER
+        // 任务结束后就采集不到了，退出前记录
+        StackProfiler::GetInstance().RecordCurrentTask();
+#endif
         vTaskDelete(NULL);
-    }, "encode_detect_packets", 4096 * 8, this, 2, wake_word_encode_task_stack_, &wake_word_encode_task_buffer_);
+    }, "encode_detect_packets", WAKE_WORD_ENCODE_STACK_SIZE, this, 2, wake_word_encode_task_stack_, &wake_word_encode_task_buffer_);
 }
 
 bool WakeWordDetect::GetWakeWordOpus(std::vector<uint8_t>& opus) {
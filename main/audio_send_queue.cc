@@ -0,0 +1,162 @@
+#include "audio_send_queue.h"
+#include "tracer.h"
+
+#include <esp_log.h>
+
+#define TAG "AudioSendQueue"
+
+AudioSendQueue::AudioSendQueue(size_t max_bytes, AudioSendQueuePolicy policy)
+    : policy_(policy), max_bytes_(max_bytes) {
+}
+
+size_t AudioSendQueue::PacketCost(size_t opus_size) {
+    // 计入链表节点开销，避免大量小包时低估实际占用的内存
+    return opus_size + sizeof(Packet) + 2 * sizeof(void*);
+}
+
+void AudioSendQueue::DropPacket(TurnList<Packet>::iterator it) {
+    auto cost = PacketCost(it->opus.size());
+    stats_.queued_bytes -= cost;
+    stats_.dropped_packets++;
+    stats_.dropped_bytes += it->opus.size();
+    packets_.erase(it);
+}
+
+bool AudioSendQueue::UpdateCongestion() {
+    // 超过 3/4 预算进入拥塞状态，低于 1/4 预算时解除，避免频繁切换
+    bool congested = congested_;
+    if (!congested_ && stats_.queued_bytes >= max_bytes_ * 3 / 4) {
+        congested = true;
+    } else if (congested_ && stats_.queued_bytes <= max_bytes_ / 4) {
+        congested = false;
+    }
+    if (congested == congested_) {
+        return false;
+    }
+    congested_ = congested;
+    return true;
+}
+
+void AudioSendQueue::NotifyCongestion(bool congested, size_t queued_bytes) {
+    ESP_LOGW(TAG, "Upstream %s, queued %zu bytes", congested ? "congested" : "recovered", queued_bytes);
+    if (congestion_callback_) {
+        congestion_callback_(congested);
+    }
+}
+
+bool AudioSendQueue::Push(std::vector<uint8_t>&& opus, bool voice) {
+    bool accepted = true;
+    bool changed;
+    bool congested;
+    size_t queued_bytes;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto cost = PacketCost(opus.size());
+        if (cost > max_bytes_) {
+            // 单个包就超出预算，丢掉队列里的包也放不下，直接丢弃，不影响已排队的数据
+            stats_.dropped_packets++;
+            stats_.dropped_bytes += opus.size();
+            accepted = false;
+        } else if (policy_ == kAudioSendQueuePauseCapture) {
+            // 采集已暂停，仍在编码中的帧超出预算时直接丢弃新帧
+            if (stats_.queued_bytes + cost > max_bytes_) {
+                stats_.dropped_packets++;
+                stats_.dropped_bytes += opus.size();
+                accepted = false;
+            }
+        } else {
+            while (!packets_.empty() && stats_.queued_bytes + cost > max_bytes_) {
+                auto victim = packets_.begin();
+                if (policy_ == kAudioSendQueueDropSilence) {
+                    for (auto it = packets_.begin(); it != packets_.end(); ++it) {
+                        if (!it->voice) {
+                            victim = it;
+                            break;
+                        }
+                    }
+                }
+                DropPacket(victim);
+            }
+        }
+
+        if (accepted) {
+            packets_.push_back(Packet{TurnVector<uint8_t>(opus.begin(), opus.end()), voice});
+            stats_.enqueued_packets++;
+            stats_.queued_bytes += cost;
+            if (stats_.queued_bytes > stats_.peak_bytes) {
+                stats_.peak_bytes = stats_.queued_bytes;
+            }
+        }
+        changed = UpdateCongestion();
+        congested = congested_;
+        queued_bytes = stats_.queued_bytes;
+    }
+    TRACE_COUNTER("send_queue_bytes", queued_bytes);
+
+    if (changed) {
+        NotifyCongestion(congested, queued_bytes);
+    }
+    return accepted;
+}
+
+bool AudioSendQueue::Pop(std::vector<uint8_t>& opus) {
+    bool changed;
+    bool congested;
+    size_t queued_bytes;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (packets_.empty()) {
+            return false;
+        }
+        auto& packet = packets_.front();
+        stats_.queued_bytes -= PacketCost(packet.opus.size());
+        stats_.sent_packets++;
+        opus.assign(packet.opus.begin(), packet.opus.end());
+        packets_.pop_front();
+        changed = UpdateCongestion();
+        congested = congested_;
+        queued_bytes = stats_.queued_bytes;
+    }
+    TRACE_COUNTER("send_queue_bytes", queued_bytes);
+
+    if (changed) {
+        NotifyCongestion(congested, queued_bytes);
+    }
+    return true;
+}
+
+void AudioSendQueue::Clear() {
+    bool changed;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        packets_.clear();
+        stats_.queued_bytes = 0;
+        changed = congested_;
+        congested_ = false;
+    }
+
+    if (changed) {
+        NotifyCongestion(false, 0);
+    }
+}
+
+bool AudioSendQueue::AllowCapture() {
+    if (policy_ != kAudioSendQueuePauseCapture) {
+        return true;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (congested_) {
+        stats_.paused_frames++;
+        return false;
+    }
+    return true;
+}
+
+AudioSendQueueStats AudioSendQueue::GetStats() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+void AudioSendQueue::OnCongestionChange(std::function<void(bool congested)> callback) {
+    congestion_callback_ = callback;
+}
@@ -0,0 +1,67 @@
+#ifndef AUDIO_SEND_QUEUE_H
+#define AUDIO_SEND_QUEUE_H
+
+#include <vector>
+#include <list>
+#include <mutex>
+#include <functional>
+#include <cstdint>
+#include <cstddef>
+
+#include "turn_arena.h"
+
+enum AudioSendQueuePolicy {
+    kAudioSendQueueDropOldest,
+    kAudioSendQueueDropSilence,
+    kAudioSendQueuePauseCapture
+};
+
+struct AudioSendQueueStats {
+    uint32_t enqueued_packets = 0;
+    uint32_t sent_packets = 0;
+    uint32_t dropped_packets = 0;
+    uint32_t dropped_bytes = 0;
+    uint32_t paused_frames = 0;
+    size_t queued_bytes = 0;
+    size_t peak_bytes = 0;
+};
+
+// 上行音频发送队列，按字节预算限制排队的 Opus 数据，网络阻塞时按策略丢包或暂停采集
+class AudioSendQueue {
+public:
+    AudioSendQueue(size_t max_bytes, AudioSendQueuePolicy policy);
+
+    // voice 表示该帧是否包含人声，kAudioSendQueueDropSilence 策略会优先丢弃静音帧
+    bool Push(std::vector<uint8_t>&& opus, bool voice);
+    bool Pop(std::vector<uint8_t>& opus);
+    void Clear();
+    // 返回 false 表示应当跳过本帧采集（仅 kAudioSendQueuePauseCapture 策略），同时计数
+    bool AllowCapture();
+    AudioSendQueueStats GetStats();
+    void OnCongestionChange(std::function<void(bool congested)> callback);
+
+    inline AudioSendQueuePolicy policy() const { return policy_; }
+    inline size_t max_bytes() const { return max_bytes_; }
+
+private:
+    // 排队的数据放在 TurnArena 中，Push 和 Pop 时各复制一次，调用方的缓冲区不会长期占用内部 SRAM
+    struct Packet {
+        TurnVector<uint8_t> opus;
+        bool voice;
+    };
+
+    std::mutex mutex_;
+    TurnList<Packet> packets_;
+    std::function<void(bool congested)> congestion_callback_;
+    AudioSendQueuePolicy policy_;
+    size_t max_bytes_;
+    bool congested_ = false;
+    AudioSendQueueStats stats_;
+
+    static size_t PacketCost(size_t opus_size);
+    void DropPacket(TurnList<Packet>::iterator it);
+    bool UpdateCongestion();
+    void NotifyCongestion(bool congested, size_t queued_bytes);
+};
+
+#endif // AUDIO_SEND_QUEUE_H
@@ -1,63 +1,129 @@
 #include "background_task.h"
+#include "tracer.h"
+#include "memory_plan.h"
 
 #include <esp_log.h>
 #include <esp_task_wdt.h>
+#include <esp_timer.h>
+#include <cstdio>
 
 #define TAG "BackgroundTask"
 
-BackgroundTask::BackgroundTask(uint32_t stack_size) {
-    xTaskCreate([](void* arg) {
-        BackgroundTask* task = (BackgroundTask*)arg;
-        task->BackgroundTaskLoop();
-    }, "background_task", stack_size, this, 2, &background_task_handle_);
+#if CONFIG_USE_TRACER || CONFIG_USE_STALL_DETECTOR
+static const char* const kLaneNames[kBackgroundLaneCount] = {"decode", "encode", "best_effort"};
+#endif
+
+BackgroundTask::BackgroundTask(uint32_t stack_size, int worker_count) {
+    if (worker_count < 1) {
+        worker_count = 1;
+    }
+    workers_.resize(worker_count, nullptr);
+    for (int i = 0; i < worker_count; i++) {
+        auto arg = new std::pair<BackgroundTask*, int>(this, i);
+        auto entry = [](void* arg) {
+            auto pair = (std::pair<BackgroundTask*, int>*)arg;
+            auto task = pair->first;
+            int index = pair->second;
+            delete pair;
+            task->WorkerLoop(index);
+        };
+        char name[20];
+        snprintf(name, sizeof(name), "background_%d", i);
+        BaseType_t core = tskNO_AFFINITY;
+        if (worker_count > 1) {
+            // 每个线程固定在一个核心上，第 0 个线程（主要负责解码）放在 APP 核心
+            core = (portNUM_PROCESSORS - 1 - i) % portNUM_PROCESSORS;
+        }
+        workers_[i] = MemoryPlan::GetInstance().CreateTask(entry, name, stack_size, arg, 2, core);
+    }
 }
 
 BackgroundTask::~BackgroundTask() {
-    if (background_task_handle_ != nullptr) {
-        vTaskDelete(background_task_handle_);
+    for (auto handle : workers_) {
+        if (handle != nullptr) {
+            vTaskDelete(handle);
+        }
     }
 }
 
-void BackgroundTask::Schedule(std::function<void()> callback) {
+void BackgroundTask::Schedule(std::function<void()> callback, BackgroundLane lane, const CallSite& site) {
     std::lock_guard<std::mutex> lock(mutex_);
     if (active_tasks_ >= 30) {
         int free_sram = heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
         if (free_sram < 10000) {
-            ESP_LOGW(TAG, "active_tasks_ == %u, free_sram == %u", active_tasks_.load(), free_sram);
+            ESP_LOGW(TAG, "active_tasks_ == %u, free_sram == %u", (unsigned)active_tasks_.load(), free_sram);
         }
     }
     active_tasks_++;
-    main_tasks_.emplace_back([this, cb = std::move(callback)]() {
-        cb();
-        {
-            std::lock_guard<std::mutex> lock(mutex_);
-            active_tasks_--;
-            if (main_tasks_.empty() && active_tasks_ == 0) {
-                condition_variable_.notify_all();
-            }
-        }
-    });
+    lanes_[lane].active_tasks++;
+    lanes_[lane].tasks.push_back(Task{std::move(callback), site});
     condition_variable_.notify_all();
 }
 
 void BackgroundTask::WaitForCompletion() {
     std::unique_lock<std::mutex> lock(mutex_);
-    condition_variable_.wait(lock, [this]() {
-        return main_tasks_.empty() && active_tasks_ == 0;
+    completion_variable_.wait(lock, [this]() {
+        return active_tasks_ == 0;
+    });
+}
+
+void BackgroundTask::WaitForCompletion(BackgroundLane lane) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    completion_variable_.wait(lock, [this, lane]() {
+        return lanes_[lane].active_tasks == 0;
     });
 }
 
-void BackgroundTask::BackgroundTaskLoop() {
-    ESP_LOGI(TAG, "background_task started");
+// 先看自己负责的 lane，再按 lane 的顺序（解码在前）从其他没有线程在执行的 lane 取任务
+bool BackgroundTask::TakeTask(int index, int& lane, Task& task) {
+    int home = index % kBackgroundLaneCount;
+    for (int i = -1; i < kBackgroundLaneCount; i++) {
+        int candidate = i < 0 ? home : i;
+        if (i == home) {
+            continue;
+        }
+        auto& l = lanes_[candidate];
+        if (!l.running && !l.tasks.empty()) {
+            l.running = true;
+            task = std::move(l.tasks.front());
+            l.tasks.pop_front();
+            lane = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+void BackgroundTask::WorkerLoop(int index) {
+    ESP_LOGI(TAG, "background worker %d started", index);
     while (true) {
-        std::unique_lock<std::mutex> lock(mutex_);
-        condition_variable_.wait(lock, [this]() { return !main_tasks_.empty(); });
-        
-        std::list<std::function<void()>> tasks = std::move(main_tasks_);
-        lock.unlock();
-
-        for (auto& task : tasks) {
-            task();
+        int lane;
+        Task task;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            condition_variable_.wait(lock, [&]() { return TakeTask(index, lane, task); });
         }
+
+        {
+            TRACE_SCOPE(kLaneNames[lane]);
+#if CONFIG_USE_STALL_DETECTOR
+            auto start_time = esp_timer_get_time();
+#endif
+            task.callback();
+            task.callback = nullptr;
+#if CONFIG_USE_STALL_DETECTOR
+            StallDetector::GetInstance().Record(task.site, kLaneNames[lane], esp_timer_get_time() - start_time,
+                CONFIG_STALL_BACKGROUND_BUDGET_MS * 1000);
+#endif
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto& l = lanes_[lane];
+        l.running = false;
+        l.active_tasks--;
+        active_tasks_--;
+        // 这条 lane 可能还有任务，唤醒其他空闲线程；同时通知等待完成的调用者
+        condition_variable_.notify_all();
+        completion_variable_.notify_all();
     }
 }
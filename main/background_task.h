@@ -5,25 +5,58 @@
 #include <freertos/task.h>
 #include <mutex>
 #include <list>
+#include <vector>
+#include <functional>
 #include <condition_variable>
 #include <atomic>
 
+#include "stall_detector.h"
+
+enum BackgroundLane {
+    kBackgroundLaneDecode,      // Opus 解码和播放，对延迟最敏感
+    kBackgroundLaneEncode,      // Opus 编码及编码器设置
+    kBackgroundLaneBestEffort,  // 其他不要求实时的工作
+    kBackgroundLaneCount
+};
+
+// 后台线程池：同一条 lane 上的任务按提交顺序串行执行（编解码器都有状态），
+// 不同 lane 可以在不同核心上并行。
+// 所有 lane 的队列放在一起，由同一个互斥锁保护，不是每个线程各自一个队列再互相窃取：
+// 线程先取自己负责的 lane，再取其他没有线程在执行的 lane。一条 lane 同时只在一个线程上执行，
+// 按线程拆分队列后仍要跨线程检查这一点；线程最多两个，共用一把锁的竞争可以忽略
 class BackgroundTask {
 public:
-    BackgroundTask(uint32_t stack_size = 4096 * 2);
+    BackgroundTask(uint32_t stack_size = 4096 * 2, int worker_count = 1);
     ~BackgroundTask();
 
-    void Schedule(std::function<void()> callback);
+    void Schedule(std::function<void()> callback, BackgroundLane lane = kBackgroundLaneBestEffort,
+        const CallSite& site = CallSite::current());
+    // 等待所有 lane 的任务完成
     void WaitForCompletion();
+    // 只等待指定 lane 的任务完成
+    void WaitForCompletion(BackgroundLane lane);
 
 private:
+    struct Task {
+        std::function<void()> callback;
+        [[no_unique_address]] CallSite site;
+    };
+
+    struct Lane {
+        std::list<Task> tasks;
+        bool running = false;       // 是否有线程正在执行这条 lane 的任务
+        size_t active_tasks = 0;    // 排队和正在执行的任务数
+    };
+
     std::mutex mutex_;
-    std::list<std::function<void()>> main_tasks_;
     std::condition_variable condition_variable_;
-    TaskHandle_t background_task_handle_ = nullptr;
+    std::condition_variable completion_variable_;
+    Lane lanes_[kBackgroundLaneCount];
+    std::vector<TaskHandle_t> workers_;
     std::atomic<size_t> active_tasks_{0};
 
-    void BackgroundTaskLoop();
+    void WorkerLoop(int index);
+    bool TakeTask(int index, int& lane, Task& task);
 };
 
 #endif
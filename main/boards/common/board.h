@@ -13,6 +13,7 @@
 void* create_board();
 class AudioCodec;
 class Display;
+class Protocol;
 class Board {
 private:
     Board(const Board&) = delete; // 禁用拷贝构造函数
@@ -43,6 +44,8 @@ public:
     virtual WebSocket* CreateWebSocket() = 0;
     virtual Mqtt* CreateMqtt() = 0;
     virtual Udp* CreateUdp() = 0;
+    // 返回 nullptr 时由 Application 按 CONNECTION_TYPE 创建协议
+    virtual Protocol* CreateProtocol() { return nullptr; }
     virtual void StartNetwork() = 0;
     virtual const char* GetNetworkStateIcon() = 0;
     virtual bool GetBatteryLevel(int &level, bool& charging, bool& discharging);
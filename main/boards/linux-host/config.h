@@ -0,0 +1,28 @@
+#ifndef _BOARD_CONFIG_H_
+#define _BOARD_CONFIG_H_
+
+#define AUDIO_INPUT_SAMPLE_RATE  16000
+#define AUDIO_OUTPUT_SAMPLE_RATE 24000
+
+// 麦克风输入：16 位单声道小端 PCM 文件，采样率为 AUDIO_INPUT_SAMPLE_RATE，读完后循环；未设置时输入静音
+#define HOST_AUDIO_INPUT_ENV     "XIAOZHI_AUDIO_INPUT"
+// 扬声器输出：以相同格式写入文件；未设置时丢弃
+#define HOST_AUDIO_OUTPUT_ENV    "XIAOZHI_AUDIO_OUTPUT"
+// 设置为 1 时把扬声器输出回灌到麦克风输入，用于没有输入文件时制造上行数据
+#define HOST_AUDIO_LOOPBACK_ENV  "XIAOZHI_AUDIO_LOOPBACK"
+
+// 回放 session dump 导出的会话日志，回放结束后输出报告并退出
+#define HOST_SESSION_REPLAY_ENV  "XIAOZHI_SESSION_REPLAY"
+// 回放速度倍数，默认 1
+#define HOST_REPLAY_SPEED_ENV    "XIAOZHI_REPLAY_SPEED"
+// 回放报告（JSON）的输出文件；未设置时打印到标准输出
+#define HOST_REPLAY_REPORT_ENV   "XIAOZHI_REPLAY_REPORT"
+// 把本次运行录制为会话日志，退出时写入该文件（需要 CONFIG_USE_SESSION_RECORDER）
+#define HOST_SESSION_RECORD_ENV  "XIAOZHI_SESSION_RECORD"
+
+// 界面基准测试脚本，未设置时使用内置脚本（需要 CONFIG_USE_UI_BENCHMARK）
+#define HOST_UI_SCRIPT_ENV       "XIAOZHI_UI_SCRIPT"
+// 界面基准测试中 snapshot 操作保存 PNG 的目录；未设置时不保存
+#define HOST_UI_SNAPSHOT_DIR_ENV "XIAOZHI_UI_SNAPSHOT_DIR"
+
+#endif // _BOARD_CONFIG_H_
@@ -0,0 +1,158 @@
+#include "file_audio_codec.h"
+
+#include <esp_log.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <algorithm>
+
+#define TAG "FileAudioCodec"
+
+// 与 I2S DMA 缓冲区的时长相当，Write 最多领先实际播放这么多
+#define OUTPUT_BUFFER_MS 120
+
+FileAudioCodec::FileAudioCodec(int input_sample_rate, int output_sample_rate, const char* input_path, const char* output_path, bool loopback) {
+    duplex_ = true;
+    input_sample_rate_ = input_sample_rate;
+    output_sample_rate_ = output_sample_rate;
+    loopback_ = loopback;
+
+    if (input_path != nullptr) {
+        input_file_ = fopen(input_path, "rb");
+        if (input_file_ == nullptr) {
+            ESP_LOGE(TAG, "Failed to open input file %s", input_path);
+        }
+    }
+    if (output_path != nullptr) {
+        output_file_ = fopen(output_path, "wb");
+        if (output_file_ == nullptr) {
+            ESP_LOGE(TAG, "Failed to open output file %s", output_path);
+        }
+    }
+    playout_end_ = std::chrono::steady_clock::now();
+
+    clock_running_ = true;
+    xTaskCreate([](void* arg) {
+        auto codec = (FileAudioCodec*)arg;
+        codec->ClockTask();
+        codec->clock_running_ = false;
+        vTaskDelete(NULL);
+    }, "audio_clock", 4096, this, configMAX_PRIORITIES - 1, nullptr);
+
+    ESP_LOGI(TAG, "File audio codec: input=%s output=%s loopback=%d",
+        input_path ? input_path : "(silence)", output_path ? output_path : "(discard)", loopback);
+}
+
+FileAudioCodec::~FileAudioCodec() {
+    running_ = false;
+    while (clock_running_) {
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+    if (input_file_ != nullptr) {
+        fclose(input_file_);
+    }
+    if (output_file_ != nullptr) {
+        fclose(output_file_);
+    }
+}
+
+void FileAudioCodec::EnableReplayInput(int input_channels) {
+    input_channels_ = input_channels;
+    input_reference_ = input_channels > 1;
+    replay_input_ = true;
+}
+
+void FileAudioCodec::PushInput(std::vector<int16_t>&& frame) {
+    {
+        std::lock_guard<std::mutex> lock(replay_mutex_);
+        replay_frames_.emplace_back(std::move(frame));
+    }
+    NotifyInputReady();
+}
+
+void FileAudioCodec::SetSpeed(float speed) {
+    speed_ = speed > 0 ? speed : 1.0f;
+}
+
+void FileAudioCodec::ClockTask() {
+    // 模拟 I2S DMA 中断：每 10ms 通知一次可写，每 30ms 通知一次可读（与 InputData 的帧长一致）
+    TickType_t last_wake_time = xTaskGetTickCount();
+    int ticks = 0;
+    while (running_) {
+        TickType_t period = pdMS_TO_TICKS(10) / speed_;
+        xTaskDelayUntil(&last_wake_time, period > 0 ? period : 1);
+        NotifyOutputReady();
+        if (++ticks % 3 == 0 && !replay_input_) {
+            NotifyInputReady();
+        }
+    }
+}
+
+int FileAudioCodec::Read(int16_t* dest, int samples) {
+    if (replay_input_) {
+        // 回放时不补零，没有录制帧就不产生输入，保证送入管线的数据与录制时一致
+        std::lock_guard<std::mutex> lock(replay_mutex_);
+        if (replay_frames_.empty()) {
+            return 0;
+        }
+        auto frame = std::move(replay_frames_.front());
+        replay_frames_.pop_front();
+        int count = std::min<int>(samples, frame.size());
+        std::copy(frame.begin(), frame.begin() + count, dest);
+        std::fill(dest + count, dest + samples, 0);
+        return samples;
+    }
+
+    if (input_file_ != nullptr) {
+        int total = 0;
+        while (total < samples) {
+            size_t ret = fread(dest + total, sizeof(int16_t), samples - total, input_file_);
+            if (ret == 0) {
+                rewind(input_file_);
+                if (total == 0 && feof(input_file_)) {
+                    break;
+                }
+                continue;
+            }
+            total += ret;
+        }
+        std::fill(dest + total, dest + samples, 0);
+        return samples;
+    }
+
+    std::lock_guard<std::mutex> lock(loopback_mutex_);
+    int i = 0;
+    for (; i < samples && !loopback_samples_.empty(); i++) {
+        dest[i] = loopback_samples_.front();
+        loopback_samples_.pop_front();
+    }
+    std::fill(dest + i, dest + samples, 0);
+    return samples;
+}
+
+int FileAudioCodec::Write(const int16_t* data, int samples) {
+    if (output_file_ != nullptr) {
+        fwrite(data, sizeof(int16_t), samples, output_file_);
+        fflush(output_file_);
+    }
+
+    if (loopback_) {
+        // 最近邻重采样到输入采样率，只用于制造上行数据，不追求音质
+        std::lock_guard<std::mutex> lock(loopback_mutex_);
+        int out_samples = (int64_t)samples * input_sample_rate_ / output_sample_rate_;
+        for (int i = 0; i < out_samples; i++) {
+            loopback_samples_.push_back(data[(int64_t)i * output_sample_rate_ / input_sample_rate_]);
+        }
+    }
+
+    // 与真实的 I2S 写入一样，缓冲区满时阻塞调用者，使播放保持实时
+    auto now = std::chrono::steady_clock::now();
+    if (playout_end_ < now) {
+        playout_end_ = now;
+    }
+    playout_end_ += std::chrono::microseconds((int64_t)(samples * 1000000.0 / output_sample_rate_ / speed_));
+    auto ahead = std::chrono::duration_cast<std::chrono::milliseconds>(playout_end_ - now).count();
+    if (ahead > OUTPUT_BUFFER_MS) {
+        vTaskDelay(pdMS_TO_TICKS(ahead - OUTPUT_BUFFER_MS));
+    }
+    return samples;
+}
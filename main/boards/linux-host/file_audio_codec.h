@@ -0,0 +1,44 @@
+#ifndef _FILE_AUDIO_CODEC_H
+#define _FILE_AUDIO_CODEC_H
+
+#include "audio_codec.h"
+
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <vector>
+
+// 主机构建使用的 Codec：按实时节奏从文件读取麦克风数据，把扬声器数据写入文件，也可以回环
+class FileAudioCodec : public AudioCodec {
+public:
+    FileAudioCodec(int input_sample_rate, int output_sample_rate, const char* input_path, const char* output_path, bool loopback);
+    virtual ~FileAudioCodec();
+
+    // 回放模式：麦克风数据由 PushInput 逐帧送入，不再由时钟驱动
+    void EnableReplayInput(int input_channels);
+    void PushInput(std::vector<int16_t>&& frame);
+    // 时钟和播放速度的倍数，用于加速回放
+    void SetSpeed(float speed);
+
+private:
+    FILE* input_file_ = nullptr;
+    FILE* output_file_ = nullptr;
+    bool loopback_ = false;
+    std::mutex loopback_mutex_;
+    std::deque<int16_t> loopback_samples_;
+    std::chrono::steady_clock::time_point playout_end_;
+    std::atomic<bool> replay_input_ = false;
+    std::atomic<float> speed_ = 1.0f;
+    std::mutex replay_mutex_;
+    std::deque<std::vector<int16_t>> replay_frames_;
+    std::atomic<bool> running_ = true;
+    std::atomic<bool> clock_running_ = false;
+
+    void ClockTask();
+    virtual int Read(int16_t* dest, int samples) override;
+    virtual int Write(const int16_t* data, int samples) override;
+};
+
+#endif // _FILE_AUDIO_CODEC_H
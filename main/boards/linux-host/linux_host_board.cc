@@ -0,0 +1,245 @@
+#include "board.h"
+#include "file_audio_codec.h"
+#include "application.h"
+#include "system_info.h"
+#include "font_awesome_symbols.h"
+#include "config.h"
+#include "replay_protocol.h"
+#include "console.h"
+#if CONFIG_USE_AUDIO_BENCHMARK
+#include "audio_benchmark.h"
+#endif
+#if CONFIG_USE_SESSION_RECORDER
+#include "session_recorder.h"
+#endif
+#if CONFIG_USE_UI_BENCHMARK
+#include "ui_benchmark.h"
+#endif
+
+#include "posix_http.h"
+#include "posix_udp.h"
+#include "tcp_transport.h"
+
+#include <esp_log.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include <poll.h>
+#include <unistd.h>
+#include <cstdlib>
+#include <cstring>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+#define TAG "LinuxHostBoard"
+
+// 在 Linux 主机上运行完整的 Application::MainLoop，用于在 CI 机器上通过 perf/valgrind 分析控制和音频流程
+class LinuxHostBoard : public Board {
+private:
+    ReplayProtocol* replay_protocol_ = nullptr;
+
+    void SaveSession() {
+#if CONFIG_USE_SESSION_RECORDER
+        auto path = getenv(HOST_SESSION_RECORD_ENV);
+        if (path != nullptr) {
+            auto& recorder = SessionRecorder::GetInstance();
+            recorder.Stop();
+            recorder.SaveToFile(path);
+        }
+#endif
+    }
+
+#if CONFIG_USE_AUDIO_BENCHMARK
+    // 在控制台任务中同步运行，便于脚本通过 "b out.json" + "q" 依次执行
+    static void RunBenchmark(const std::string& path) {
+        AudioBenchmark benchmark;
+        auto json = benchmark.Run();
+        if (path.empty()) {
+            printf("AUDIO_BENCHMARK_BEGIN\n%s\nAUDIO_BENCHMARK_END\n", json.c_str());
+            return;
+        }
+        FILE* file = fopen(path.c_str(), "w");
+        if (file == nullptr) {
+            ESP_LOGE(TAG, "Failed to open %s", path.c_str());
+            return;
+        }
+        fprintf(file, "%s\n", json.c_str());
+        fclose(file);
+        ESP_LOGI(TAG, "Benchmark result written to %s", path.c_str());
+    }
+#endif
+
+#if CONFIG_USE_UI_BENCHMARK
+    static void RunUiBenchmark(const std::string& path) {
+        std::string script;
+        auto script_path = getenv(HOST_UI_SCRIPT_ENV);
+        if (script_path != nullptr) {
+            std::ifstream file(script_path);
+            if (!file) {
+                ESP_LOGE(TAG, "Failed to open %s", script_path);
+                return;
+            }
+            std::stringstream buffer;
+            buffer << file.rdbuf();
+            script = buffer.str();
+        }
+        UiBenchmark benchmark(script, getenv(HOST_UI_SNAPSHOT_DIR_ENV));
+        auto json = benchmark.Run();
+        if (path.empty()) {
+            printf("UI_BENCHMARK_BEGIN\n%s\nUI_BENCHMARK_END\n", json.c_str());
+            return;
+        }
+        FILE* file = fopen(path.c_str(), "w");
+        if (file == nullptr) {
+            ESP_LOGE(TAG, "Failed to open %s", path.c_str());
+            return;
+        }
+        fprintf(file, "%s\n", json.c_str());
+        fclose(file);
+        ESP_LOGI(TAG, "UI benchmark result written to %s", path.c_str());
+    }
+#endif
+
+    // 标准输入代替按键：t 切换对话，s/x 开始/停止聆听，w <唤醒词> 模拟唤醒，b [文件] 运行音频基准测试，
+    // u [文件] 运行界面基准测试，q 退出，
+    // 其余输入交给 Console 中注册的命令，这些命令（如 audio_bench）在控制台任务中执行，所以栈要足够大
+    void StartConsole() {
+        xTaskCreate([](void* arg) {
+            auto board = (LinuxHostBoard*)arg;
+            auto& app = Application::GetInstance();
+            std::string line;
+            while (true) {
+                // FreeRTOS POSIX 移植中不能阻塞在 read 上，轮询后让出 CPU
+                struct pollfd pfd = { STDIN_FILENO, POLLIN, 0 };
+                if (poll(&pfd, 1, 0) <= 0) {
+                    vTaskDelay(pdMS_TO_TICKS(50));
+                    continue;
+                }
+                char c;
+                if (read(STDIN_FILENO, &c, 1) <= 0) {
+                    vTaskDelay(pdMS_TO_TICKS(50));
+                    continue;
+                }
+                if (c != '\n') {
+                    line += c;
+                    continue;
+                }
+                if (line == "t") {
+                    app.ToggleChatState();
+                } else if (line == "s") {
+                    app.StartListening();
+                } else if (line == "x") {
+                    app.StopListening();
+                } else if (line.rfind("w ", 0) == 0) {
+                    app.WakeWordInvoke(line.substr(2));
+#if CONFIG_USE_AUDIO_BENCHMARK
+                } else if (line == "b" || line.rfind("b ", 0) == 0) {
+                    RunBenchmark(line.size() > 2 ? line.substr(2) : "");
+#endif
+#if CONFIG_USE_UI_BENCHMARK
+                } else if (line == "u" || line.rfind("u ", 0) == 0) {
+                    RunUiBenchmark(line.size() > 2 ? line.substr(2) : "");
+#endif
+                } else if (line == "q") {
+                    board->SaveSession();
+                    fflush(stdout);
+                    exit(0);
+                } else if (!line.empty() && !Console::GetInstance().Execute(line)) {
+                    ESP_LOGW(TAG, "Unknown command: %s (t/s/x/w <wake word>/b [file]/u [file]/q/help)", line.c_str());
+                }
+                line.clear();
+            }
+        }, "host_console", 4096 * 8, this, 1, nullptr);
+    }
+
+    virtual std::string GetBoardJson() override {
+        std::string board_json = std::string("{\"type\":\"" BOARD_TYPE "\",");
+        board_json += "\"name\":\"" BOARD_NAME "\",";
+        board_json += "\"mac\":\"" + SystemInfo::GetMacAddress() + "\"}";
+        return board_json;
+    }
+
+public:
+    LinuxHostBoard() {
+        auto replay_path = getenv(HOST_SESSION_REPLAY_ENV);
+        if (replay_path != nullptr) {
+            auto speed_env = getenv(HOST_REPLAY_SPEED_ENV);
+            float speed = speed_env != nullptr ? atof(speed_env) : 1.0f;
+            replay_protocol_ = new ReplayProtocol(speed);
+            if (!replay_protocol_->Load(replay_path)) {
+                exit(1);
+            }
+            auto codec = (FileAudioCodec*)GetAudioCodec();
+            codec->EnableReplayInput(replay_protocol_->header().input_channels);
+            codec->SetSpeed(speed);
+            replay_protocol_->SetAudioCodec(codec);
+            replay_protocol_->OnFinished([this]() {
+                SaveSession();
+                fflush(stdout);
+                exit(0);
+            });
+        }
+
+#if CONFIG_USE_SESSION_RECORDER
+        if (getenv(HOST_SESSION_RECORD_ENV) != nullptr) {
+            auto codec = GetAudioCodec();
+            SessionRecorder::GetInstance().Start(codec->input_sample_rate(), codec->input_channels(), codec->output_sample_rate());
+        }
+#endif
+        StartConsole();
+    }
+
+    virtual std::string GetBoardType() override {
+        return "linux-host";
+    }
+
+    virtual AudioCodec* GetAudioCodec() override {
+        if (replay_protocol_ != nullptr) {
+            // 回放时使用录制设备的采样率和声道数，保证重采样等处理与设备一致
+            auto& header = replay_protocol_->header();
+            static FileAudioCodec replay_codec(header.input_sample_rate, header.output_sample_rate,
+                nullptr, getenv(HOST_AUDIO_OUTPUT_ENV), false);
+            return &replay_codec;
+        }
+        static FileAudioCodec audio_codec(AUDIO_INPUT_SAMPLE_RATE, AUDIO_OUTPUT_SAMPLE_RATE,
+            getenv(HOST_AUDIO_INPUT_ENV), getenv(HOST_AUDIO_OUTPUT_ENV),
+            getenv(HOST_AUDIO_LOOPBACK_ENV) != nullptr && strcmp(getenv(HOST_AUDIO_LOOPBACK_ENV), "1") == 0);
+        return &audio_codec;
+    }
+
+    virtual Http* CreateHttp() override {
+        return new PosixHttp();
+    }
+
+    virtual WebSocket* CreateWebSocket() override {
+        return new WebSocket(new TcpTransport());
+    }
+
+    virtual Mqtt* CreateMqtt() override {
+        // 主机构建只支持 Websocket 协议
+        return nullptr;
+    }
+
+    virtual Udp* CreateUdp() override {
+        return new PosixUdp();
+    }
+
+    virtual Protocol* CreateProtocol() override {
+        // 所有权交给 Application
+        return replay_protocol_;
+    }
+
+    virtual void StartNetwork() override {
+        // 主机网络由操作系统管理
+    }
+
+    virtual const char* GetNetworkStateIcon() override {
+        return FONT_AWESOME_WIFI;
+    }
+
+    virtual void SetPowerSaveMode(bool enabled) override {
+    }
+};
+
+DECLARE_BOARD(LinuxHostBoard);
@@ -0,0 +1,248 @@
+#include <esp_lvgl_port.h>
+#include <esp_log.h>
+
+#include <mutex>
+#include <chrono>
+#include <algorithm>
+#include <vector>
+#include <cstdio>
+#include <cstring>
+
+#define TAG "HostLvglPort"
+
+struct HostDisplay {
+    lv_display_t* display;
+    int width;
+    int height;
+    std::vector<uint8_t> buffers[2];
+    std::vector<uint16_t> framebuffer;
+    lvgl_port_host_stats_t stats;
+};
+
+static std::recursive_timed_mutex lvgl_mutex;
+static HostDisplay* host_display = nullptr;
+static uint32_t host_tick_ms = 0;
+static bool keep_initialized = false;
+
+// 与画面相比较并写入帧缓冲区，统计颜色变化的像素
+static void HostFlush(lv_display_t* display, const lv_area_t* area, uint8_t* px_map) {
+    auto host = static_cast<HostDisplay*>(lv_display_get_user_data(display));
+    auto pixels = reinterpret_cast<const uint16_t*>(px_map);
+    int width = lv_area_get_width(area);
+    for (int y = area->y1; y <= area->y2; y++) {
+        if (y < 0 || y >= host->height) {
+            pixels += width;
+            continue;
+        }
+        for (int x = area->x1; x <= area->x2; x++, pixels++) {
+            if (x < 0 || x >= host->width) {
+                continue;
+            }
+            auto& target = host->framebuffer[y * host->width + x];
+            if (target != *pixels) {
+                target = *pixels;
+                host->stats.changed_pixels++;
+            }
+        }
+    }
+    host->stats.flushes++;
+    host->stats.flushed_pixels += lv_area_get_size(area);
+    lv_display_flush_ready(display);
+}
+
+esp_err_t lvgl_port_init(const lvgl_port_cfg_t* cfg) {
+    std::lock_guard<std::recursive_timed_mutex> lock(lvgl_mutex);
+    if (!lv_is_initialized()) {
+        lv_init();
+    }
+    lv_tick_set_cb([]() -> uint32_t {
+        return host_tick_ms;
+    });
+    return ESP_OK;
+}
+
+esp_err_t lvgl_port_deinit(void) {
+    std::lock_guard<std::recursive_timed_mutex> lock(lvgl_mutex);
+    if (!lv_is_initialized()) {
+        return ESP_OK;
+    }
+    if (keep_initialized) {
+        // 与 lv_deinit 一样释放显示和上面的屏幕，LVGL 本身保持初始化
+        lv_display_t* display;
+        while ((display = lv_display_get_next(nullptr)) != nullptr) {
+            lv_display_delete(display);
+        }
+        return ESP_OK;
+    }
+    lv_deinit();
+    return ESP_OK;
+}
+
+lv_display_t* lvgl_port_add_disp(const lvgl_port_display_cfg_t* disp_cfg) {
+    std::lock_guard<std::recursive_timed_mutex> lock(lvgl_mutex);
+    auto host = new HostDisplay();
+    host->width = disp_cfg->hres;
+    host->height = disp_cfg->vres;
+    host->framebuffer.assign(host->width * host->height, 0);
+
+    host->display = lv_display_create(host->width, host->height);
+    lv_display_set_default(host->display);
+    lv_display_set_color_format(host->display, LV_COLOR_FORMAT_RGB565);
+    lv_display_set_user_data(host->display, host);
+    lv_display_set_flush_cb(host->display, HostFlush);
+
+    size_t buffer_bytes = disp_cfg->buffer_size * sizeof(uint16_t);
+    host->buffers[0].resize(buffer_bytes);
+    if (disp_cfg->double_buffer) {
+        host->buffers[1].resize(buffer_bytes);
+    }
+    auto render_mode = disp_cfg->flags.full_refresh ? LV_DISPLAY_RENDER_MODE_FULL : LV_DISPLAY_RENDER_MODE_PARTIAL;
+    if (disp_cfg->flags.full_refresh && buffer_bytes < host->framebuffer.size() * sizeof(uint16_t)) {
+        // RGB 屏的整屏刷新由帧缓冲区大小决定，主机上按整屏分配
+        buffer_bytes = host->framebuffer.size() * sizeof(uint16_t);
+        host->buffers[0].resize(buffer_bytes);
+        if (disp_cfg->double_buffer) {
+            host->buffers[1].resize(buffer_bytes);
+        }
+    }
+    lv_display_set_buffers(host->display, host->buffers[0].data(),
+        disp_cfg->double_buffer ? host->buffers[1].data() : nullptr, buffer_bytes, render_mode);
+
+    lv_display_add_event_cb(host->display, [](lv_event_t* e) {
+        auto host = static_cast<HostDisplay*>(lv_event_get_user_data(e));
+        if (host_display == host) {
+            host_display = nullptr;
+        }
+        delete host;
+    }, LV_EVENT_DELETE, host);
+
+    host_display = host;
+    ESP_LOGI(TAG, "In-memory display %dx%d, buffer %zu bytes x %d", host->width, host->height,
+        buffer_bytes, disp_cfg->double_buffer ? 2 : 1);
+    return host->display;
+}
+
+lv_display_t* lvgl_port_add_disp_rgb(const lvgl_port_display_cfg_t* disp_cfg, const lvgl_port_display_rgb_cfg_t* rgb_cfg) {
+    return lvgl_port_add_disp(disp_cfg);
+}
+
+bool lvgl_port_lock(uint32_t timeout_ms) {
+    if (timeout_ms == 0) {
+        lvgl_mutex.lock();
+        return true;
+    }
+    return lvgl_mutex.try_lock_for(std::chrono::milliseconds(timeout_ms));
+}
+
+void lvgl_port_unlock(void) {
+    lvgl_mutex.unlock();
+}
+
+void lvgl_port_host_advance(uint32_t ms) {
+    std::lock_guard<std::recursive_timed_mutex> lock(lvgl_mutex);
+    uint32_t end = host_tick_ms + ms;
+    while (host_tick_ms < end) {
+        host_tick_ms = std::min<uint32_t>(host_tick_ms + LV_DEF_REFR_PERIOD, end);
+        lv_timer_handler();
+    }
+}
+
+void lvgl_port_host_keep_initialized(bool keep) {
+    std::lock_guard<std::recursive_timed_mutex> lock(lvgl_mutex);
+    keep_initialized = keep;
+}
+
+void lvgl_port_host_get_stats(lvgl_port_host_stats_t* stats, bool reset) {
+    std::lock_guard<std::recursive_timed_mutex> lock(lvgl_mutex);
+    if (host_display == nullptr) {
+        memset(stats, 0, sizeof(*stats));
+        return;
+    }
+    *stats = host_display->stats;
+    if (reset) {
+        memset(&host_display->stats, 0, sizeof(host_display->stats));
+    }
+}
+
+// PNG 使用不压缩的 deflate 块，不依赖 zlib
+static uint32_t Crc32(uint32_t crc, const uint8_t* data, size_t size) {
+    crc = ~crc;
+    for (size_t i = 0; i < size; i++) {
+        crc ^= data[i];
+        for (int k = 0; k < 8; k++) {
+            crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+        }
+    }
+    return ~crc;
+}
+
+static void PutU32(std::vector<uint8_t>& out, uint32_t value) {
+    out.push_back(value >> 24);
+    out.push_back(value >> 16);
+    out.push_back(value >> 8);
+    out.push_back(value);
+}
+
+static void WriteChunk(FILE* file, const char* type, const std::vector<uint8_t>& data) {
+    std::vector<uint8_t> chunk;
+    PutU32(chunk, data.size());
+    chunk.insert(chunk.end(), type, type + 4);
+    chunk.insert(chunk.end(), data.begin(), data.end());
+    PutU32(chunk, Crc32(0, chunk.data() + 4, chunk.size() - 4));
+    fwrite(chunk.data(), 1, chunk.size(), file);
+}
+
+bool lvgl_port_host_save_png(const char* path) {
+    std::lock_guard<std::recursive_timed_mutex> lock(lvgl_mutex);
+    if (host_display == nullptr) {
+        return false;
+    }
+    auto host = host_display;
+
+    // 每行前加滤波类型 0，RGB565 展开为 RGB888
+    std::vector<uint8_t> raw;
+    raw.reserve(host->height * (host->width * 3 + 1));
+    for (int y = 0; y < host->height; y++) {
+        raw.push_back(0);
+        for (int x = 0; x < host->width; x++) {
+            uint16_t color = host->framebuffer[y * host->width + x];
+            raw.push_back(((color >> 11) & 0x1F) * 255 / 31);
+            raw.push_back(((color >> 5) & 0x3F) * 255 / 63);
+            raw.push_back((color & 0x1F) * 255 / 31);
+        }
+    }
+
+    std::vector<uint8_t> zlib = {0x78, 0x01};
+    uint32_t adler_a = 1, adler_b = 0;
+    for (auto byte : raw) {
+        adler_a = (adler_a + byte) % 65521;
+        adler_b = (adler_b + adler_a) % 65521;
+    }
+    for (size_t offset = 0; offset < raw.size() || offset == 0; offset += 65535) {
+        size_t length = std::min<size_t>(65535, raw.size() - offset);
+        zlib.push_back(offset + length >= raw.size() ? 1 : 0);
+        zlib.push_back(length & 0xFF);
+        zlib.push_back(length >> 8);
+        zlib.push_back(~length & 0xFF);
+        zlib.push_back((~length >> 8) & 0xFF);
+        zlib.insert(zlib.end(), raw.begin() + offset, raw.begin() + offset + length);
+    }
+    PutU32(zlib, (adler_b << 16) | adler_a);
+
+    FILE* file = fopen(path, "wb");
+    if (file == nullptr) {
+        ESP_LOGE(TAG, "Failed to open %s", path);
+        return false;
+    }
+    static const uint8_t signature[] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    fwrite(signature, 1, sizeof(signature), file);
+    std::vector<uint8_t> header;
+    PutU32(header, host->width);
+    PutU32(header, host->height);
+    header.insert(header.end(), {8, 2, 0, 0, 0});  // 8 位 RGB
+    WriteChunk(file, "IHDR", header);
+    WriteChunk(file, "IDAT", zlib);
+    WriteChunk(file, "IEND", {});
+    fclose(file);
+    return true;
+}
@@ -0,0 +1,50 @@
+#include <esp_ota_ops.h>
+
+// 主机构建始终运行在 factory 分区，Ota::MarkCurrentVersionValid 会直接跳过
+static const esp_partition_t host_running_partition = {
+    .flash_chip = nullptr,
+    .type = ESP_PARTITION_TYPE_APP,
+    .subtype = ESP_PARTITION_SUBTYPE_APP_FACTORY,
+    .address = 0x10000,
+    .size = 0,
+    .erase_size = 0,
+    .label = "factory",
+    .encrypted = false,
+    .readonly = true,
+};
+
+const esp_partition_t* esp_ota_get_running_partition(void) {
+    return &host_running_partition;
+}
+
+const esp_partition_t* esp_ota_get_next_update_partition(const esp_partition_t *start_from) {
+    return nullptr;
+}
+
+esp_err_t esp_ota_get_state_partition(const esp_partition_t *partition, esp_ota_img_states_t *ota_state) {
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t esp_ota_mark_app_valid_cancel_rollback(void) {
+    return ESP_OK;
+}
+
+esp_err_t esp_ota_begin(const esp_partition_t* partition, size_t image_size, esp_ota_handle_t* out_handle) {
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t esp_ota_write(esp_ota_handle_t handle, const void* data, size_t size) {
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t esp_ota_end(esp_ota_handle_t handle) {
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t esp_ota_abort(esp_ota_handle_t handle) {
+    return ESP_OK;
+}
+
+esp_err_t esp_ota_set_boot_partition(const esp_partition_t* partition) {
+    return ESP_ERR_NOT_SUPPORTED;
+}
@@ -0,0 +1,20 @@
+#ifndef _LINUX_HOST_ESP_LCD_PANEL_IO_H_
+#define _LINUX_HOST_ESP_LCD_PANEL_IO_H_
+
+// IDF linux 目标没有 esp_lcd 组件，主机上的显示由 esp_lvgl_port.cc 的内存显示驱动代替，面板句柄始终为空
+
+#include <esp_err.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct esp_lcd_panel_io_t* esp_lcd_panel_io_handle_t;
+
+static inline esp_err_t esp_lcd_panel_io_del(esp_lcd_panel_io_handle_t io) { return ESP_OK; }
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _LINUX_HOST_ESP_LCD_PANEL_IO_H_
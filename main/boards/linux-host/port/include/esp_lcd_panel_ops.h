@@ -0,0 +1,24 @@
+#ifndef _LINUX_HOST_ESP_LCD_PANEL_OPS_H_
+#define _LINUX_HOST_ESP_LCD_PANEL_OPS_H_
+
+// 面板操作全部为空，画面由 LVGL 刷新到内存帧缓冲区
+
+#include <stdbool.h>
+#include <esp_err.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct esp_lcd_panel_t* esp_lcd_panel_handle_t;
+
+static inline esp_err_t esp_lcd_panel_draw_bitmap(esp_lcd_panel_handle_t panel, int x_start, int y_start,
+    int x_end, int y_end, const void* color_data) { return ESP_OK; }
+static inline esp_err_t esp_lcd_panel_disp_on_off(esp_lcd_panel_handle_t panel, bool on_off) { return ESP_OK; }
+static inline esp_err_t esp_lcd_panel_del(esp_lcd_panel_handle_t panel) { return ESP_OK; }
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _LINUX_HOST_ESP_LCD_PANEL_OPS_H_
@@ -0,0 +1,103 @@
+#ifndef _LINUX_HOST_ESP_LVGL_PORT_H_
+#define _LINUX_HOST_ESP_LVGL_PORT_H_
+
+/*
+ * esp_lvgl_port 不支持 linux 目标，这里提供接口一致的内存显示驱动：
+ * 显示刷新到内存帧缓冲区并统计变化的像素，没有 LVGL 任务，由调用者推进虚拟时钟运行 LVGL 定时器，
+ * 结果可以复现；配置中的 DMA、PSRAM、旋转等选项被忽略，单色屏也按 RGB565 渲染
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <esp_err.h>
+#include <esp_lcd_panel_io.h>
+#include <esp_lcd_panel_ops.h>
+#include <lvgl.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    int task_priority;
+    int task_stack;
+    int task_affinity;
+    int task_max_sleep_ms;
+    int timer_period_ms;
+} lvgl_port_cfg_t;
+
+#define ESP_LVGL_PORT_INIT_CONFIG() \
+    {                               \
+        .task_priority = 4,         \
+        .task_stack = 6144,         \
+        .task_affinity = -1,        \
+        .task_max_sleep_ms = 500,   \
+        .timer_period_ms = 5,       \
+    }
+
+typedef struct {
+    bool swap_xy;
+    bool mirror_x;
+    bool mirror_y;
+} lvgl_port_rotation_cfg_t;
+
+typedef struct {
+    esp_lcd_panel_io_handle_t io_handle;
+    esp_lcd_panel_handle_t panel_handle;
+    esp_lcd_panel_handle_t control_handle;
+    uint32_t buffer_size;
+    bool double_buffer;
+    uint32_t trans_size;
+    uint32_t hres;
+    uint32_t vres;
+    bool monochrome;
+    lvgl_port_rotation_cfg_t rotation;
+    lv_color_format_t color_format;
+    struct {
+        unsigned int buff_dma: 1;
+        unsigned int buff_spiram: 1;
+        unsigned int sw_rotate: 1;
+        unsigned int swap_bytes: 1;
+        unsigned int full_refresh: 1;
+        unsigned int direct_mode: 1;
+    } flags;
+} lvgl_port_display_cfg_t;
+
+typedef struct {
+    struct {
+        unsigned int bb_mode: 1;
+        unsigned int avoid_tearing: 1;
+    } flags;
+} lvgl_port_display_rgb_cfg_t;
+
+esp_err_t lvgl_port_init(const lvgl_port_cfg_t* cfg);
+esp_err_t lvgl_port_deinit(void);
+lv_display_t* lvgl_port_add_disp(const lvgl_port_display_cfg_t* disp_cfg);
+lv_display_t* lvgl_port_add_disp_rgb(const lvgl_port_display_cfg_t* disp_cfg, const lvgl_port_display_rgb_cfg_t* rgb_cfg);
+// timeout_ms 为 0 时一直等待
+bool lvgl_port_lock(uint32_t timeout_ms);
+void lvgl_port_unlock(void);
+
+// 以下为主机构建专用，内部持有 LVGL 锁
+
+typedef struct {
+    uint32_t flushes;           // flush 回调次数
+    uint64_t flushed_pixels;    // 刷新到屏幕的像素数
+    uint64_t changed_pixels;    // 其中颜色发生变化的像素数
+} lvgl_port_host_stats_t;
+
+// 推进虚拟时钟 ms 毫秒，按 LVGL 默认刷新周期分步运行定时器
+void lvgl_port_host_advance(uint32_t ms);
+// keep 为 true 时 lvgl_port_deinit 只删除剩下的显示，不反初始化 LVGL，
+// 依次创建多个显示时不必每次重新初始化
+void lvgl_port_host_keep_initialized(bool keep);
+// 最近添加的显示的刷新统计，reset 时清零
+void lvgl_port_host_get_stats(lvgl_port_host_stats_t* stats, bool reset);
+// 把最近添加的显示的帧缓冲区保存为 PNG
+bool lvgl_port_host_save_png(const char* path);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _LINUX_HOST_ESP_LVGL_PORT_H_
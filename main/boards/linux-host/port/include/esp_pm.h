@@ -0,0 +1,32 @@
+#ifndef _LINUX_HOST_ESP_PM_H_
+#define _LINUX_HOST_ESP_PM_H_
+
+// IDF linux 目标没有电源管理，锁操作全部为空
+
+#include <esp_err.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    ESP_PM_CPU_FREQ_MAX,
+    ESP_PM_APB_FREQ_MAX,
+    ESP_PM_NO_LIGHT_SLEEP,
+} esp_pm_lock_type_t;
+
+typedef struct esp_pm_lock* esp_pm_lock_handle_t;
+
+static inline esp_err_t esp_pm_lock_create(esp_pm_lock_type_t lock_type, int arg, const char* name, esp_pm_lock_handle_t* out_handle) {
+    *out_handle = NULL;
+    return ESP_ERR_NOT_SUPPORTED;
+}
+static inline esp_err_t esp_pm_lock_acquire(esp_pm_lock_handle_t handle) { return ESP_OK; }
+static inline esp_err_t esp_pm_lock_release(esp_pm_lock_handle_t handle) { return ESP_OK; }
+static inline esp_err_t esp_pm_lock_delete(esp_pm_lock_handle_t handle) { return ESP_OK; }
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _LINUX_HOST_ESP_PM_H_
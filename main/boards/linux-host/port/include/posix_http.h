@@ -0,0 +1,37 @@
+#ifndef _POSIX_HTTP_H_
+#define _POSIX_HTTP_H_
+
+#include "http.h"
+#include "tcp_transport.h"
+
+#include <map>
+#include <string>
+
+// 基于 TcpTransport 的 HTTP/1.1 客户端，只支持 http://，响应体一次性读入内存
+class PosixHttp : public Http {
+public:
+    PosixHttp();
+    ~PosixHttp();
+
+    void SetHeader(const std::string& key, const std::string& value) override;
+    bool Open(const std::string& method, const std::string& url, const std::string& content = "") override;
+    void Close() override;
+
+    int GetStatusCode() const override;
+    std::string GetResponseHeader(const std::string& key) const override;
+    size_t GetBodyLength() const override;
+    const std::string& GetBody() override;
+    int Read(char* buffer, size_t buffer_size) override;
+
+private:
+    TcpTransport transport_;
+    std::map<std::string, std::string> headers_;
+    std::map<std::string, std::string> response_headers_;
+    std::string body_;
+    size_t read_offset_ = 0;
+    int status_code_ = -1;
+
+    bool ReadResponse();
+};
+
+#endif // _POSIX_HTTP_H_
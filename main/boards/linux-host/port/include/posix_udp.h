@@ -0,0 +1,28 @@
+#ifndef _POSIX_UDP_H_
+#define _POSIX_UDP_H_
+
+#include "udp.h"
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include <atomic>
+
+// 基于 POSIX socket 的 UDP 连接，接收在独立任务中完成
+class PosixUdp : public Udp {
+public:
+    PosixUdp();
+    ~PosixUdp();
+
+    bool Connect(const std::string& host, int port) override;
+    void Disconnect() override;
+    int Send(const std::string& data) override;
+
+private:
+    int fd_ = -1;
+    std::atomic<bool> receiving_ = false;
+
+    void ReceiveTask();
+};
+
+#endif // _POSIX_UDP_H_
@@ -0,0 +1,21 @@
+#ifndef _TCP_TRANSPORT_H_
+#define _TCP_TRANSPORT_H_
+
+#include "transport.h"
+
+// 基于 POSIX socket 的 TCP 连接
+class TcpTransport : public Transport {
+public:
+    TcpTransport();
+    ~TcpTransport();
+
+    bool Connect(const char* host, int port) override;
+    void Disconnect() override;
+    int Send(const char* data, size_t length) override;
+    int Receive(char* buffer, size_t bufferSize) override;
+
+private:
+    int fd_ = -1;
+};
+
+#endif // _TCP_TRANSPORT_H_
@@ -0,0 +1,22 @@
+#ifndef _TRANSPORT_H_
+#define _TRANSPORT_H_
+
+// 与 esp-ml307 的 Transport 接口保持一致，供主机构建使用
+
+#include <cstddef>
+
+class Transport {
+public:
+    virtual ~Transport() {}
+    virtual bool Connect(const char* host, int port) = 0;
+    virtual void Disconnect() = 0;
+    virtual int Send(const char* data, size_t length) = 0;
+    virtual int Receive(char* buffer, size_t bufferSize) = 0;
+
+    bool connected() const { return connected_; }
+
+protected:
+    bool connected_ = false;
+};
+
+#endif // _TRANSPORT_H_
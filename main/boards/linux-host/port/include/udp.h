@@ -0,0 +1,25 @@
+#ifndef _UDP_H_
+#define _UDP_H_
+
+// 与 esp-ml307 的 Udp 接口保持一致，供主机构建使用
+
+#include <string>
+#include <functional>
+
+class Udp {
+public:
+    virtual ~Udp() = default;
+    virtual bool Connect(const std::string& host, int port) = 0;
+    virtual void Disconnect() = 0;
+    virtual int Send(const std::string& data) = 0;
+
+    virtual void OnMessage(std::function<void(const std::string& data)> callback) {
+        message_callback_ = callback;
+    }
+
+protected:
+    std::function<void(const std::string& data)> message_callback_;
+    bool connected_ = false;
+};
+
+#endif // _UDP_H_
@@ -0,0 +1,52 @@
+#ifndef _WEB_SOCKET_H_
+#define _WEB_SOCKET_H_
+
+// 与 esp-ml307 的 WebSocket 接口保持一致，供主机构建使用，只支持 ws://
+
+#include "transport.h"
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include <map>
+#include <atomic>
+#include <string>
+#include <mutex>
+#include <functional>
+
+class WebSocket {
+public:
+    WebSocket(Transport *transport);
+    ~WebSocket();
+
+    void SetHeader(const char* key, const char* value);
+    bool IsConnected() const;
+    bool Connect(const char* uri);
+    bool Send(const std::string& data);
+    bool Send(const void* data, size_t len, bool binary = false, bool fin = true);
+    void Ping();
+    void Close();
+
+    void OnConnected(std::function<void()> callback);
+    void OnDisconnected(std::function<void()> callback);
+    void OnData(std::function<void(const char*, size_t, bool binary)> callback);
+    void OnError(std::function<void(int)> callback);
+
+private:
+    Transport *transport_;
+    std::atomic<bool> receiving_ = false;
+    std::mutex send_mutex_;
+    std::map<std::string, std::string> headers_;
+    std::string pending_;
+    std::function<void(const char*, size_t, bool binary)> on_data_;
+    std::function<void(int)> on_error_;
+    std::function<void()> on_connected_;
+    std::function<void()> on_disconnected_;
+
+    void ReceiveTask();
+    bool SendFrame(uint8_t opcode, const void* data, size_t len, bool fin);
+    bool SendAll(const char* data, size_t len);
+    bool ReceiveExact(char* data, size_t len);
+};
+
+#endif // _WEB_SOCKET_H_
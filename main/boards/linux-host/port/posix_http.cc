@@ -0,0 +1,160 @@
+#include "posix_http.h"
+
+#include <esp_log.h>
+
+#include <algorithm>
+#include <cstring>
+#include <cstdlib>
+
+#define TAG "PosixHttp"
+
+static std::string ToLower(std::string s) {
+    std::transform(s.begin(), s.end(), s.begin(), ::tolower);
+    return s;
+}
+
+PosixHttp::PosixHttp() {
+}
+
+PosixHttp::~PosixHttp() {
+    Close();
+}
+
+void PosixHttp::SetHeader(const std::string& key, const std::string& value) {
+    headers_[key] = value;
+}
+
+bool PosixHttp::Open(const std::string& method, const std::string& url, const std::string& content) {
+    // 解析 http://host[:port]/path
+    if (url.find("http://") != 0) {
+        ESP_LOGE(TAG, "Only http:// is supported on host: %s", url.c_str());
+        return false;
+    }
+    std::string authority = url.substr(7);
+    std::string path = "/";
+    auto slash = authority.find('/');
+    if (slash != std::string::npos) {
+        path = authority.substr(slash);
+        authority = authority.substr(0, slash);
+    }
+    std::string host = authority;
+    int port = 80;
+    auto colon = authority.find(':');
+    if (colon != std::string::npos) {
+        host = authority.substr(0, colon);
+        port = std::stoi(authority.substr(colon + 1));
+    }
+
+    if (!transport_.Connect(host.c_str(), port)) {
+        return false;
+    }
+
+    std::string request = method + " " + path + " HTTP/1.1\r\n";
+    request += "Host: " + authority + "\r\n";
+    request += "Connection: close\r\n";
+    for (const auto& header : headers_) {
+        request += header.first + ": " + header.second + "\r\n";
+    }
+    if (!content.empty() || method == "POST") {
+        request += "Content-Length: " + std::to_string(content.size()) + "\r\n";
+    }
+    request += "\r\n";
+    request += content;
+    if (transport_.Send(request.data(), request.size()) < 0) {
+        Close();
+        return false;
+    }
+    return ReadResponse();
+}
+
+bool PosixHttp::ReadResponse() {
+    std::string response;
+    char buffer[1024];
+    while (true) {
+        int ret = transport_.Receive(buffer, sizeof(buffer));
+        if (ret <= 0) {
+            break;
+        }
+        response.append(buffer, ret);
+    }
+    transport_.Disconnect();
+
+    auto header_end = response.find("\r\n\r\n");
+    if (header_end == std::string::npos) {
+        ESP_LOGE(TAG, "Invalid HTTP response");
+        return false;
+    }
+
+    // 状态行与响应头
+    size_t line_start = 0;
+    size_t line_end = response.find("\r\n");
+    auto status_line = response.substr(0, line_end);
+    auto space = status_line.find(' ');
+    if (space != std::string::npos) {
+        status_code_ = atoi(status_line.c_str() + space + 1);
+    }
+    line_start = line_end + 2;
+    while (line_start < header_end) {
+        line_end = response.find("\r\n", line_start);
+        auto line = response.substr(line_start, line_end - line_start);
+        auto colon = line.find(':');
+        if (colon != std::string::npos) {
+            auto value = line.substr(colon + 1);
+            value.erase(0, value.find_first_not_of(' '));
+            response_headers_[ToLower(line.substr(0, colon))] = value;
+        }
+        line_start = line_end + 2;
+    }
+
+    body_ = response.substr(header_end + 4);
+    if (ToLower(GetResponseHeader("transfer-encoding")) == "chunked") {
+        std::string decoded;
+        size_t pos = 0;
+        while (pos < body_.size()) {
+            auto size_end = body_.find("\r\n", pos);
+            if (size_end == std::string::npos) {
+                break;
+            }
+            size_t chunk_size = strtoul(body_.c_str() + pos, nullptr, 16);
+            if (chunk_size == 0) {
+                break;
+            }
+            decoded += body_.substr(size_end + 2, chunk_size);
+            pos = size_end + 2 + chunk_size + 2;
+        }
+        body_ = std::move(decoded);
+    }
+    read_offset_ = 0;
+    return true;
+}
+
+void PosixHttp::Close() {
+    transport_.Disconnect();
+}
+
+int PosixHttp::GetStatusCode() const {
+    return status_code_;
+}
+
+std::string PosixHttp::GetResponseHeader(const std::string& key) const {
+    auto it = response_headers_.find(ToLower(key));
+    if (it == response_headers_.end()) {
+        return "";
+    }
+    return it->second;
+}
+
+size_t PosixHttp::GetBodyLength() const {
+    return body_.size();
+}
+
+const std::string& PosixHttp::GetBody() {
+    return body_;
+}
+
+int PosixHttp::Read(char* buffer, size_t buffer_size) {
+    size_t size = std::min(buffer_size, body_.size() - read_offset_);
+    memcpy(buffer, body_.data() + read_offset_, size);
+    read_offset_ += size;
+    return size;
+}
@@ -0,0 +1,90 @@
+#include "posix_udp.h"
+
+#include <esp_log.h>
+
+#include <netdb.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <cstring>
+
+#define TAG "PosixUdp"
+
+PosixUdp::PosixUdp() {
+}
+
+PosixUdp::~PosixUdp() {
+    Disconnect();
+}
+
+bool PosixUdp::Connect(const std::string& host, int port) {
+    struct addrinfo hints = {};
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_DGRAM;
+    struct addrinfo* result = nullptr;
+    auto port_str = std::to_string(port);
+    if (getaddrinfo(host.c_str(), port_str.c_str(), &hints, &result) != 0) {
+        ESP_LOGE(TAG, "Failed to resolve %s", host.c_str());
+        return false;
+    }
+
+    fd_ = socket(result->ai_family, result->ai_socktype, result->ai_protocol);
+    if (fd_ < 0 || connect(fd_, result->ai_addr, result->ai_addrlen) != 0) {
+        ESP_LOGE(TAG, "Failed to connect to %s:%d", host.c_str(), port);
+        freeaddrinfo(result);
+        Disconnect();
+        return false;
+    }
+    freeaddrinfo(result);
+    connected_ = true;
+
+    receiving_ = true;
+    xTaskCreate([](void* arg) {
+        auto udp = (PosixUdp*)arg;
+        udp->ReceiveTask();
+        udp->receiving_ = false;
+        vTaskDelete(NULL);
+    }, "udp_receive", 4096, this, 1, nullptr);
+    return true;
+}
+
+void PosixUdp::Disconnect() {
+    connected_ = false;
+    // 等待接收任务看到 connected_ 变化后退出
+    while (receiving_) {
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+    if (fd_ >= 0) {
+        close(fd_);
+        fd_ = -1;
+    }
+}
+
+int PosixUdp::Send(const std::string& data) {
+    if (fd_ < 0) {
+        return -1;
+    }
+    int ret = send(fd_, data.data(), data.size(), 0);
+    if (ret < 0) {
+        ESP_LOGE(TAG, "Send failed: %s", strerror(errno));
+    }
+    return ret;
+}
+
+void PosixUdp::ReceiveTask() {
+    std::string buffer(1500, '\0');
+    while (connected_) {
+        struct pollfd pfd = { fd_, POLLIN, 0 };
+        if (poll(&pfd, 1, 0) <= 0) {
+            vTaskDelay(pdMS_TO_TICKS(5));
+            continue;
+        }
+        int ret = recv(fd_, buffer.data(), buffer.size(), 0);
+        if (ret <= 0) {
+            continue;
+        }
+        if (message_callback_) {
+            message_callback_(buffer.substr(0, ret));
+        }
+    }
+}
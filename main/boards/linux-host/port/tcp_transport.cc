@@ -0,0 +1,104 @@
+#include "tcp_transport.h"
+
+#include <esp_log.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include <netdb.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/tcp.h>
+#include <cstring>
+#include <string>
+
+#define TAG "TcpTransport"
+
+TcpTransport::TcpTransport() {
+}
+
+TcpTransport::~TcpTransport() {
+    Disconnect();
+}
+
+bool TcpTransport::Connect(const char* host, int port) {
+    struct addrinfo hints = {};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    struct addrinfo* result = nullptr;
+    auto port_str = std::to_string(port);
+    if (getaddrinfo(host, port_str.c_str(), &hints, &result) != 0) {
+        ESP_LOGE(TAG, "Failed to resolve %s", host);
+        return false;
+    }
+
+    for (auto ai = result; ai != nullptr; ai = ai->ai_next) {
+        fd_ = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+        if (fd_ < 0) {
+            continue;
+        }
+        if (connect(fd_, ai->ai_addr, ai->ai_addrlen) == 0) {
+            break;
+        }
+        close(fd_);
+        fd_ = -1;
+    }
+    freeaddrinfo(result);
+
+    if (fd_ < 0) {
+        ESP_LOGE(TAG, "Failed to connect to %s:%d", host, port);
+        return false;
+    }
+
+    int flag = 1;
+    setsockopt(fd_, IPPROTO_TCP, TCP_NODELAY, &flag, sizeof(flag));
+    connected_ = true;
+    return true;
+}
+
+void TcpTransport::Disconnect() {
+    if (fd_ >= 0) {
+        shutdown(fd_, SHUT_RDWR);
+        close(fd_);
+        fd_ = -1;
+    }
+    connected_ = false;
+}
+
+int TcpTransport::Send(const char* data, size_t length) {
+    if (fd_ < 0) {
+        return -1;
+    }
+    size_t total = 0;
+    while (total < length) {
+        int ret = send(fd_, data + total, length - total, MSG_NOSIGNAL);
+        if (ret <= 0) {
+            ESP_LOGE(TAG, "Send failed: %s", strerror(errno));
+            connected_ = false;
+            return -1;
+        }
+        total += ret;
+    }
+    return total;
+}
+
+int TcpTransport::Receive(char* buffer, size_t bufferSize) {
+    // FreeRTOS POSIX 移植中阻塞的系统调用会卡住调度器，这里轮询并让出 CPU
+    while (fd_ >= 0) {
+        struct pollfd pfd = { fd_, POLLIN, 0 };
+        int ret = poll(&pfd, 1, 0);
+        if (ret < 0 && errno != EINTR) {
+            break;
+        }
+        if (ret > 0) {
+            int received = recv(fd_, buffer, bufferSize, 0);
+            if (received <= 0) {
+                connected_ = false;
+            }
+            return received;
+        }
+        vTaskDelay(pdMS_TO_TICKS(5));
+    }
+    connected_ = false;
+    return -1;
+}
@@ -0,0 +1,265 @@
+#include "web_socket.h"
+
+#include <esp_log.h>
+#include <esp_random.h>
+#include <mbedtls/base64.h>
+
+#include <cstring>
+#include <vector>
+
+#define TAG "WebSocket"
+
+WebSocket::WebSocket(Transport *transport) : transport_(transport) {
+}
+
+WebSocket::~WebSocket() {
+    Close();
+    delete transport_;
+}
+
+void WebSocket::SetHeader(const char* key, const char* value) {
+    headers_[key] = value;
+}
+
+bool WebSocket::IsConnected() const {
+    return transport_->connected();
+}
+
+bool WebSocket::Connect(const char* uri) {
+    // 解析 ws://host[:port]/path
+    std::string url = uri;
+    if (url.find("ws://") != 0) {
+        ESP_LOGE(TAG, "Only ws:// is supported on host: %s", uri);
+        return false;
+    }
+    url = url.substr(5);
+    std::string path = "/";
+    auto slash = url.find('/');
+    if (slash != std::string::npos) {
+        path = url.substr(slash);
+        url = url.substr(0, slash);
+    }
+    std::string host = url;
+    int port = 80;
+    auto colon = url.find(':');
+    if (colon != std::string::npos) {
+        host = url.substr(0, colon);
+        port = std::stoi(url.substr(colon + 1));
+    }
+
+    if (!transport_->Connect(host.c_str(), port)) {
+        return false;
+    }
+
+    uint8_t key[16];
+    esp_fill_random(key, sizeof(key));
+    unsigned char key_base64[32];
+    size_t key_base64_len = 0;
+    mbedtls_base64_encode(key_base64, sizeof(key_base64), &key_base64_len, key, sizeof(key));
+
+    std::string request = "GET " + path + " HTTP/1.1\r\n";
+    request += "Host: " + url + "\r\n";
+    request += "Upgrade: websocket\r\n";
+    request += "Connection: Upgrade\r\n";
+    request += "Sec-WebSocket-Key: " + std::string((char*)key_base64, key_base64_len) + "\r\n";
+    request += "Sec-WebSocket-Version: 13\r\n";
+    for (const auto& header : headers_) {
+        request += header.first + ": " + header.second + "\r\n";
+    }
+    request += "\r\n";
+    if (!SendAll(request.data(), request.size())) {
+        return false;
+    }
+
+    // 读取握手响应，多读到的数据留给接收任务
+    std::string response;
+    char buffer[512];
+    while (response.find("\r\n\r\n") == std::string::npos) {
+        int ret = transport_->Receive(buffer, sizeof(buffer));
+        if (ret <= 0) {
+            ESP_LOGE(TAG, "Handshake failed: connection closed");
+            transport_->Disconnect();
+            return false;
+        }
+        response.append(buffer, ret);
+    }
+    auto header_end = response.find("\r\n\r\n") + 4;
+    if (response.compare(0, 12, "HTTP/1.1 101") != 0) {
+        ESP_LOGE(TAG, "Handshake failed: %s", response.substr(0, response.find("\r\n")).c_str());
+        transport_->Disconnect();
+        return false;
+    }
+    pending_ = response.substr(header_end);
+
+    receiving_ = true;
+    xTaskCreate([](void* arg) {
+        auto ws = (WebSocket*)arg;
+        ws->ReceiveTask();
+        ws->receiving_ = false;
+        vTaskDelete(NULL);
+    }, "websocket", 4096 * 2, this, 1, nullptr);
+
+    if (on_connected_) {
+        on_connected_();
+    }
+    return true;
+}
+
+bool WebSocket::Send(const std::string& data) {
+    return Send(data.data(), data.size(), false);
+}
+
+bool WebSocket::Send(const void* data, size_t len, bool binary, bool fin) {
+    return SendFrame(binary ? 0x2 : 0x1, data, len, fin);
+}
+
+void WebSocket::Ping() {
+    SendFrame(0x9, nullptr, 0, true);
+}
+
+void WebSocket::Close() {
+    if (transport_->connected()) {
+        SendFrame(0x8, nullptr, 0, true);
+    }
+    transport_->Disconnect();
+    while (receiving_) {
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+}
+
+void WebSocket::OnConnected(std::function<void()> callback) {
+    on_connected_ = callback;
+}
+
+void WebSocket::OnDisconnected(std::function<void()> callback) {
+    on_disconnected_ = callback;
+}
+
+void WebSocket::OnData(std::function<void(const char*, size_t, bool binary)> callback) {
+    on_data_ = callback;
+}
+
+void WebSocket::OnError(std::function<void(int)> callback) {
+    on_error_ = callback;
+}
+
+bool WebSocket::SendAll(const char* data, size_t len) {
+    return transport_->Send(data, len) == (int)len;
+}
+
+bool WebSocket::SendFrame(uint8_t opcode, const void* data, size_t len, bool fin) {
+    // 客户端发出的帧必须加掩码
+    std::vector<char> frame;
+    frame.reserve(len + 14);
+    frame.push_back((fin ? 0x80 : 0x00) | opcode);
+    if (len < 126) {
+        frame.push_back(0x80 | len);
+    } else if (len < 65536) {
+        frame.push_back(0x80 | 126);
+        frame.push_back((len >> 8) & 0xFF);
+        frame.push_back(len & 0xFF);
+    } else {
+        frame.push_back(0x80 | 127);
+        for (int i = 7; i >= 0; i--) {
+            frame.push_back(((uint64_t)len >> (i * 8)) & 0xFF);
+        }
+    }
+    uint8_t mask[4];
+    esp_fill_random(mask, sizeof(mask));
+    frame.insert(frame.end(), mask, mask + 4);
+    auto payload = (const uint8_t*)data;
+    for (size_t i = 0; i < len; i++) {
+        frame.push_back(payload[i] ^ mask[i % 4]);
+    }
+
+    std::lock_guard<std::mutex> lock(send_mutex_);
+    return SendAll(frame.data(), frame.size());
+}
+
+bool WebSocket::ReceiveExact(char* data, size_t len) {
+    size_t offset = 0;
+    if (!pending_.empty()) {
+        offset = std::min(len, pending_.size());
+        memcpy(data, pending_.data(), offset);
+        pending_.erase(0, offset);
+    }
+    while (offset < len) {
+        int ret = transport_->Receive(data + offset, len - offset);
+        if (ret <= 0) {
+            return false;
+        }
+        offset += ret;
+    }
+    return true;
+}
+
+void WebSocket::ReceiveTask() {
+    std::string message;
+    bool message_binary = false;
+
+    while (true) {
+        uint8_t header[2];
+        if (!ReceiveExact((char*)header, sizeof(header))) {
+            break;
+        }
+        bool fin = header[0] & 0x80;
+        uint8_t opcode = header[0] & 0x0F;
+        bool masked = header[1] & 0x80;
+        uint64_t length = header[1] & 0x7F;
+        if (length == 126) {
+            uint8_t ext[2];
+            if (!ReceiveExact((char*)ext, sizeof(ext))) {
+                break;
+            }
+            length = (ext[0] << 8) | ext[1];
+        } else if (length == 127) {
+            uint8_t ext[8];
+            if (!ReceiveExact((char*)ext, sizeof(ext))) {
+                break;
+            }
+            length = 0;
+            for (int i = 0; i < 8; i++) {
+                length = (length << 8) | ext[i];
+            }
+        }
+        uint8_t mask[4] = {0};
+        if (masked && !ReceiveExact((char*)mask, sizeof(mask))) {
+            break;
+        }
+        std::string payload(length, '\0');
+        if (length > 0 && !ReceiveExact(payload.data(), length)) {
+            break;
+        }
+        if (masked) {
+            for (size_t i = 0; i < payload.size(); i++) {
+                payload[i] ^= mask[i % 4];
+            }
+        }
+
+        if (opcode == 0x8) {
+            ESP_LOGI(TAG, "Received close frame");
+            break;
+        } else if (opcode == 0x9) {
+            SendFrame(0xA, payload.data(), payload.size(), true);
+        } else if (opcode == 0xA) {
+            continue;
+        } else {
+            if (opcode != 0x0) {
+                message_binary = opcode == 0x2;
+                message.clear();
+            }
+            message += payload;
+            if (fin) {
+                if (on_data_) {
+                    on_data_(message.data(), message.size(), message_binary);
+                }
+                message.clear();
+            }
+        }
+    }
+
+    transport_->Disconnect();
+    if (on_disconnected_) {
+        on_disconnected_();
+    }
+}
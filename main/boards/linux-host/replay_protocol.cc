@@ -0,0 +1,220 @@
+#include "replay_protocol.h"
+#include "application.h"
+#include "config.h"
+
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include <sys/resource.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#define TAG "ReplayProtocol"
+
+// 录制时 WakeWordInvoke 会在同一调用里再记录一次 toggle，回放 wake 时跳过紧随其后的 toggle
+#define WAKE_TOGGLE_WINDOW_US 10000
+// 最后一条记录之后继续运行的时间，让解码和播放排空
+#define DRAIN_TIME_MS 1000
+
+ReplayProtocol::ReplayProtocol(float speed) : speed_(speed > 0 ? speed : 1.0f) {
+}
+
+bool ReplayProtocol::Load(const std::string& path) {
+    FILE* file = fopen(path.c_str(), "rb");
+    if (file == nullptr) {
+        ESP_LOGE(TAG, "Failed to open %s", path.c_str());
+        return false;
+    }
+    if (fread(&header_, sizeof(header_), 1, file) != 1 || header_.magic != SESSION_LOG_MAGIC) {
+        ESP_LOGE(TAG, "Invalid session log %s", path.c_str());
+        fclose(file);
+        return false;
+    }
+    if (header_.version != SESSION_LOG_VERSION) {
+        ESP_LOGE(TAG, "Unsupported session log version %d", header_.version);
+        fclose(file);
+        return false;
+    }
+
+    int64_t time_us = 0;
+    SessionRecordHeader record;
+    while (fread(&record, sizeof(record), 1, file) == 1) {
+        Event event;
+        event.type = (SessionEventType)record.type;
+        time_us += record.delta_us;
+        event.time_us = time_us;
+        event.payload.resize(record.payload_size);
+        if (record.payload_size > 0 && fread(event.payload.data(), 1, record.payload_size, file) != record.payload_size) {
+            ESP_LOGW(TAG, "Truncated record at %lld us", (long long)time_us);
+            break;
+        }
+        if (event.type == kSessionEventChannelOpened && event.payload.size() >= sizeof(uint32_t)) {
+            uint32_t sample_rate;
+            memcpy(&sample_rate, event.payload.data(), sizeof(sample_rate));
+            server_sample_rates_.push_back(sample_rate);
+        }
+        events_.emplace_back(std::move(event));
+    }
+    fclose(file);
+
+    ESP_LOGI(TAG, "Loaded %s: %zu records, %.1f seconds, input %lu Hz x%d, output %lu Hz",
+        path.c_str(), events_.size(), time_us / 1000000.0, (unsigned long)header_.input_sample_rate,
+        header_.input_channels, (unsigned long)header_.output_sample_rate);
+    return true;
+}
+
+void ReplayProtocol::Start() {
+    xTaskCreate([](void* arg) {
+        auto protocol = (ReplayProtocol*)arg;
+        protocol->Run();
+        vTaskDelete(NULL);
+    }, "session_replay", 4096 * 2, this, 5, nullptr);
+}
+
+void ReplayProtocol::Run() {
+    // 等待 Application 进入空闲状态，与录制时的起点对齐
+    auto& app = Application::GetInstance();
+    while (app.GetDeviceState() == kDeviceStateStarting) {
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+
+    int64_t wake_time_us = -1;
+    int64_t start_us = esp_timer_get_time();
+    for (auto& event : events_) {
+        int64_t wait_us = start_us + (int64_t)(event.time_us / speed_) - esp_timer_get_time();
+        if (wait_us >= 1000) {
+            vTaskDelay(pdMS_TO_TICKS(wait_us / 1000));
+        }
+
+        if (event.type == kSessionEventCommand) {
+            std::string command(event.payload.begin(), event.payload.end());
+            if (command == "toggle" && wake_time_us >= 0 && event.time_us - wake_time_us < WAKE_TOGGLE_WINDOW_US) {
+                wake_time_us = -1;
+                continue;
+            }
+            wake_time_us = command.rfind("wake ", 0) == 0 ? event.time_us : -1;
+        }
+        Dispatch(event);
+    }
+
+    vTaskDelay(pdMS_TO_TICKS(DRAIN_TIME_MS / speed_));
+    Report(esp_timer_get_time() - start_us);
+    if (on_finished_) {
+        on_finished_();
+    }
+}
+
+void ReplayProtocol::Dispatch(const Event& event) {
+    auto& app = Application::GetInstance();
+    switch (event.type) {
+    case kSessionEventMicFrame:
+        if (codec_ != nullptr) {
+            std::vector<int16_t> frame(event.payload.size() / sizeof(int16_t));
+            memcpy(frame.data(), event.payload.data(), frame.size() * sizeof(int16_t));
+            codec_->PushInput(std::move(frame));
+        }
+        break;
+    case kSessionEventIncomingJson: {
+        std::string text(event.payload.begin(), event.payload.end());
+        auto root = cJSON_Parse(text.c_str());
+        if (root == nullptr) {
+            ESP_LOGW(TAG, "Invalid recorded JSON: %s", text.c_str());
+            break;
+        }
+        if (on_incoming_json_ != nullptr) {
+            on_incoming_json_(root);
+        }
+        cJSON_Delete(root);
+        break;
+    }
+    case kSessionEventIncomingAudio:
+        if (on_incoming_audio_ != nullptr) {
+            on_incoming_audio_(std::vector<uint8_t>(event.payload));
+        }
+        break;
+    case kSessionEventChannelClosed:
+        // 录制时由服务器关闭的通道；设备自己关闭时通道在这里已经是关闭状态
+        if (channel_opened_.exchange(false) && on_audio_channel_closed_ != nullptr) {
+            on_audio_channel_closed_();
+        }
+        break;
+    case kSessionEventCommand: {
+        std::string command(event.payload.begin(), event.payload.end());
+        ESP_LOGI(TAG, "Command: %s", command.c_str());
+        if (command == "toggle") {
+            app.ToggleChatState();
+        } else if (command == "start") {
+            app.StartListening();
+        } else if (command == "stop") {
+            app.StopListening();
+        } else if (command.rfind("wake ", 0) == 0) {
+            app.WakeWordInvoke(command.substr(5));
+        }
+        break;
+    }
+    default:
+        // 通道打开由 OpenAudioChannel 消费，状态变化只用于离线比较
+        break;
+    }
+}
+
+void ReplayProtocol::Report(int64_t wall_us) {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    int64_t user_us = (int64_t)usage.ru_utime.tv_sec * 1000000 + usage.ru_utime.tv_usec;
+    int64_t system_us = (int64_t)usage.ru_stime.tv_sec * 1000000 + usage.ru_stime.tv_usec;
+    int64_t session_us = events_.empty() ? 0 : events_.back().time_us;
+
+    char report[512];
+    snprintf(report, sizeof(report),
+        "{\"version\":1,\"board\":\"%s\",\"records\":%zu,\"speed\":%.2f,\"session_ms\":%lld,\"wall_ms\":%lld,"
+        "\"cpu_user_ms\":%lld,\"cpu_system_ms\":%lld,\"sent_audio_packets\":%lu,\"sent_json_messages\":%lu}",
+        BOARD_NAME, events_.size(), speed_, (long long)(session_us / 1000), (long long)(wall_us / 1000),
+        (long long)(user_us / 1000), (long long)(system_us / 1000),
+        (unsigned long)sent_audio_packets_.load(), (unsigned long)sent_json_messages_.load());
+
+    auto path = getenv(HOST_REPLAY_REPORT_ENV);
+    FILE* file = path != nullptr ? fopen(path, "w") : nullptr;
+    if (file != nullptr) {
+        fprintf(file, "%s\n", report);
+        fclose(file);
+        ESP_LOGI(TAG, "Replay report written to %s", path);
+    } else {
+        printf("SESSION_REPLAY_REPORT %s\n", report);
+    }
+}
+
+CoTask<bool> ReplayProtocol::OpenAudioChannel() {
+    // 网络握手不在回放范围内，通道立即打开，采样率取录制时服务器返回的值
+    if (!server_sample_rates_.empty()) {
+        server_sample_rate_ = server_sample_rates_.front();
+        server_sample_rates_.pop_front();
+    }
+    channel_opened_ = true;
+    if (on_audio_channel_opened_ != nullptr) {
+        on_audio_channel_opened_();
+    }
+    co_return true;
+}
+
+void ReplayProtocol::CloseAudioChannel() {
+    if (channel_opened_.exchange(false) && on_audio_channel_closed_ != nullptr) {
+        on_audio_channel_closed_();
+    }
+}
+
+bool ReplayProtocol::IsAudioChannelOpened() const {
+    return channel_opened_;
+}
+
+void ReplayProtocol::SendAudio(const std::vector<uint8_t>& data) {
+    sent_audio_packets_++;
+}
+
+void ReplayProtocol::SendText(const std::string& text) {
+    ESP_LOGD(TAG, "Send: %s", text.c_str());
+    sent_json_messages_++;
+}
@@ -0,0 +1,54 @@
+#ifndef _REPLAY_PROTOCOL_H_
+#define _REPLAY_PROTOCOL_H_
+
+#include "protocol.h"
+#include "session_recorder.h"
+#include "file_audio_codec.h"
+
+#include <vector>
+#include <deque>
+#include <atomic>
+#include <functional>
+
+// 按录制的时间线把会话日志送回 Application：麦克风帧进入 FileAudioCodec，下行消息走协议回调，
+// 用户操作直接调用 Application，上行数据只计数不发送
+class ReplayProtocol : public Protocol {
+public:
+    ReplayProtocol(float speed);
+
+    bool Load(const std::string& path);
+    inline const SessionLogHeader& header() const { return header_; }
+    void SetAudioCodec(FileAudioCodec* codec) { codec_ = codec; }
+    // 回放结束并输出报告后调用
+    void OnFinished(std::function<void()> callback) { on_finished_ = callback; }
+
+    virtual void Start() override;
+    virtual CoTask<bool> OpenAudioChannel() override;
+    virtual void CloseAudioChannel() override;
+    virtual bool IsAudioChannelOpened() const override;
+    virtual void SendAudio(const std::vector<uint8_t>& data) override;
+
+private:
+    struct Event {
+        SessionEventType type;
+        int64_t time_us;
+        std::vector<uint8_t> payload;
+    };
+
+    SessionLogHeader header_ = {};
+    std::vector<Event> events_;
+    std::deque<int> server_sample_rates_;
+    FileAudioCodec* codec_ = nullptr;
+    float speed_;
+    std::atomic<bool> channel_opened_ = false;
+    std::atomic<uint32_t> sent_audio_packets_ = 0;
+    std::atomic<uint32_t> sent_json_messages_ = 0;
+    std::function<void()> on_finished_;
+
+    void Run();
+    void Dispatch(const Event& event);
+    void Report(int64_t wall_us);
+    virtual void SendText(const std::string& text) override;
+};
+
+#endif // _REPLAY_PROTOCOL_H_
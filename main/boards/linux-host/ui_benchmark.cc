@@ -0,0 +1,257 @@
+#include "ui_benchmark.h"
+#include "lcd_display.h"
+#include "oled_display.h"
+
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <esp_lvgl_port.h>
+#include <cJSON.h>
+
+#include <ctime>
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+#include <utility>
+
+#define TAG "UiBenchmark"
+
+// 每个操作之后推进的虚拟时间，足够完成布局和几次刷新
+#define SETTLE_MS 100
+
+LV_FONT_DECLARE(font_puhui_16_4);
+LV_FONT_DECLARE(font_awesome_16_4);
+LV_FONT_DECLARE(font_puhui_14_1);
+LV_FONT_DECLARE(font_awesome_14_1);
+
+// 覆盖各板子的屏幕尺寸
+static const UiBenchmarkTarget kTargets[] = {
+    {"lcd_240x240", false, 240, 240, {}},
+    {"lcd_240x320", false, 240, 320, {}},
+    {"lcd_320x240", false, 320, 240, {}},
+    {"lcd_360x360", false, 360, 360, {}},
+    {"lcd_412x412", false, 412, 412, {}},
+    {"oled_128x64", true, 128, 64, {}},
+    {"oled_128x32", true, 128, 32, {}},
+};
+
+// 模拟一次完整对话：待命、聆听、回复、通知、切换主题
+static const char* kDefaultScript =
+    "theme light\n"
+    "status 待命\n"
+    "emotion neutral\n"
+    "idle 1000\n"
+    "snapshot standby\n"
+    "status 聆听中...\n"
+    "chat user 今天天气怎么样？\n"
+    "status 说话中...\n"
+    "emotion happy\n"
+    "chat assistant 今天天气晴朗，气温二十度左右，适合出门散步。\n"
+    "idle 500\n"
+    "snapshot speaking\n"
+    "notify 音量 80\n"
+    "emotion thinking\n"
+    "chat assistant 这是一条比较长的回复，用来测试多行文本的排版和滚动，在小屏幕上会换行或者滚动显示，直到整段文字都显示完为止。\n"
+    "idle 3000\n"
+    "chat system 网络已连接\n"
+    "theme dark\n"
+    "snapshot dark\n"
+    "status 待命\n"
+    "emotion sleepy\n"
+    "idle 1000\n";
+
+// 关闭 Display 基类的电量/网络刷新定时器和通知定时器，保证每次运行的画面一致
+template <typename Base>
+class HeadlessDisplay : public Base {
+public:
+    template <typename... Args>
+    HeadlessDisplay(Args&&... args) : Base(std::forward<Args>(args)...) {
+        Quiesce();
+    }
+
+    void Quiesce() {
+        esp_timer_stop(this->update_timer_);
+        esp_timer_stop(this->notification_timer_);
+    }
+};
+
+static int64_t ThreadCpuTimeUs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static int CountObjects(lv_obj_t* obj) {
+    int count = 1;
+    uint32_t child_count = lv_obj_get_child_count(obj);
+    for (uint32_t i = 0; i < child_count; i++) {
+        count += CountObjects(lv_obj_get_child(obj, i));
+    }
+    return count;
+}
+
+UiBenchmark::UiBenchmark(const std::string& script, const char* snapshot_dir)
+    : script_(script.empty() ? kDefaultScript : script), snapshot_dir_(snapshot_dir != nullptr ? snapshot_dir : "") {
+    targets_.assign(std::begin(kTargets), std::end(kTargets));
+}
+
+UiBenchmarkStep UiBenchmark::Measure(const std::string& name, const std::function<void()>& update, uint32_t settle_ms) {
+    lvgl_port_host_stats_t stats;
+    lvgl_port_host_get_stats(&stats, true);
+
+    UiBenchmarkStep step = {};
+    step.name = name;
+    auto start = ThreadCpuTimeUs();
+    update();
+    step.update_us = ThreadCpuTimeUs() - start;
+    if (quiesce_) {
+        quiesce_();
+    }
+
+    start = ThreadCpuTimeUs();
+    lvgl_port_host_advance(settle_ms);
+    step.render_us = ThreadCpuTimeUs() - start;
+
+    lvgl_port_host_get_stats(&stats, true);
+    step.flushes = stats.flushes;
+    step.flushed_pixels = stats.flushed_pixels;
+    step.changed_pixels = stats.changed_pixels;
+
+    lvgl_port_lock(0);
+    step.objects = CountObjects(lv_screen_active()) + CountObjects(lv_layer_top()) + CountObjects(lv_layer_sys());
+    lv_mem_monitor_t monitor;
+    lv_mem_monitor(&monitor);
+    step.heap_used = monitor.total_size - monitor.free_size;
+    step.heap_peak = monitor.max_used;
+    lvgl_port_unlock();
+
+    ESP_LOGI(TAG, "%-28s update %6d us  render %6d us  changed %7d px  objects %d", name.c_str(),
+        (int)step.update_us, (int)step.render_us, (int)step.changed_pixels, step.objects);
+    return step;
+}
+
+void UiBenchmark::RunOperation(Display* display, UiBenchmarkTarget& target, int index, const std::string& op, const std::string& arg) {
+    char name[32];
+    snprintf(name, sizeof(name), "%02d_%s", index, op.c_str());
+
+    if (op == "status") {
+        target.steps.push_back(Measure(name, [&]() { display->SetStatus(arg.c_str()); }, SETTLE_MS));
+    } else if (op == "notify") {
+        target.steps.push_back(Measure(name, [&]() { display->ShowNotification(arg); }, SETTLE_MS));
+    } else if (op == "emotion") {
+        target.steps.push_back(Measure(name, [&]() { display->SetEmotion(arg.c_str()); }, SETTLE_MS));
+    } else if (op == "chat") {
+        auto space = arg.find(' ');
+        auto role = arg.substr(0, space);
+        auto content = space == std::string::npos ? std::string() : arg.substr(space + 1);
+        target.steps.push_back(Measure(name, [&]() { display->SetChatMessage(role.c_str(), content.c_str()); }, SETTLE_MS));
+#if CONFIG_USE_STREAMING_TEXT
+    } else if (op == "stream") {
+        // 主机上没有下行音频，播放位置不前进，等待超时后整句显示
+        target.steps.push_back(Measure(name, [&]() { display->AppendChatMessage(arg.c_str(), 0); }, SETTLE_MS));
+#endif
+    } else if (op == "theme") {
+        target.steps.push_back(Measure(name, [&]() { display->SetTheme(arg); }, SETTLE_MS));
+    } else if (op == "idle") {
+        target.steps.push_back(Measure(name, []() {}, atoi(arg.c_str())));
+    } else if (op == "snapshot") {
+        if (snapshot_dir_.empty()) {
+            return;
+        }
+        auto path = snapshot_dir_ + "/" + target.name + "_" + arg + ".png";
+        if (lvgl_port_host_save_png(path.c_str())) {
+            ESP_LOGI(TAG, "Snapshot saved to %s", path.c_str());
+        }
+    } else {
+        ESP_LOGW(TAG, "Unknown operation: %s", op.c_str());
+    }
+}
+
+void UiBenchmark::RunTarget(UiBenchmarkTarget& target) {
+    ESP_LOGI(TAG, "Running %s", target.name);
+    Display* display = nullptr;
+    const lv_font_t* emoji_font = nullptr;
+    target.steps.push_back(Measure("00_setup", [&]() {
+        if (target.oled) {
+            auto oled = new HeadlessDisplay<OledDisplay>(nullptr, nullptr, target.width, target.height, false, false,
+                DisplayFonts{&font_puhui_14_1, &font_awesome_14_1});
+            quiesce_ = [oled]() { oled->Quiesce(); };
+            display = oled;
+        } else {
+            emoji_font = target.height >= 240 ? font_emoji_64_init() : font_emoji_32_init();
+            auto lcd = new HeadlessDisplay<SpiLcdDisplay>(nullptr, nullptr, target.width, target.height, 0, 0,
+                false, false, false, DisplayFonts{&font_puhui_16_4, &font_awesome_16_4, emoji_font});
+            quiesce_ = [lcd]() { lcd->Quiesce(); };
+            display = lcd;
+        }
+    }, SETTLE_MS));
+
+    std::istringstream stream(script_);
+    std::string line;
+    int index = 1;
+    while (std::getline(stream, line)) {
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        auto space = line.find(' ');
+        auto op = line.substr(0, space);
+        auto arg = space == std::string::npos ? std::string() : line.substr(space + 1);
+        RunOperation(display, target, index++, op, arg);
+    }
+
+    quiesce_ = nullptr;
+    delete display;
+    // 表情字体在 LVGL 堆中分配，使用它的显示删除后释放，不计入下一个分辨率的堆用量
+    if (emoji_font != nullptr) {
+        lvgl_port_lock(0);
+        lv_imgfont_destroy(const_cast<lv_font_t*>(emoji_font));
+        lvgl_port_unlock();
+    }
+}
+
+std::string UiBenchmark::Run() {
+    // LVGL 只初始化一次，OledDisplay 析构时只删除它的显示
+    lvgl_port_cfg_t port_cfg = ESP_LVGL_PORT_INIT_CONFIG();
+    lvgl_port_init(&port_cfg);
+    lvgl_port_host_keep_initialized(true);
+    for (auto& target : targets_) {
+        RunTarget(target);
+    }
+    lvgl_port_host_keep_initialized(false);
+    return ToJson();
+}
+
+std::string UiBenchmark::ToJson() {
+    cJSON* root = cJSON_CreateObject();
+    cJSON_AddStringToObject(root, "target", CONFIG_IDF_TARGET);
+    cJSON_AddStringToObject(root, "board", BOARD_NAME);
+    cJSON* targets = cJSON_CreateArray();
+    for (auto& target : targets_) {
+        cJSON* item = cJSON_CreateObject();
+        cJSON_AddStringToObject(item, "name", target.name);
+        cJSON_AddNumberToObject(item, "width", target.width);
+        cJSON_AddNumberToObject(item, "height", target.height);
+        cJSON* steps = cJSON_CreateArray();
+        for (auto& step : target.steps) {
+            cJSON* entry = cJSON_CreateObject();
+            cJSON_AddStringToObject(entry, "name", step.name.c_str());
+            cJSON_AddNumberToObject(entry, "update_us", step.update_us);
+            cJSON_AddNumberToObject(entry, "render_us", step.render_us);
+            cJSON_AddNumberToObject(entry, "objects", step.objects);
+            cJSON_AddNumberToObject(entry, "heap_used", step.heap_used);
+            cJSON_AddNumberToObject(entry, "heap_peak", step.heap_peak);
+            cJSON_AddNumberToObject(entry, "flushes", step.flushes);
+            cJSON_AddNumberToObject(entry, "flushed_pixels", step.flushed_pixels);
+            cJSON_AddNumberToObject(entry, "changed_pixels", step.changed_pixels);
+            cJSON_AddItemToArray(steps, entry);
+        }
+        cJSON_AddItemToObject(item, "steps", steps);
+        cJSON_AddItemToArray(targets, item);
+    }
+    cJSON_AddItemToObject(root, "targets", targets);
+
+    auto json = cJSON_PrintUnformatted(root);
+    std::string result(json);
+    cJSON_free(json);
+    cJSON_Delete(root);
+    return result;
+}
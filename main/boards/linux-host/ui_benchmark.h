@@ -0,0 +1,63 @@
+#ifndef UI_BENCHMARK_H
+#define UI_BENCHMARK_H
+
+#include <string>
+#include <vector>
+#include <functional>
+#include <cstdint>
+
+class Display;
+
+struct UiBenchmarkStep {
+    std::string name;
+    int64_t update_us;          // 调用 Display 接口的 CPU 时间
+    int64_t render_us;          // 之后 LVGL 定时器和绘制的 CPU 时间
+    int objects;                // 界面上的 LVGL 对象数
+    size_t heap_used;           // LVGL 堆当前用量
+    size_t heap_peak;           // LVGL 堆自初始化以来的峰值
+    uint32_t flushes;
+    uint64_t flushed_pixels;
+    uint64_t changed_pixels;    // 颜色实际发生变化的像素，即重绘中真正有用的部分
+};
+
+struct UiBenchmarkTarget {
+    const char* name;
+    bool oled;
+    int width;
+    int height;
+    std::vector<UiBenchmarkStep> steps;
+};
+
+/*
+ * 界面渲染基准测试：在主机内存帧缓冲区上依次创建各分辨率的 LcdDisplay / OledDisplay，
+ * 回放脚本中的界面操作，记录每步的 CPU 时间、对象数、LVGL 堆用量和变化像素面积。
+ * 时钟为虚拟时钟，结果只取决于脚本和代码，由 scripts/ui_benchmark/check_regression.py 与基线比较
+ *
+ * 脚本每行一个操作，# 开头为注释：
+ *   status <文字>            notify <文字>           emotion <名称>
+ *   chat <角色> <文字>       theme <light|dark>      idle <毫秒>
+ *   snapshot <名称>          保存 PNG 到 XIAOZHI_UI_SNAPSHOT_DIR
+ *   stream <文字>            流式追加助手回复（需要 CONFIG_USE_STREAMING_TEXT）
+ */
+class UiBenchmark {
+public:
+    // script 为空时使用内置脚本
+    UiBenchmark(const std::string& script = "", const char* snapshot_dir = nullptr);
+
+    // 运行全部分辨率并返回 JSON，需要在栈足够大的任务中调用
+    std::string Run();
+
+private:
+    std::string script_;
+    std::string snapshot_dir_;
+    std::vector<UiBenchmarkTarget> targets_;
+    // 停止当前显示的 esp_timer 定时器，界面只由脚本和虚拟时钟驱动
+    std::function<void()> quiesce_;
+
+    void RunTarget(UiBenchmarkTarget& target);
+    void RunOperation(Display* display, UiBenchmarkTarget& target, int index, const std::string& op, const std::string& arg);
+    UiBenchmarkStep Measure(const std::string& name, const std::function<void()>& update, uint32_t settle_ms);
+    std::string ToJson();
+};
+
+#endif // UI_BENCHMARK_H
@@ -0,0 +1,112 @@
+#include "console.h"
+
+#include <esp_log.h>
+#include <cstring>
+#include <vector>
+
+#ifndef CONFIG_IDF_TARGET_LINUX
+#include <esp_console.h>
+#endif
+
+#define TAG "Console"
+
+void Console::RegisterCommand(const std::string& name, const std::string& help, std::function<int(int argc, char** argv)> handler) {
+    if (FindCommand(name.c_str()) != nullptr) {
+        ESP_LOGW(TAG, "Command %s already registered", name.c_str());
+        return;
+    }
+    commands_.push_back({name, help, handler});
+}
+
+Console::Command* Console::FindCommand(const char* name) {
+    for (auto& command : commands_) {
+        if (command.name == name) {
+            return &command;
+        }
+    }
+    return nullptr;
+}
+
+// esp_console 的回调是普通函数指针，通过 argv[0] 找回对应的命令
+int Console::Dispatch(int argc, char** argv) {
+    auto command = GetInstance().FindCommand(argv[0]);
+    if (command == nullptr) {
+        return 1;
+    }
+    return command->handler(argc, argv);
+}
+
+bool Console::Execute(const std::string& line) {
+    std::vector<std::string> args;
+    size_t start = 0;
+    while (start < line.size()) {
+        auto end = line.find(' ', start);
+        if (end == std::string::npos) {
+            end = line.size();
+        }
+        if (end > start) {
+            args.push_back(line.substr(start, end - start));
+        }
+        start = end + 1;
+    }
+    if (args.empty()) {
+        return false;
+    }
+
+    if (args[0] == "help") {
+        for (auto& command : commands_) {
+            printf("%-16s %s\n", command.name.c_str(), command.help.c_str());
+        }
+        return true;
+    }
+
+    auto command = FindCommand(args[0].c_str());
+    if (command == nullptr) {
+        return false;
+    }
+    std::vector<char*> argv;
+    for (auto& arg : args) {
+        argv.push_back(arg.data());
+    }
+    argv.push_back(nullptr);
+    command->handler(args.size(), argv.data());
+    return true;
+}
+
+void Console::Start() {
+#ifndef CONFIG_IDF_TARGET_LINUX
+    if (started_ || commands_.empty()) {
+        return;
+    }
+
+    esp_console_repl_t* repl = nullptr;
+    esp_console_repl_config_t repl_config = ESP_CONSOLE_REPL_CONFIG_DEFAULT();
+    repl_config.prompt = "xiaozhi>";
+    // 命令在 REPL 任务中执行，Opus 编码等命令需要较大的栈
+    repl_config.task_stack_size = 4096 * 8;
+#if defined(CONFIG_ESP_CONSOLE_UART_DEFAULT) || defined(CONFIG_ESP_CONSOLE_UART_CUSTOM)
+    esp_console_dev_uart_config_t hw_config = ESP_CONSOLE_DEV_UART_CONFIG_DEFAULT();
+    ESP_ERROR_CHECK(esp_console_new_repl_uart(&hw_config, &repl_config, &repl));
+#elif defined(CONFIG_ESP_CONSOLE_USB_SERIAL_JTAG)
+    esp_console_dev_usb_serial_jtag_config_t hw_config = ESP_CONSOLE_DEV_USB_SERIAL_JTAG_CONFIG_DEFAULT();
+    ESP_ERROR_CHECK(esp_console_new_repl_usb_serial_jtag(&hw_config, &repl_config, &repl));
+#elif defined(CONFIG_ESP_CONSOLE_USB_CDC)
+    esp_console_dev_usb_cdc_config_t hw_config = ESP_CONSOLE_DEV_CDC_CONFIG_DEFAULT();
+    ESP_ERROR_CHECK(esp_console_new_repl_usb_cdc(&hw_config, &repl_config, &repl));
+#else
+    ESP_LOGW(TAG, "No console device available");
+    return;
+#endif
+
+    ESP_ERROR_CHECK(esp_console_register_help_command());
+    for (auto& command : commands_) {
+        esp_console_cmd_t cmd = {};
+        cmd.command = command.name.c_str();
+        cmd.help = command.help.c_str();
+        cmd.func = &Console::Dispatch;
+        ESP_ERROR_CHECK(esp_console_cmd_register(&cmd));
+    }
+    ESP_ERROR_CHECK(esp_console_start_repl(repl));
+    started_ = true;
+#endif
+}
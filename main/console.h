@@ -0,0 +1,40 @@
+#ifndef CONSOLE_H
+#define CONSOLE_H
+
+#include <string>
+#include <list>
+#include <functional>
+
+// 调试命令的注册中心：设备端挂到 esp_console 的串口 REPL 上，linux-host 由标准输入逐行调用 Execute
+class Console {
+public:
+    static Console& GetInstance() {
+        static Console instance;
+        return instance;
+    }
+    // 删除拷贝构造函数和赋值运算符
+    Console(const Console&) = delete;
+    Console& operator=(const Console&) = delete;
+
+    void RegisterCommand(const std::string& name, const std::string& help, std::function<int(int argc, char** argv)> handler);
+    // 启动串口 REPL，没有注册任何命令时不启动，避免无谓占用串口输入
+    void Start();
+    // 执行一行命令，返回 false 表示命令不存在
+    bool Execute(const std::string& line);
+
+private:
+    Console() = default;
+
+    struct Command {
+        std::string name;
+        std::string help;
+        std::function<int(int argc, char** argv)> handler;
+    };
+    std::list<Command> commands_;
+    bool started_ = false;
+
+    Command* FindCommand(const char* name);
+    static int Dispatch(int argc, char** argv);
+};
+
+#endif // CONSOLE_H
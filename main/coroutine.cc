@@ -0,0 +1,189 @@
+#include "coroutine.h"
+#include "application.h"
+#include "memory_plan.h"
+#include "task_stacks.h"
+
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include <map>
+#include <condition_variable>
+
+#define TAG "Coroutine"
+
+void CoResumeOnMainLoop(std::coroutine_handle<> handle, const CallSite& site) {
+    Application::GetInstance().Schedule([handle]() {
+        handle.resume();
+    }, site);
+}
+
+// 所有协程共用一个 esp_timer，按最早到期的时间重新设置
+namespace {
+
+struct TimerEntry {
+    uint32_t id;
+    std::function<void(uint32_t id)> callback;
+};
+
+std::mutex timer_mutex;
+std::multimap<int64_t, TimerEntry> timers;
+esp_timer_handle_t timer_handle = nullptr;
+uint32_t next_timer_id = 0;
+
+void ArmTimer() {
+    esp_timer_stop(timer_handle);
+    if (!timers.empty()) {
+        int64_t delay = timers.begin()->first - esp_timer_get_time();
+        esp_timer_start_once(timer_handle, delay > 0 ? delay : 0);
+    }
+}
+
+// 在主循环中执行所有到期的定时器
+void ProcessTimers() {
+    std::list<TimerEntry> expired;
+    {
+        std::lock_guard<std::mutex> lock(timer_mutex);
+        auto now = esp_timer_get_time();
+        while (!timers.empty() && timers.begin()->first <= now) {
+            expired.emplace_back(std::move(timers.begin()->second));
+            timers.erase(timers.begin());
+        }
+        ArmTimer();
+    }
+    for (auto& entry : expired) {
+        entry.callback(entry.id);
+    }
+}
+
+std::mutex blocking_mutex;
+std::condition_variable blocking_condition;
+std::list<std::function<void()>> blocking_calls;
+TaskHandle_t blocking_task = nullptr;
+
+} // namespace
+
+uint32_t CoAddTimer(uint32_t delay_ms, std::function<void(uint32_t id)> callback) {
+    std::lock_guard<std::mutex> lock(timer_mutex);
+    if (timer_handle == nullptr) {
+        esp_timer_create_args_t timer_args = {
+            .callback = [](void* arg) {
+                Application::GetInstance().Schedule([]() {
+                    ProcessTimers();
+                });
+            },
+            .arg = nullptr,
+            .dispatch_method = ESP_TIMER_TASK,
+            .name = "coroutine_timer",
+            .skip_unhandled_events = true
+        };
+        ESP_ERROR_CHECK(esp_timer_create(&timer_args, &timer_handle));
+    }
+
+    uint32_t id = ++next_timer_id;
+    int64_t deadline = esp_timer_get_time() + (int64_t)delay_ms * 1000;
+    bool earliest = timers.empty() || deadline < timers.begin()->first;
+    timers.emplace(deadline, TimerEntry{id, std::move(callback)});
+    if (earliest) {
+        ArmTimer();
+    }
+    return id;
+}
+
+void CoCancelTimer(uint32_t id) {
+    std::lock_guard<std::mutex> lock(timer_mutex);
+    for (auto it = timers.begin(); it != timers.end(); ++it) {
+        if (it->second.id == id) {
+            timers.erase(it);
+            return;
+        }
+    }
+}
+
+// 网络连接、HTTP 请求等阻塞调用共用一个任务，不再为每个流程单独创建任务
+void CoPostBlockingCall(std::function<void()> call) {
+    std::lock_guard<std::mutex> lock(blocking_mutex);
+    if (blocking_task == nullptr) {
+        blocking_task = MemoryPlan::GetInstance().CreateTask([](void* arg) {
+            while (true) {
+                std::function<void()> call;
+                {
+                    std::unique_lock<std::mutex> lock(blocking_mutex);
+                    blocking_condition.wait(lock, []() { return !blocking_calls.empty(); });
+                    call = std::move(blocking_calls.front());
+                    blocking_calls.pop_front();
+                }
+                call();
+            }
+        }, "co_blocking", CO_BLOCKING_STACK_SIZE, nullptr, 3);
+    }
+    blocking_calls.emplace_back(std::move(call));
+    blocking_condition.notify_one();
+}
+
+void AsyncEvent::Set(uint32_t bits) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    bits_ |= bits;
+    for (auto it = waiters_.begin(); it != waiters_.end(); ) {
+        auto awaiter = *it;
+        if (awaiter->bits_ & bits_) {
+            awaiter->result_ = awaiter->bits_ & bits_;
+            if (awaiter->timer_id_ != 0) {
+                CoCancelTimer(awaiter->timer_id_);
+            }
+            it = waiters_.erase(it);
+            CoResumeOnMainLoop(awaiter->handle_);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void AsyncEvent::Clear(uint32_t bits) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    bits_ &= ~bits;
+}
+
+uint32_t AsyncEvent::Get() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return bits_;
+}
+
+bool AsyncEvent::AddWaiter(Awaiter* awaiter, std::coroutine_handle<> handle) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (awaiter->bits_ & bits_) {
+        // 已经置位，不挂起
+        awaiter->result_ = awaiter->bits_ & bits_;
+        return false;
+    }
+    awaiter->handle_ = handle;
+    if (awaiter->timeout_ms_ > 0) {
+        awaiter->timer_id_ = CoAddTimer(awaiter->timeout_ms_, [this](uint32_t id) {
+            OnTimeout(id);
+        });
+    }
+    waiters_.push_back(awaiter);
+    return true;
+}
+
+// 按定时器编号查找，Set 已经唤醒的等待者不会再被超时处理
+void AsyncEvent::OnTimeout(uint32_t timer_id) {
+    std::coroutine_handle<> handle;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto it = waiters_.begin(); it != waiters_.end(); ++it) {
+            auto awaiter = *it;
+            if (awaiter->timer_id_ == timer_id) {
+                waiters_.erase(it);
+                awaiter->result_ = 0;
+                handle = awaiter->handle_;
+                break;
+            }
+        }
+    }
+    // 已经在主循环中，直接恢复
+    if (handle) {
+        handle.resume();
+    }
+}
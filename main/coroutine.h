@@ -0,0 +1,226 @@
+#ifndef COROUTINE_H
+#define COROUTINE_H
+
+#include <coroutine>
+#include <optional>
+#include <functional>
+#include <mutex>
+#include <list>
+#include <cstdint>
+#include <cstdlib>
+#include <utility>
+#include <type_traits>
+
+#include "background_task.h"
+#include "stall_detector.h"
+
+/*
+ * 运行在主循环上的 C++20 协程
+ * 协程挂起时只保留堆上的协程帧，不占用任务栈；恢复总是投递到主循环执行，
+ * 所以协程内部可以像普通的 Schedule 回调一样访问 Application 的状态
+ */
+
+// 把协程的恢复投递到主循环，可以在任意任务中调用；site 为协程挂起的位置，卡顿检测据此统计恢复后的耗时
+void CoResumeOnMainLoop(std::coroutine_handle<> handle, const CallSite& site = CallSite::current());
+// 在主循环中 delay_ms 毫秒后调用 callback，返回的编号用于取消
+uint32_t CoAddTimer(uint32_t delay_ms, std::function<void(uint32_t id)> callback);
+void CoCancelTimer(uint32_t id);
+// 在共用的阻塞调用任务中按顺序执行 call
+void CoPostBlockingCall(std::function<void()> call);
+
+// 延迟启动的协程，被 co_await 时才开始执行，结束后恢复等待它的协程
+template <typename T = void>
+class CoTask;
+
+namespace coroutine_detail {
+
+template <typename Promise>
+struct FinalAwaiter {
+    bool await_ready() noexcept { return false; }
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept {
+        auto continuation = handle.promise().continuation;
+        return continuation ? continuation : std::noop_coroutine();
+    }
+    void await_resume() noexcept {}
+};
+
+struct PromiseBase {
+    std::coroutine_handle<> continuation;
+    std::suspend_always initial_suspend() noexcept { return {}; }
+    void unhandled_exception() { abort(); }
+};
+
+} // namespace coroutine_detail
+
+template <typename T>
+class CoTask {
+public:
+    struct promise_type : coroutine_detail::PromiseBase {
+        std::optional<T> value;
+        CoTask get_return_object() { return CoTask(std::coroutine_handle<promise_type>::from_promise(*this)); }
+        coroutine_detail::FinalAwaiter<promise_type> final_suspend() noexcept { return {}; }
+        void return_value(T result) { value = std::move(result); }
+    };
+
+    CoTask(CoTask&& other) noexcept : handle_(std::exchange(other.handle_, nullptr)) {}
+    CoTask(const CoTask&) = delete;
+    CoTask& operator=(const CoTask&) = delete;
+    ~CoTask() {
+        if (handle_) {
+            handle_.destroy();
+        }
+    }
+
+    bool await_ready() const noexcept { return false; }
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> continuation) noexcept {
+        handle_.promise().continuation = continuation;
+        return handle_;
+    }
+    T await_resume() { return std::move(*handle_.promise().value); }
+
+private:
+    std::coroutine_handle<promise_type> handle_;
+    explicit CoTask(std::coroutine_handle<promise_type> handle) : handle_(handle) {}
+};
+
+template <>
+class CoTask<void> {
+public:
+    struct promise_type : coroutine_detail::PromiseBase {
+        CoTask get_return_object() { return CoTask(std::coroutine_handle<promise_type>::from_promise(*this)); }
+        coroutine_detail::FinalAwaiter<promise_type> final_suspend() noexcept { return {}; }
+        void return_void() {}
+    };
+
+    CoTask(CoTask&& other) noexcept : handle_(std::exchange(other.handle_, nullptr)) {}
+    CoTask(const CoTask&) = delete;
+    CoTask& operator=(const CoTask&) = delete;
+    ~CoTask() {
+        if (handle_) {
+            handle_.destroy();
+        }
+    }
+
+    bool await_ready() const noexcept { return false; }
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> continuation) noexcept {
+        handle_.promise().continuation = continuation;
+        return handle_;
+    }
+    void await_resume() {}
+
+private:
+    std::coroutine_handle<promise_type> handle_;
+    explicit CoTask(std::coroutine_handle<promise_type> handle) : handle_(handle) {}
+};
+
+// 不需要等待结果的顶层协程，执行完后自动释放
+struct CoDetached {
+    struct promise_type {
+        CoDetached get_return_object() { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { abort(); }
+    };
+};
+
+// 立即在当前任务中开始执行 task，直到它第一次挂起，必须在主循环中调用
+inline CoDetached CoSpawn(CoTask<void> task) {
+    co_await task;
+}
+
+// co_await CoDelay(ms)：挂起协程，不阻塞主循环
+class CoDelay {
+public:
+    explicit CoDelay(uint32_t delay_ms) : delay_ms_(delay_ms) {}
+    bool await_ready() const noexcept { return delay_ms_ == 0; }
+    void await_suspend(std::coroutine_handle<> handle) {
+        CoAddTimer(delay_ms_, [handle](uint32_t) { handle.resume(); });
+    }
+    void await_resume() noexcept {}
+
+private:
+    uint32_t delay_ms_;
+};
+
+// co_await CoRunBlocking(fn)：在阻塞调用任务中执行 fn（网络连接、HTTP 请求等），完成后回到主循环返回结果
+template <typename F>
+class CoRunBlocking {
+public:
+    using Result = std::invoke_result_t<F&>;
+    static_assert(!std::is_void_v<Result>, "blocking call must return a value");
+
+    explicit CoRunBlocking(F call, const CallSite& site = CallSite::current()) : call_(std::move(call)), site_(site) {}
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(std::coroutine_handle<> handle) {
+        CoPostBlockingCall([this, handle]() {
+            result_ = call_();
+            CoResumeOnMainLoop(handle, site_);
+        });
+    }
+    Result await_resume() { return std::move(*result_); }
+
+private:
+    F call_;
+    std::optional<Result> result_;
+    [[no_unique_address]] CallSite site_;
+};
+
+// co_await CoWaitForLane(task, lane)：等待 lane 上已经提交的后台任务执行完，之后提交的任务不影响
+class CoWaitForLane {
+public:
+    CoWaitForLane(BackgroundTask* task, BackgroundLane lane, const CallSite& site = CallSite::current())
+        : task_(task), lane_(lane), site_(site) {}
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(std::coroutine_handle<> handle) {
+        task_->Schedule([handle, site = site_]() { CoResumeOnMainLoop(handle, site); }, lane_, site_);
+    }
+    void await_resume() noexcept {}
+
+private:
+    BackgroundTask* task_;
+    BackgroundLane lane_;
+    [[no_unique_address]] CallSite site_;
+};
+
+/*
+ * 可以被协程等待的事件位，对应 FreeRTOS 的 EventGroup
+ * Set 可以在任意任务中调用，等待的协程在主循环中恢复
+ */
+class AsyncEvent {
+public:
+    class Awaiter {
+    public:
+        Awaiter(AsyncEvent* event, uint32_t bits, uint32_t timeout_ms) : event_(event), bits_(bits), timeout_ms_(timeout_ms) {}
+        bool await_ready() const noexcept { return false; }
+        bool await_suspend(std::coroutine_handle<> handle) { return event_->AddWaiter(this, handle); }
+        // 返回等到的事件位，超时返回 0
+        uint32_t await_resume() const noexcept { return result_; }
+
+    private:
+        friend class AsyncEvent;
+        AsyncEvent* event_;
+        uint32_t bits_;
+        uint32_t timeout_ms_;
+        uint32_t result_ = 0;
+        uint32_t timer_id_ = 0;
+        std::coroutine_handle<> handle_;
+    };
+
+    // 与 xEventGroupSetBits 一样，事件位保持置位直到被清除
+    void Set(uint32_t bits);
+    void Clear(uint32_t bits);
+    uint32_t Get();
+    // 等待 bits 中任意一位被置位，timeout_ms 为 0 表示不超时
+    Awaiter Wait(uint32_t bits, uint32_t timeout_ms = 0) { return Awaiter(this, bits, timeout_ms); }
+
+private:
+    std::mutex mutex_;
+    uint32_t bits_ = 0;
+    std::list<Awaiter*> waiters_;
+
+    bool AddWaiter(Awaiter* awaiter, std::coroutine_handle<> handle);
+    void OnTimeout(uint32_t timer_id);
+};
+
+#endif // COROUTINE_H
@@ -10,6 +10,12 @@
 #include "font_awesome_symbols.h"
 #include "audio_codec.h"
 #include "settings.h"
+#include "tracer.h"
+#include "metrics.h"
+#include "emotions.h"
+#if CONFIG_USE_REFRESH_GOVERNOR
+#include "refresh_governor.h"
+#endif
 #include "assets/lang_config.h"
 
 #define TAG "Display"
@@ -19,13 +25,16 @@ Display::Display() {
     Settings settings("display", false);
     current_theme_name_ = settings.GetString("theme", "light");
 
+    lock_wait_time_ = Metrics::GetInstance().RegisterHistogram("display_lock_wait_us", {100, 1000, 5000, 20000, 100000, 500000});
+    lock_count_ = Metrics::GetInstance().RegisterCounter("display_locks");
+
     // Notification timer
     esp_timer_create_args_t notification_timer_args = {
         .callback = [](void *arg) {
             Display *display = static_cast<Display*>(arg);
             DisplayLockGuard lock(display);
-            lv_obj_add_flag(display->notification_label_, LV_OBJ_FLAG_HIDDEN);
-            lv_obj_clear_flag(display->status_label_, LV_OBJ_FLAG_HIDDEN);
+            SetHidden(display->notification_label_, true);
+            SetHidden(display->status_label_, false);
         },
         .arg = this,
         .dispatch_method = ESP_TIMER_TASK,
@@ -57,6 +66,17 @@ Display::Display() {
     }
 }
 
+void Display::TraceRefresh() {
+#if CONFIG_USE_TRACER
+    lv_display_add_event_cb(display_, [](lv_event_t* e) {
+        TRACE_BEGIN("lvgl_refresh");
+    }, LV_EVENT_REFR_START, nullptr);
+    lv_display_add_event_cb(display_, [](lv_event_t* e) {
+        TRACE_END("lvgl_refresh");
+    }, LV_EVENT_REFR_READY, nullptr);
+#endif
+}
+
 Display::~Display() {
     if (notification_timer_ != nullptr) {
         esp_timer_stop(notification_timer_);
@@ -81,14 +101,66 @@ Display::~Display() {
     }
 }
 
+bool Display::AcquireLock(int timeout_ms) {
+    auto self = xTaskGetCurrentTaskHandle();
+    if (lock_owner_.load(std::memory_order_relaxed) == self) {
+        lock_depth_++;
+        return true;
+    }
+
+    int64_t start_time = esp_timer_get_time();
+    if (!Lock(timeout_ms)) {
+        return false;
+    }
+    lock_wait_time_->Record(esp_timer_get_time() - start_time);
+    lock_count_->Add();
+    lock_owner_.store(self, std::memory_order_relaxed);
+    lock_depth_ = 1;
+    return true;
+}
+
+void Display::ReleaseLock() {
+    if (--lock_depth_ > 0) {
+        return;
+    }
+    lock_owner_.store(nullptr, std::memory_order_relaxed);
+    Unlock();
+}
+
+void Display::SetLabelText(lv_obj_t* label, const char* text) {
+    const char* current = lv_label_get_text(label);
+    if (current != nullptr && strcmp(current, text) == 0) {
+        return;
+    }
+    lv_label_set_text(label, text);
+}
+
+void Display::SetHidden(lv_obj_t* obj, bool hidden) {
+    if (lv_obj_has_flag(obj, LV_OBJ_FLAG_HIDDEN) == hidden) {
+        return;
+    }
+    if (hidden) {
+        lv_obj_add_flag(obj, LV_OBJ_FLAG_HIDDEN);
+    } else {
+        lv_obj_clear_flag(obj, LV_OBJ_FLAG_HIDDEN);
+    }
+}
+
+void Display::SetLabelFont(lv_obj_t* label, const lv_font_t* font) {
+    if (lv_obj_get_style_text_font(label, 0) == font) {
+        return;
+    }
+    lv_obj_set_style_text_font(label, font, 0);
+}
+
 void Display::SetStatus(const char* status) {
     DisplayLockGuard lock(this);
     if (status_label_ == nullptr) {
         return;
     }
-    lv_label_set_text(status_label_, status);
-    lv_obj_clear_flag(status_label_, LV_OBJ_FLAG_HIDDEN);
-    lv_obj_add_flag(notification_label_, LV_OBJ_FLAG_HIDDEN);
+    SetLabelText(status_label_, status);
+    SetHidden(status_label_, false);
+    SetHidden(notification_label_, true);
 }
 
 void Display::ShowNotification(const std::string &notification, int duration_ms) {
@@ -100,42 +172,34 @@ void Display::ShowNotification(const char* notification, int duration_ms) {
     if (notification_label_ == nullptr) {
         return;
     }
-    lv_label_set_text(notification_label_, notification);
-    lv_obj_clear_flag(notification_label_, LV_OBJ_FLAG_HIDDEN);
-    lv_obj_add_flag(status_label_, LV_OBJ_FLAG_HIDDEN);
+    SetLabelText(notification_label_, notification);
+    SetHidden(notification_label_, false);
+    SetHidden(status_label_, true);
 
     esp_timer_stop(notification_timer_);
     ESP_ERROR_CHECK(esp_timer_start_once(notification_timer_, duration_ms * 1000));
 }
 
+// 先在锁外读取电池和网络状态（4G 模组需要通过 UART 查询），有变化时再加一次锁更新
 void Display::Update() {
     auto& board = Board::GetInstance();
     auto codec = board.GetAudioCodec();
 
-    {
-        DisplayLockGuard lock(this);
-        if (mute_label_ == nullptr) {
-            return;
-        }
-
-        // 如果静音状态改变，则更新图标
-        if (codec->output_volume() == 0 && !muted_) {
-            muted_ = true;
-            lv_label_set_text(mute_label_, FONT_AWESOME_VOLUME_MUTE);
-        } else if (codec->output_volume() > 0 && muted_) {
-            muted_ = false;
-            lv_label_set_text(mute_label_, "");
-        }
+    if (mute_label_ == nullptr) {
+        return;
     }
 
     esp_pm_lock_acquire(pm_lock_);
+    bool muted = codec->output_volume() == 0;
+
     // 更新电池图标
     int battery_level;
     bool charging, discharging;
-    const char* icon = nullptr;
+    const char* battery_icon = battery_icon_;
+    bool low_battery = low_battery_shown_;
     if (board.GetBatteryLevel(battery_level, charging, discharging)) {
         if (charging) {
-            icon = FONT_AWESOME_BATTERY_CHARGING;
+            battery_icon = FONT_AWESOME_BATTERY_CHARGING;
         } else {
             const char* levels[] = {
                 FONT_AWESOME_BATTERY_EMPTY, // 0-19%
@@ -145,31 +209,13 @@ void Display::Update() {
                 FONT_AWESOME_BATTERY_FULL, // 80-99%
                 FONT_AWESOME_BATTERY_FULL, // 100%
             };
-            icon = levels[battery_level / 20];
-        }
-        DisplayLockGuard lock(this);
-        if (battery_label_ != nullptr && battery_icon_ != icon) {
-            battery_icon_ = icon;
-            lv_label_set_text(battery_label_, battery_icon_);
-        }
-
-        if (low_battery_popup_ != nullptr) {
-            if (strcmp(icon, FONT_AWESOME_BATTERY_EMPTY) == 0 && discharging) {
-                if (lv_obj_has_flag(low_battery_popup_, LV_OBJ_FLAG_HIDDEN)) { // 如果低电量提示框隐藏，则显示
-                    lv_obj_clear_flag(low_battery_popup_, LV_OBJ_FLAG_HIDDEN);
-                    auto& app = Application::GetInstance();
-                    app.PlaySound(Lang::Sounds::P3_LOW_BATTERY);
-                }
-            } else {
-                // Hide the low battery popup when the battery is not empty
-                if (!lv_obj_has_flag(low_battery_popup_, LV_OBJ_FLAG_HIDDEN)) { // 如果低电量提示框显示，则隐藏
-                    lv_obj_add_flag(low_battery_popup_, LV_OBJ_FLAG_HIDDEN);
-                }
-            }
+            battery_icon = levels[battery_level / 20];
         }
+        low_battery = low_battery_popup_ != nullptr && strcmp(battery_icon, FONT_AWESOME_BATTERY_EMPTY) == 0 && discharging;
     }
 
     // 升级固件时，不读取 4G 网络状态，避免占用 UART 资源
+    const char* network_icon = network_icon_;
     auto device_state = Application::GetInstance().GetDeviceState();
     static const std::vector<DeviceState> allowed_states = {
         kDeviceStateIdle,
@@ -178,64 +224,59 @@ void Display::Update() {
         kDeviceStateListening,
     };
     if (std::find(allowed_states.begin(), allowed_states.end(), device_state) != allowed_states.end()) {
-        icon = board.GetNetworkStateIcon();
-        if (network_label_ != nullptr && icon != nullptr && network_icon_ != icon) {
-            DisplayLockGuard lock(this);
-            network_icon_ = icon;
-            lv_label_set_text(network_label_, network_icon_);
+        auto icon = board.GetNetworkStateIcon();
+        if (icon != nullptr) {
+            network_icon = icon;
         }
     }
-
     esp_pm_lock_release(pm_lock_);
+
+    if (muted == muted_ && battery_icon == battery_icon_ && network_icon == network_icon_ &&
+        low_battery == low_battery_shown_) {
+        return;
+    }
+
+    bool show_low_battery = false;
+    {
+        DisplayTransaction transaction(this);
+        // 如果静音状态改变，则更新图标
+        if (muted != muted_) {
+            muted_ = muted;
+            SetLabelText(mute_label_, muted_ ? FONT_AWESOME_VOLUME_MUTE : "");
+        }
+        if (battery_icon != battery_icon_) {
+            battery_icon_ = battery_icon;
+            if (battery_label_ != nullptr) {
+                SetLabelText(battery_label_, battery_icon_);
+            }
+        }
+        if (network_icon != network_icon_) {
+            network_icon_ = network_icon;
+            if (network_label_ != nullptr) {
+                SetLabelText(network_label_, network_icon_);
+            }
+        }
+        if (low_battery != low_battery_shown_) {
+            low_battery_shown_ = low_battery;
+            SetHidden(low_battery_popup_, !low_battery);
+            show_low_battery = low_battery;
+        }
+    }
+
+    if (show_low_battery) {
+        auto& app = Application::GetInstance();
+        app.PlaySound(Lang::Sounds::P3_LOW_BATTERY);
+    }
 }
 
 
 void Display::SetEmotion(const char* emotion) {
-    struct Emotion {
-        const char* icon;
-        const char* text;
-    };
-
-    static const std::vector<Emotion> emotions = {
-        {FONT_AWESOME_EMOJI_NEUTRAL, "neutral"},
-        {FONT_AWESOME_EMOJI_HAPPY, "happy"},
-        {FONT_AWESOME_EMOJI_LAUGHING, "laughing"},
-        {FONT_AWESOME_EMOJI_FUNNY, "funny"},
-        {FONT_AWESOME_EMOJI_SAD, "sad"},
-        {FONT_AWESOME_EMOJI_ANGRY, "angry"},
-        {FONT_AWESOME_EMOJI_CRYING, "crying"},
-        {FONT_AWESOME_EMOJI_LOVING, "loving"},
-        {FONT_AWESOME_EMOJI_EMBARRASSED, "embarrassed"},
-        {FONT_AWESOME_EMOJI_SURPRISED, "surprised"},
-        {FONT_AWESOME_EMOJI_SHOCKED, "shocked"},
-        {FONT_AWESOME_EMOJI_THINKING, "thinking"},
-        {FONT_AWESOME_EMOJI_WINKING, "winking"},
-        {FONT_AWESOME_EMOJI_COOL, "cool"},
-        {FONT_AWESOME_EMOJI_RELAXED, "relaxed"},
-        {FONT_AWESOME_EMOJI_DELICIOUS, "delicious"},
-        {FONT_AWESOME_EMOJI_KISSY, "kissy"},
-        {FONT_AWESOME_EMOJI_CONFIDENT, "confident"},
-        {FONT_AWESOME_EMOJI_SLEEPY, "sleepy"},
-        {FONT_AWESOME_EMOJI_SILLY, "silly"},
-        {FONT_AWESOME_EMOJI_CONFUSED, "confused"}
-    };
-    
-    // 查找匹配的表情
-    std::string_view emotion_view(emotion);
-    auto it = std::find_if(emotions.begin(), emotions.end(),
-        [&emotion_view](const Emotion& e) { return e.text == emotion_view; });
-    
+    auto& info = FindEmotion(emotion);
     DisplayLockGuard lock(this);
     if (emotion_label_ == nullptr) {
         return;
     }
-
-    // 如果找到匹配的表情就显示对应图标，否则显示默认的neutral表情
-    if (it != emotions.end()) {
-        lv_label_set_text(emotion_label_, it->icon);
-    } else {
-        lv_label_set_text(emotion_label_, FONT_AWESOME_EMOJI_NEUTRAL);
-    }
+    ShowEmotion(info, info.icon);
 }
 
 void Display::SetIcon(const char* icon) {
@@ -243,7 +284,26 @@ void Display::SetIcon(const char* icon) {
     if (emotion_label_ == nullptr) {
         return;
     }
-    lv_label_set_text(emotion_label_, icon);
+    ShowIcon(icon);
+}
+
+void Display::ShowEmotion(const Emotion& emotion, const char* glyph, const lv_font_t* font) {
+    if (lv_obj_get_user_data(emotion_label_) == &emotion) {
+        return;
+    }
+    lv_obj_set_user_data(emotion_label_, const_cast<Emotion*>(&emotion));
+    if (font != nullptr) {
+        SetLabelFont(emotion_label_, font);
+    }
+    SetLabelText(emotion_label_, glyph);
+}
+
+void Display::ShowIcon(const char* icon, const lv_font_t* font) {
+    lv_obj_set_user_data(emotion_label_, nullptr);
+    if (font != nullptr) {
+        SetLabelFont(emotion_label_, font);
+    }
+    SetLabelText(emotion_label_, icon);
 }
 
 void Display::SetChatMessage(const char* role, const char* content) {
@@ -251,8 +311,26 @@ void Display::SetChatMessage(const char* role, const char* content) {
     if (chat_message_label_ == nullptr) {
         return;
     }
-    lv_label_set_text(chat_message_label_, content);
+    SetLabelText(chat_message_label_, content);
+}
+
+#if CONFIG_USE_STREAMING_TEXT
+void Display::AppendChatMessage(const char* content, uint32_t start_ms) {
+    SetChatMessage("assistant", content);
+}
+#endif
+
+#if CONFIG_USE_REFRESH_GOVERNOR
+void Display::SetRefreshState(const char* state, bool audio_critical) {
+    DisplayLockGuard lock(this);
+    if (display_ == nullptr) {
+        return;
+    }
+    auto& governor = RefreshGovernor::GetInstance();
+    governor.Attach(display_, pm_lock_);
+    governor.SetState(state, audio_critical);
 }
+#endif
 
 void Display::SetTheme(const std::string& theme_name) {
     current_theme_name_ = theme_name;
@@ -5,8 +5,15 @@
 #include <esp_timer.h>
 #include <esp_log.h>
 #include <esp_pm.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
 
 #include <string>
+#include <atomic>
+
+class MetricHistogram;
+class MetricCounter;
+struct Emotion;
 
 struct DisplayFonts {
     const lv_font_t* text_font = nullptr;
@@ -26,7 +33,15 @@ public:
     virtual void SetChatMessage(const char* role, const char* content);
     virtual void SetIcon(const char* icon);
     virtual void SetTheme(const std::string& theme_name);
+#if CONFIG_USE_STREAMING_TEXT
+    // 助手回复逐句追加，start_ms 为这句话开始播放时的音频播放位置；默认整句替换显示
+    virtual void AppendChatMessage(const char* content, uint32_t start_ms);
+#endif
     virtual std::string GetTheme() { return current_theme_name_; }
+#if CONFIG_USE_REFRESH_GOVERNOR
+    // 设备状态切换时由 Application 调用，audio_critical 时降低刷新率
+    void SetRefreshState(const char* state, bool audio_critical);
+#endif
 
     inline int width() const { return width_; }
     inline int height() const { return height_; }
@@ -55,27 +70,66 @@ protected:
     esp_timer_handle_t notification_timer_ = nullptr;
     esp_timer_handle_t update_timer_ = nullptr;
 
+    bool low_battery_shown_ = false;
+
     friend class DisplayLockGuard;
     virtual bool Lock(int timeout_ms = 0) = 0;
     virtual void Unlock() = 0;
 
     virtual void Update();
+    // 启用事件跟踪时把 LVGL 每次刷新的开始和结束记录下来
+    void TraceRefresh();
+
+    // 内容不变时不做修改，避免重新排版和重绘
+    static void SetLabelText(lv_obj_t* label, const char* text);
+    static void SetHidden(lv_obj_t* obj, bool hidden);
+    static void SetLabelFont(lv_obj_t* label, const lv_font_t* font);
+    // 当前表情记录在 emotion_label_ 的 user_data 中，表情没有变化时不做任何 LVGL 操作
+    void ShowEmotion(const Emotion& emotion, const char* glyph, const lv_font_t* font = nullptr);
+    // 显示表情以外的图标，清除记录
+    void ShowIcon(const char* icon, const lv_font_t* font = nullptr);
+
+private:
+    // 同一任务可以嵌套加锁，嵌套时不再调用 Lock，由 DisplayLockGuard 调用
+    std::atomic<TaskHandle_t> lock_owner_{nullptr};
+    int lock_depth_ = 0;
+    MetricHistogram* lock_wait_time_ = nullptr;
+    MetricCounter* lock_count_ = nullptr;
+
+    bool AcquireLock(int timeout_ms);
+    void ReleaseLock();
 };
 
 
 class DisplayLockGuard {
 public:
     DisplayLockGuard(Display *display) : display_(display) {
-        if (!display_->Lock(3000)) {
+        locked_ = display_->AcquireLock(3000);
+        if (!locked_) {
             ESP_LOGE("Display", "Failed to lock display");
         }
     }
     ~DisplayLockGuard() {
-        display_->Unlock();
+        if (locked_) {
+            display_->ReleaseLock();
+        }
     }
 
 private:
     Display *display_;
+    bool locked_;
+};
+
+/*
+ * 界面批量更新：作用域内调用的多个 SetStatus、SetEmotion、SetChatMessage 等只加一次锁，
+ * LVGL 任务在作用域结束前不会刷新，所有修改合并到同一次重绘
+ */
+class DisplayTransaction {
+public:
+    explicit DisplayTransaction(Display *display) : lock_(display) {}
+
+private:
+    DisplayLockGuard lock_;
 };
 
 class NoDisplay : public Display {
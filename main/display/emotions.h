@@ -0,0 +1,117 @@
+#ifndef EMOTIONS_H
+#define EMOTIONS_H
+
+#include <font_awesome_symbols.h>
+
+#include <array>
+#include <string_view>
+#include <cstdint>
+#include <cstddef>
+
+/*
+ * llm 消息中的表情名称到字形的映射，Display、LcdDisplay、OledDisplay 共用。
+ * 编译期为名称生成完美哈希表，查找只需一次哈希和一次字符串比较
+ */
+struct Emotion {
+    const char* name;
+    const char* icon;   // Font Awesome 图标，OLED 和没有表情字体的屏使用
+    const char* emoji;  // LCD 表情字体中的字形
+};
+
+// 第一项为未知名称时的默认表情
+inline constexpr Emotion kEmotions[] = {
+    {"neutral",     FONT_AWESOME_EMOJI_NEUTRAL,     "😶"},
+    {"happy",       FONT_AWESOME_EMOJI_HAPPY,       "🙂"},
+    {"laughing",    FONT_AWESOME_EMOJI_LAUGHING,    "😆"},
+    {"funny",       FONT_AWESOME_EMOJI_FUNNY,       "😂"},
+    {"sad",         FONT_AWESOME_EMOJI_SAD,         "😔"},
+    {"angry",       FONT_AWESOME_EMOJI_ANGRY,       "😠"},
+    {"crying",      FONT_AWESOME_EMOJI_CRYING,      "😭"},
+    {"loving",      FONT_AWESOME_EMOJI_LOVING,      "😍"},
+    {"embarrassed", FONT_AWESOME_EMOJI_EMBARRASSED, "😳"},
+    {"surprised",   FONT_AWESOME_EMOJI_SURPRISED,   "😯"},
+    {"shocked",     FONT_AWESOME_EMOJI_SHOCKED,     "😱"},
+    {"thinking",    FONT_AWESOME_EMOJI_THINKING,    "🤔"},
+    {"winking",     FONT_AWESOME_EMOJI_WINKING,     "😉"},
+    {"cool",        FONT_AWESOME_EMOJI_COOL,        "😎"},
+    {"relaxed",     FONT_AWESOME_EMOJI_RELAXED,     "😌"},
+    {"delicious",   FONT_AWESOME_EMOJI_DELICIOUS,   "🤤"},
+    {"kissy",       FONT_AWESOME_EMOJI_KISSY,       "😘"},
+    {"confident",   FONT_AWESOME_EMOJI_CONFIDENT,   "😏"},
+    {"sleepy",      FONT_AWESOME_EMOJI_SLEEPY,      "😴"},
+    {"silly",       FONT_AWESOME_EMOJI_SILLY,       "😜"},
+    {"confused",    FONT_AWESOME_EMOJI_CONFUSED,    "🙄"},
+};
+
+namespace emotion_table {
+
+inline constexpr size_t kEmotionCount = sizeof(kEmotions) / sizeof(kEmotions[0]);
+inline constexpr int kSlotBits = 6;
+inline constexpr size_t kSlots = 1 << kSlotBits;
+inline constexpr uint8_t kEmptySlot = 0xFF;
+static_assert(kEmotionCount < kSlots, "emotion table is full");
+
+constexpr uint32_t Hash(std::string_view name) {
+    uint32_t hash = 2166136261u;
+    for (char c : name) {
+        hash = (hash ^ static_cast<uint8_t>(c)) * 16777619u;
+    }
+    return hash;
+}
+
+// FNV-1a 乘以 seed 后取高位作为槽位
+constexpr size_t Slot(std::string_view name, uint32_t seed) {
+    return (Hash(name) * seed) >> (32 - kSlotBits);
+}
+
+// 找到使所有名称落在不同槽位的 seed
+constexpr uint32_t FindSeed() {
+    for (uint32_t seed = 1; seed < 100000; seed += 2) {
+        bool used[kSlots] = {};
+        bool collision = false;
+        for (auto& emotion : kEmotions) {
+            auto slot = Slot(emotion.name, seed);
+            if (used[slot]) {
+                collision = true;
+                break;
+            }
+            used[slot] = true;
+        }
+        if (!collision) {
+            return seed;
+        }
+    }
+    return 0;
+}
+
+inline constexpr uint32_t kSeed = FindSeed();
+static_assert(kSeed != 0, "no perfect hash seed for emotion names");
+
+constexpr std::array<uint8_t, kSlots> BuildSlots() {
+    std::array<uint8_t, kSlots> slots = {};
+    for (auto& slot : slots) {
+        slot = kEmptySlot;
+    }
+    for (size_t i = 0; i < kEmotionCount; i++) {
+        slots[Slot(kEmotions[i].name, kSeed)] = i;
+    }
+    return slots;
+}
+
+inline constexpr auto kSlotTable = BuildSlots();
+
+} // namespace emotion_table
+
+// 未知名称返回 neutral；返回的引用在整个程序中唯一，可以用地址判断表情是否变化
+constexpr const Emotion& FindEmotion(std::string_view name) {
+    auto index = emotion_table::kSlotTable[emotion_table::Slot(name, emotion_table::kSeed)];
+    if (index != emotion_table::kEmptySlot && name == kEmotions[index].name) {
+        return kEmotions[index];
+    }
+    return kEmotions[0];
+}
+
+static_assert(&FindEmotion("sleepy") == &kEmotions[18]);
+static_assert(&FindEmotion("unknown") == &kEmotions[0]);
+
+#endif // EMOTIONS_H
@@ -1,6 +1,7 @@
 #include "lcd_display.h"
 
 #include <vector>
+#include <algorithm>
 #include <font_awesome_symbols.h>
 #include <esp_log.h>
 #include <esp_err.h>
@@ -10,6 +11,18 @@
 #include "settings.h"
 
 #include "board.h"
+#include "metrics.h"
+#include "emotions.h"
+#if CONFIG_USE_REFRESH_GOVERNOR
+#include "refresh_governor.h"
+#endif
+#if CONFIG_USE_STREAMING_TEXT
+#include "streaming_text.h"
+#include "application.h"
+#endif
+#if CONFIG_USE_EMOJI_SPRITES
+#include <esp_heap_caps.h>
+#endif
 
 #define TAG "LcdDisplay"
 
@@ -77,6 +90,29 @@ static const ThemeColors LIGHT_THEME = {
 // Current theme - initialize based on default config
 static ThemeColors current_theme = LIGHT_THEME;
 
+// LVGL 渲染缓冲区，渲染流水线模式下由 Kconfig 配置
+#if CONFIG_LCD_RENDER_PIPELINE
+#define LCD_BUFFER_LINES CONFIG_LCD_RENDER_BUFFER_LINES
+#if CONFIG_LCD_RENDER_DOUBLE_BUFFER
+#define LCD_DOUBLE_BUFFER true
+#else
+#define LCD_DOUBLE_BUFFER false
+#endif
+#if CONFIG_LCD_RENDER_BUFFER_SPIRAM
+// PSRAM 不能直接用于 SPI DMA，由 esp_lvgl_port 经内部 SRAM 的中转缓冲区分段发送
+#define LCD_BUFFER_SPIRAM 1
+#define LCD_BOUNCE_LINES CONFIG_LCD_DMA_BOUNCE_LINES
+#else
+#define LCD_BUFFER_SPIRAM 0
+#define LCD_BOUNCE_LINES 0
+#endif
+#else
+#define LCD_BUFFER_LINES 10
+#define LCD_DOUBLE_BUFFER false
+#define LCD_BUFFER_SPIRAM 0
+#define LCD_BOUNCE_LINES 0
+#endif
+
 
 LV_FONT_DECLARE(font_awesome_30_4);
 
@@ -110,9 +146,9 @@ SpiLcdDisplay::SpiLcdDisplay(esp_lcd_panel_io_handle_t panel_io, esp_lcd_panel_h
         .io_handle = panel_io_,
         .panel_handle = panel_,
         .control_handle = nullptr,
-        .buffer_size = static_cast<uint32_t>(width_ * 10),
-        .double_buffer = false,
-        .trans_size = 0,
+        .buffer_size = static_cast<uint32_t>(width_ * LCD_BUFFER_LINES),
+        .double_buffer = LCD_DOUBLE_BUFFER,
+        .trans_size = static_cast<uint32_t>(width_ * LCD_BOUNCE_LINES),
         .hres = static_cast<uint32_t>(width_),
         .vres = static_cast<uint32_t>(height_),
         .monochrome = false,
@@ -123,8 +159,8 @@ SpiLcdDisplay::SpiLcdDisplay(esp_lcd_panel_io_handle_t panel_io, esp_lcd_panel_h
         },
         .color_format = LV_COLOR_FORMAT_RGB565,
         .flags = {
-            .buff_dma = 1,
-            .buff_spiram = 0,
+            .buff_dma = !LCD_BUFFER_SPIRAM,
+            .buff_spiram = LCD_BUFFER_SPIRAM,
             .sw_rotate = 0,
             .swap_bytes = 1,
             .full_refresh = 0,
@@ -137,6 +173,13 @@ SpiLcdDisplay::SpiLcdDisplay(esp_lcd_panel_io_handle_t panel_io, esp_lcd_panel_h
         ESP_LOGE(TAG, "Failed to add display");
         return;
     }
+    TraceRefresh();
+#if CONFIG_LCD_RENDER_PIPELINE
+    SetupRenderPipeline();
+#endif
+#if CONFIG_LCD_COALESCE_DIRTY_AREAS
+    SetupDirtyAreaCoalescing();
+#endif
 
     if (offset_x != 0 || offset_y != 0) {
         lv_display_set_offset(display_, offset_x, offset_y);
@@ -208,6 +251,10 @@ RgbLcdDisplay::RgbLcdDisplay(esp_lcd_panel_io_handle_t panel_io, esp_lcd_panel_h
         ESP_LOGE(TAG, "Failed to add RGB display");
         return;
     }
+    TraceRefresh();
+#if CONFIG_LCD_RENDER_PIPELINE
+    SetupRenderPipeline();
+#endif
     
     if (offset_x != 0 || offset_y != 0) {
         lv_display_set_offset(display_, offset_x, offset_y);
@@ -224,6 +271,9 @@ RgbLcdDisplay::RgbLcdDisplay(esp_lcd_panel_io_handle_t panel_io, esp_lcd_panel_h
 }
 
 LcdDisplay::~LcdDisplay() {
+#if CONFIG_USE_STREAMING_TEXT
+    delete streaming_text_;
+#endif
     // 然后再清理 LVGL 对象
     if (content_ != nullptr) {
         lv_obj_del(content_);
@@ -237,9 +287,33 @@ LcdDisplay::~LcdDisplay() {
     if (container_ != nullptr) {
         lv_obj_del(container_);
     }
+    // 状态栏上的标签已随父对象删除，~Display 不再重复删除
+    network_label_ = nullptr;
+#if CONFIG_USE_EMOJI_SPRITES
+    for (auto& sprite : emoji_sprites_) {
+        lv_image_cache_drop(&sprite);
+    }
+    heap_caps_free(emoji_sprite_data_);
+#endif
+#if CONFIG_USE_WECHAT_MESSAGE_STYLE
+    if (chat_bubbles_[0].row != nullptr) {
+        lv_style_reset(&chat_row_style_);
+        lv_style_reset(&chat_bubble_style_);
+        for (auto& style : chat_role_styles_) {
+            lv_style_reset(&style);
+        }
+    }
+#endif
     if (display_ != nullptr) {
         lv_display_delete(display_);
     }
+    // 屏幕对象随显示一起删除后才能释放它使用的样式
+    if (theme_styles_ready_) {
+        for (auto style : {&theme_styles_.screen, &theme_styles_.container, &theme_styles_.status_bar,
+                &theme_styles_.content, &theme_styles_.low_battery}) {
+            lv_style_reset(style);
+        }
+    }
 
     if (panel_ != nullptr) {
         esp_lcd_panel_del(panel_);
@@ -249,6 +323,97 @@ LcdDisplay::~LcdDisplay() {
     }
 }
 
+#if CONFIG_LCD_RENDER_PIPELINE
+void LcdDisplay::SetupRenderPipeline() {
+    ESP_LOGI(TAG, "Render pipeline on %s: %d lines x %d, %s, %s", BOARD_NAME, LCD_BUFFER_LINES,
+        LCD_DOUBLE_BUFFER ? 2 : 1, LCD_BUFFER_SPIRAM ? "spiram" : "internal dma",
+        LCD_BOUNCE_LINES > 0 ? "with bounce buffer" : "no bounce buffer");
+
+    auto& metrics = Metrics::GetInstance();
+    render_time_ = metrics.RegisterHistogram("lcd_render_ms", {5, 10, 20, 33, 50, 100});
+    flush_wait_time_ = metrics.RegisterHistogram("lcd_flush_wait_ms", {1, 2, 5, 10, 20, 50});
+    fps_ = metrics.RegisterGauge("lcd_fps");
+
+    lv_display_add_event_cb(display_, [](lv_event_t* e) {
+        auto self = static_cast<LcdDisplay*>(lv_event_get_user_data(e));
+        self->OnDisplayEvent(e);
+    }, LV_EVENT_ALL, this);
+}
+
+// 在 LVGL 任务中调用，不需要加锁
+void LcdDisplay::OnDisplayEvent(lv_event_t* e) {
+    int64_t now = esp_timer_get_time();
+    switch (lv_event_get_code(e)) {
+    case LV_EVENT_RENDER_START:
+        render_start_us_ = now;
+        flush_wait_us_ = 0;
+        break;
+    case LV_EVENT_FLUSH_WAIT_START:
+        flush_wait_start_us_ = now;
+        break;
+    case LV_EVENT_FLUSH_WAIT_FINISH:
+        flush_wait_us_ += now - flush_wait_start_us_;
+        break;
+    case LV_EVENT_RENDER_READY:
+        // 渲染时间包含等待上一块缓冲区发送完成的时间
+        render_time_->Record((now - render_start_us_) / 1000);
+        flush_wait_time_->Record(flush_wait_us_ / 1000);
+
+        // 只统计连续刷新（动画、滚动）时的帧率，间隔超过 200ms 重新计时
+        if (render_start_us_ - last_frame_us_ > 200 * 1000) {
+            fps_window_start_us_ = render_start_us_;
+            fps_frames_ = 0;
+        }
+        last_frame_us_ = now;
+        fps_frames_++;
+        if (now - fps_window_start_us_ >= 1000 * 1000) {
+            fps_->Set(fps_frames_ * 1000 * 1000 / (now - fps_window_start_us_));
+            fps_window_start_us_ = now;
+            fps_frames_ = 0;
+        }
+        break;
+    default:
+        break;
+    }
+}
+#endif
+
+#if CONFIG_LCD_COALESCE_DIRTY_AREAS
+void LcdDisplay::SetupDirtyAreaCoalescing() {
+    lv_display_add_event_cb(display_, [](lv_event_t* e) {
+        auto self = static_cast<LcdDisplay*>(lv_event_get_user_data(e));
+        self->CoalesceDirtyArea(static_cast<lv_area_t*>(lv_event_get_param(e)));
+    }, LV_EVENT_INVALIDATE_AREA, this);
+    lv_display_add_event_cb(display_, [](lv_event_t* e) {
+        auto self = static_cast<LcdDisplay*>(lv_event_get_user_data(e));
+        self->has_dirty_area_ = false;
+    }, LV_EVENT_REFR_READY, this);
+}
+
+// LVGL 的 lv_refr_join_area 只在合并后的面积小于两块面积之和（即两块重叠）时才合并。
+// 这里在失效时就把新区域扩大到包含本周期已有的脏区域，允许多渲染最多一块缓冲区的面积，
+// 把相近但不重叠的小区域（状态栏图标、时钟等）合并成一次渲染，减少分块发送和设置显示窗口的次数。
+// 扩大后的区域包含已有区域，LVGL 之后会把两者合并成一个
+void LcdDisplay::CoalesceDirtyArea(lv_area_t* area) {
+    if (!has_dirty_area_) {
+        dirty_area_ = *area;
+        has_dirty_area_ = true;
+        return;
+    }
+
+    lv_area_t joined;
+    joined.x1 = std::min(dirty_area_.x1, area->x1);
+    joined.y1 = std::min(dirty_area_.y1, area->y1);
+    joined.x2 = std::max(dirty_area_.x2, area->x2);
+    joined.y2 = std::max(dirty_area_.y2, area->y2);
+    int64_t waste = (int64_t)lv_area_get_size(&joined) - lv_area_get_size(&dirty_area_) - lv_area_get_size(area);
+    if (waste <= (int64_t)width_ * LCD_BUFFER_LINES) {
+        dirty_area_ = joined;
+        *area = joined;
+    }
+}
+#endif
+
 bool LcdDisplay::Lock(int timeout_ms) {
     return lvgl_port_lock(timeout_ms);
 }
@@ -257,14 +422,49 @@ void LcdDisplay::Unlock() {
     lvgl_port_unlock();
 }
 
+void LcdDisplay::InitThemeStyles() {
+    lv_style_init(&theme_styles_.screen);
+    lv_style_init(&theme_styles_.container);
+    lv_style_init(&theme_styles_.status_bar);
+    lv_style_init(&theme_styles_.content);
+    lv_style_init(&theme_styles_.low_battery);
+    theme_styles_ready_ = true;
+    UpdateThemeStyles();
+}
+
+// 标签不单独设置文字颜色，从状态栏和内容区继承
+void LcdDisplay::UpdateThemeStyles() {
+    lv_style_set_bg_color(&theme_styles_.screen, current_theme.background);
+    lv_style_set_text_color(&theme_styles_.screen, current_theme.text);
+    lv_style_set_bg_color(&theme_styles_.container, current_theme.background);
+    lv_style_set_border_color(&theme_styles_.container, current_theme.border);
+    lv_style_set_bg_color(&theme_styles_.status_bar, current_theme.background);
+    lv_style_set_text_color(&theme_styles_.status_bar, current_theme.text);
+    lv_style_set_bg_color(&theme_styles_.content, current_theme.chat_background);
+    lv_style_set_border_color(&theme_styles_.content, current_theme.border);
+    lv_style_set_text_color(&theme_styles_.content, current_theme.text);
+    lv_style_set_bg_color(&theme_styles_.low_battery, current_theme.low_battery);
+
+    for (auto style : {&theme_styles_.screen, &theme_styles_.container, &theme_styles_.status_bar,
+            &theme_styles_.content, &theme_styles_.low_battery}) {
+        lv_obj_report_style_change(style);
+    }
+#if CONFIG_USE_WECHAT_MESSAGE_STYLE
+    // 所有气泡共用角色样式，更新样式即可
+    if (chat_bubbles_[0].row != nullptr) {
+        UpdateChatBubbleStyles();
+    }
+#endif
+}
+
 #if CONFIG_USE_WECHAT_MESSAGE_STYLE
 void LcdDisplay::SetupUI() {
     DisplayLockGuard lock(this);
 
+    InitThemeStyles();
     auto screen = lv_screen_active();
     lv_obj_set_style_text_font(screen, fonts_.text_font, 0);
-    lv_obj_set_style_text_color(screen, current_theme.text, 0);
-    lv_obj_set_style_bg_color(screen, current_theme.background, 0);
+    lv_obj_add_style(screen, &theme_styles_.screen, 0);
 
     /* Container */
     container_ = lv_obj_create(screen);
@@ -273,15 +473,13 @@ void LcdDisplay::SetupUI() {
     lv_obj_set_style_pad_all(container_, 0, 0);
     lv_obj_set_style_border_width(container_, 0, 0);
     lv_obj_set_style_pad_row(container_, 0, 0);
-    lv_obj_set_style_bg_color(container_, current_theme.background, 0);
-    lv_obj_set_style_border_color(container_, current_theme.border, 0);
+    lv_obj_add_style(container_, &theme_styles_.container, 0);
 
     /* Status bar */
     status_bar_ = lv_obj_create(container_);
     lv_obj_set_size(status_bar_, LV_HOR_RES, fonts_.emoji_font->line_height);
     lv_obj_set_style_radius(status_bar_, 0, 0);
-    lv_obj_set_style_bg_color(status_bar_, current_theme.background, 0);
-    lv_obj_set_style_text_color(status_bar_, current_theme.text, 0);
+    lv_obj_add_style(status_bar_, &theme_styles_.status_bar, 0);
     
     /* Content - Chat area */
     content_ = lv_obj_create(container_);
@@ -289,8 +487,7 @@ void LcdDisplay::SetupUI() {
     lv_obj_set_width(content_, LV_HOR_RES);
     lv_obj_set_flex_grow(content_, 1);
     lv_obj_set_style_pad_all(content_, 5, 0);
-    lv_obj_set_style_bg_color(content_, current_theme.chat_background, 0); // Background for chat area
-    lv_obj_set_style_border_color(content_, current_theme.border, 0); // Border color for chat area
+    lv_obj_add_style(content_, &theme_styles_.content, 0);
 
     // Enable scrolling for chat content
     lv_obj_set_scrollbar_mode(content_, LV_SCROLLBAR_MODE_OFF);
@@ -301,7 +498,7 @@ void LcdDisplay::SetupUI() {
     lv_obj_set_flex_align(content_, LV_FLEX_ALIGN_START, LV_FLEX_ALIGN_START, LV_FLEX_ALIGN_START);
     lv_obj_set_style_pad_row(content_, 10, 0); // Space between messages
 
-    // We'll create chat messages dynamically in SetChatMessage
+    CreateChatBubbles();
     chat_message_label_ = nullptr;
 
     /* Status bar */
@@ -318,14 +515,18 @@ void LcdDisplay::SetupUI() {
     // 创建emotion_label_在状态栏最左侧
     emotion_label_ = lv_label_create(status_bar_);
     lv_obj_set_style_text_font(emotion_label_, &font_awesome_30_4, 0);
-    lv_obj_set_style_text_color(emotion_label_, current_theme.text, 0);
     lv_label_set_text(emotion_label_, FONT_AWESOME_AI_CHIP);
     lv_obj_set_style_margin_right(emotion_label_, 5, 0); // 添加右边距，与后面的元素分隔
+#if CONFIG_USE_EMOJI_SPRITES
+    CreateEmojiSprites();
+    if (emotion_image_ != nullptr) {
+        lv_obj_set_style_margin_right(emotion_image_, 5, 0);
+    }
+#endif
 
     notification_label_ = lv_label_create(status_bar_);
     lv_obj_set_flex_grow(notification_label_, 1);
     lv_obj_set_style_text_align(notification_label_, LV_TEXT_ALIGN_CENTER, 0);
-    lv_obj_set_style_text_color(notification_label_, current_theme.text, 0);
     lv_label_set_text(notification_label_, "");
     lv_obj_add_flag(notification_label_, LV_OBJ_FLAG_HIDDEN);
 
@@ -333,31 +534,27 @@ void LcdDisplay::SetupUI() {
     lv_obj_set_flex_grow(status_label_, 1);
     lv_label_set_long_mode(status_label_, LV_LABEL_LONG_SCROLL_CIRCULAR);
     lv_obj_set_style_text_align(status_label_, LV_TEXT_ALIGN_CENTER, 0);
-    lv_obj_set_style_text_color(status_label_, current_theme.text, 0);
     lv_label_set_text(status_label_, Lang::Strings::INITIALIZING);
     
     mute_label_ = lv_label_create(status_bar_);
     lv_label_set_text(mute_label_, "");
     lv_obj_set_style_text_font(mute_label_, fonts_.icon_font, 0);
-    lv_obj_set_style_text_color(mute_label_, current_theme.text, 0);
 
     network_label_ = lv_label_create(status_bar_);
     lv_label_set_text(network_label_, "");
     lv_obj_set_style_text_font(network_label_, fonts_.icon_font, 0);
-    lv_obj_set_style_text_color(network_label_, current_theme.text, 0);
     lv_obj_set_style_margin_left(network_label_, 5, 0); // 添加左边距，与前面的元素分隔
 
     battery_label_ = lv_label_create(status_bar_);
     lv_label_set_text(battery_label_, "");
     lv_obj_set_style_text_font(battery_label_, fonts_.icon_font, 0);
-    lv_obj_set_style_text_color(battery_label_, current_theme.text, 0);
     lv_obj_set_style_margin_left(battery_label_, 5, 0); // 添加左边距，与前面的元素分隔
 
     low_battery_popup_ = lv_obj_create(screen);
     lv_obj_set_scrollbar_mode(low_battery_popup_, LV_SCROLLBAR_MODE_OFF);
     lv_obj_set_size(low_battery_popup_, LV_HOR_RES * 0.9, fonts_.text_font->line_height * 2);
     lv_obj_align(low_battery_popup_, LV_ALIGN_BOTTOM_MID, 0, 0);
-    lv_obj_set_style_bg_color(low_battery_popup_, current_theme.low_battery, 0);
+    lv_obj_add_style(low_battery_popup_, &theme_styles_.low_battery, 0);
     lv_obj_set_style_radius(low_battery_popup_, 10, 0);
     lv_obj_t* low_battery_label = lv_label_create(low_battery_popup_);
     lv_label_set_text(low_battery_label, Lang::Strings::BATTERY_NEED_CHARGE);
@@ -366,7 +563,69 @@ void LcdDisplay::SetupUI() {
     lv_obj_add_flag(low_battery_popup_, LV_OBJ_FLAG_HIDDEN);
 }
 
-#define  MAX_MESSAGES 50
+void LcdDisplay::CreateChatBubbles() {
+    lv_style_init(&chat_row_style_);
+    lv_style_set_width(&chat_row_style_, LV_HOR_RES);
+    lv_style_set_height(&chat_row_style_, LV_SIZE_CONTENT);
+    lv_style_set_bg_opa(&chat_row_style_, LV_OPA_TRANSP);
+    lv_style_set_border_width(&chat_row_style_, 0);
+    lv_style_set_pad_all(&chat_row_style_, 0);
+
+    lv_style_init(&chat_bubble_style_);
+    lv_style_set_width(&chat_bubble_style_, LV_SIZE_CONTENT);
+    lv_style_set_height(&chat_bubble_style_, LV_SIZE_CONTENT);
+    lv_style_set_radius(&chat_bubble_style_, 8);
+    lv_style_set_border_width(&chat_bubble_style_, 1);
+    lv_style_set_pad_all(&chat_bubble_style_, 8);
+    lv_style_set_text_font(&chat_bubble_style_, fonts_.text_font);
+
+    // 角色样式包含对齐方式：用户消息靠右，助手消息靠左，系统消息居中
+    for (auto& style : chat_role_styles_) {
+        lv_style_init(&style);
+    }
+    lv_style_set_align(&chat_role_styles_[kChatRoleUser], LV_ALIGN_RIGHT_MID);
+    lv_style_set_x(&chat_role_styles_[kChatRoleUser], -10);
+    lv_style_set_margin_right(&chat_role_styles_[kChatRoleUser], 10);
+    lv_style_set_align(&chat_role_styles_[kChatRoleAssistant], LV_ALIGN_LEFT_MID);
+    lv_style_set_margin_left(&chat_role_styles_[kChatRoleAssistant], -4);
+    lv_style_set_align(&chat_role_styles_[kChatRoleSystem], LV_ALIGN_CENTER);
+    UpdateChatBubbleStyles();
+
+    // 隐藏的对象不参与 flex 布局，用到时再显示
+    for (auto& item : chat_bubbles_) {
+        item.row = lv_obj_create(content_);
+        lv_obj_add_style(item.row, &chat_row_style_, 0);
+        lv_obj_remove_flag(item.row, LV_OBJ_FLAG_SCROLLABLE);
+        lv_obj_add_flag(item.row, LV_OBJ_FLAG_HIDDEN);
+
+        item.bubble = lv_obj_create(item.row);
+        lv_obj_set_scrollbar_mode(item.bubble, LV_SCROLLBAR_MODE_OFF);
+        lv_obj_add_style(item.bubble, &chat_bubble_style_, 0);
+        lv_obj_add_style(item.bubble, &chat_role_styles_[item.role], 0);
+
+        item.label = lv_label_create(item.bubble);
+        lv_label_set_long_mode(item.label, LV_LABEL_LONG_WRAP);
+        lv_label_set_text_static(item.label, "");
+    }
+    next_chat_bubble_ = 0;
+}
+
+void LcdDisplay::UpdateChatBubbleStyles() {
+    lv_style_set_border_color(&chat_bubble_style_, current_theme.border);
+    lv_style_set_bg_color(&chat_role_styles_[kChatRoleUser], current_theme.user_bubble);
+    lv_style_set_text_color(&chat_role_styles_[kChatRoleUser], current_theme.text);
+    lv_style_set_bg_color(&chat_role_styles_[kChatRoleAssistant], current_theme.assistant_bubble);
+    lv_style_set_text_color(&chat_role_styles_[kChatRoleAssistant], current_theme.text);
+    lv_style_set_bg_color(&chat_role_styles_[kChatRoleSystem], current_theme.system_bubble);
+    lv_style_set_text_color(&chat_role_styles_[kChatRoleSystem], current_theme.system_text);
+
+    // 通知使用这些样式的对象刷新
+    lv_obj_report_style_change(&chat_bubble_style_);
+    for (auto& style : chat_role_styles_) {
+        lv_obj_report_style_change(&style);
+    }
+}
+
 void LcdDisplay::SetChatMessage(const char* role, const char* content) {
     DisplayLockGuard lock(this);
     if (content_ == nullptr) {
@@ -375,174 +634,49 @@ void LcdDisplay::SetChatMessage(const char* role, const char* content) {
     
     //避免出现空的消息框
     if(strlen(content) == 0) return;
-    
-    // Create a message bubble
-    lv_obj_t* msg_bubble = lv_obj_create(content_);
-    lv_obj_set_style_radius(msg_bubble, 8, 0);
-    lv_obj_set_scrollbar_mode(msg_bubble, LV_SCROLLBAR_MODE_OFF);
-    lv_obj_set_style_border_width(msg_bubble, 1, 0);
-    lv_obj_set_style_border_color(msg_bubble, current_theme.border, 0);
-    lv_obj_set_style_pad_all(msg_bubble, 8, 0);
-
-    // Create the message text
-    lv_obj_t* msg_text = lv_label_create(msg_bubble);
-    lv_label_set_text(msg_text, content);
-    
-    // 计算文本实际宽度
-    lv_coord_t text_width = lv_txt_get_width(content, strlen(content), fonts_.text_font, 0);
 
-    // 计算气泡宽度
-    lv_coord_t max_width = LV_HOR_RES * 85 / 100 - 16;  // 屏幕宽度的85%
-    lv_coord_t min_width = 20;  
-    lv_coord_t bubble_width;
-    
-    // 确保文本宽度不小于最小宽度
-    if (text_width < min_width) {
-        text_width = min_width;
+    ChatRole chat_role = kChatRoleAssistant;
+    if (strcmp(role, "user") == 0) {
+        chat_role = kChatRoleUser;
+    } else if (strcmp(role, "system") == 0) {
+        chat_role = kChatRoleSystem;
     }
 
-    // 如果文本宽度小于最大宽度，使用文本宽度
-    if (text_width < max_width) {
-        bubble_width = text_width; 
-    } else {
-        bubble_width = max_width;
+    // 取出最早的气泡，移到消息列表末尾重新使用
+    auto& item = chat_bubbles_[next_chat_bubble_];
+    next_chat_bubble_ = (next_chat_bubble_ + 1) % CONFIG_CHAT_BUBBLE_POOL_SIZE;
+    lv_obj_move_foreground(item.row);
+    if (item.role != chat_role) {
+        lv_obj_replace_style(item.bubble, &chat_role_styles_[item.role], &chat_role_styles_[chat_role], 0);
+        item.role = chat_role;
     }
-    
-    // 设置消息文本的宽度
-    lv_obj_set_width(msg_text, bubble_width);  // 减去padding
-    lv_label_set_long_mode(msg_text, LV_LABEL_LONG_WRAP);
-    lv_obj_set_style_text_font(msg_text, fonts_.text_font, 0);
 
-    // 设置气泡宽度
-    lv_obj_set_width(msg_bubble, bubble_width);
-    lv_obj_set_height(msg_bubble, LV_SIZE_CONTENT);
+    lv_label_set_text(item.label, content);
 
-    // Set alignment and style based on message role
-    if (strcmp(role, "user") == 0) {
-        // User messages are right-aligned with green background
-        lv_obj_set_style_bg_color(msg_bubble, current_theme.user_bubble, 0);
-        // Set text color for contrast
-        lv_obj_set_style_text_color(msg_text, current_theme.text, 0);
-        
-        // 设置自定义属性标记气泡类型
-        lv_obj_set_user_data(msg_bubble, (void*)"user");
-        
-        // Set appropriate width for content
-        lv_obj_set_width(msg_bubble, LV_SIZE_CONTENT);
-        lv_obj_set_height(msg_bubble, LV_SIZE_CONTENT);
-        
-        // Add some margin 
-        lv_obj_set_style_margin_right(msg_bubble, 10, 0);
-        
-        // Don't grow
-        lv_obj_set_style_flex_grow(msg_bubble, 0, 0);
-    } else if (strcmp(role, "assistant") == 0) {
-        // Assistant messages are left-aligned with white background
-        lv_obj_set_style_bg_color(msg_bubble, current_theme.assistant_bubble, 0);
-        // Set text color for contrast
-        lv_obj_set_style_text_color(msg_text, current_theme.text, 0);
-        
-        // 设置自定义属性标记气泡类型
-        lv_obj_set_user_data(msg_bubble, (void*)"assistant");
-        
-        // Set appropriate width for content
-        lv_obj_set_width(msg_bubble, LV_SIZE_CONTENT);
-        lv_obj_set_height(msg_bubble, LV_SIZE_CONTENT);
-        
-        // Add some margin
-        lv_obj_set_style_margin_left(msg_bubble, -4, 0);
-        
-        // Don't grow
-        lv_obj_set_style_flex_grow(msg_bubble, 0, 0);
-    } else if (strcmp(role, "system") == 0) {
-        // System messages are center-aligned with light gray background
-        lv_obj_set_style_bg_color(msg_bubble, current_theme.system_bubble, 0);
-        // Set text color for contrast
-        lv_obj_set_style_text_color(msg_text, current_theme.system_text, 0);
-        
-        // 设置自定义属性标记气泡类型
-        lv_obj_set_user_data(msg_bubble, (void*)"system");
-        
-        // Set appropriate width for content
-        lv_obj_set_width(msg_bubble, LV_SIZE_CONTENT);
-        lv_obj_set_height(msg_bubble, LV_SIZE_CONTENT);
-        
-        // Don't grow
-        lv_obj_set_style_flex_grow(msg_bubble, 0, 0);
-    }
-    
-    // Create a full-width container for user messages to ensure right alignment
-    if (strcmp(role, "user") == 0) {
-        // Create a full-width container
-        lv_obj_t* container = lv_obj_create(content_);
-        lv_obj_set_width(container, LV_HOR_RES);
-        lv_obj_set_height(container, LV_SIZE_CONTENT);
-        
-        // Make container transparent and borderless
-        lv_obj_set_style_bg_opa(container, LV_OPA_TRANSP, 0);
-        lv_obj_set_style_border_width(container, 0, 0);
-        lv_obj_set_style_pad_all(container, 0, 0);
-        
-        // Move the message bubble into this container
-        lv_obj_set_parent(msg_bubble, container);
-        
-        // Right align the bubble in the container
-        lv_obj_align(msg_bubble, LV_ALIGN_RIGHT_MID, -10, 0);
-        
-        // Auto-scroll to this container
-        lv_obj_scroll_to_view_recursive(container, LV_ANIM_ON);
-    } else if (strcmp(role, "system") == 0) {
-        // 为系统消息创建全宽容器以确保居中对齐
-        lv_obj_t* container = lv_obj_create(content_);
-        lv_obj_set_width(container, LV_HOR_RES);
-        lv_obj_set_height(container, LV_SIZE_CONTENT);
-        
-        // 使容器透明且无边框
-        lv_obj_set_style_bg_opa(container, LV_OPA_TRANSP, 0);
-        lv_obj_set_style_border_width(container, 0, 0);
-        lv_obj_set_style_pad_all(container, 0, 0);
-        
-        // 将消息气泡移入此容器
-        lv_obj_set_parent(msg_bubble, container);
-        
-        // 将气泡居中对齐在容器中
-        lv_obj_align(msg_bubble, LV_ALIGN_CENTER, 0, 0);
-        
-        // 自动滚动底部
-        lv_obj_scroll_to_view_recursive(container, LV_ANIM_ON);
-    } else {
-        // For assistant messages
-        // Left align assistant messages
-        lv_obj_align(msg_bubble, LV_ALIGN_LEFT_MID, 0, 0);
+    // 计算文本实际宽度，气泡宽度不超过屏幕宽度的85%
+    lv_coord_t text_width = lv_txt_get_width(content, strlen(content), fonts_.text_font, 0);
+    lv_coord_t max_width = LV_HOR_RES * 85 / 100 - 16;
+    lv_coord_t min_width = 20;
+    lv_obj_set_width(item.label, std::clamp(text_width, min_width, max_width));
+
+    lv_obj_remove_flag(item.row, LV_OBJ_FLAG_HIDDEN);
+#if CONFIG_USE_REFRESH_GOVERNOR
+    // 滚动动画期间恢复正常刷新率
+    RefreshGovernor::GetInstance().Boost();
+#endif
+    lv_obj_scroll_to_view_recursive(item.row, LV_ANIM_ON);
 
-        // Auto-scroll to the message bubble
-        lv_obj_scroll_to_view_recursive(msg_bubble, LV_ANIM_ON);
-    }
-    
     // Store reference to the latest message label
-    chat_message_label_ = msg_text;
-
-    // 检查消息数量是否超过限制
-    uint32_t msg_count = lv_obj_get_child_cnt(content_);
-    while (msg_count >= MAX_MESSAGES) {
-        // 删除最早的消息（第一个子节点）
-        lv_obj_t* oldest_msg = lv_obj_get_child(content_, 0);
-        if (oldest_msg != nullptr) {
-            lv_obj_del(oldest_msg);
-            msg_count--;
-        }else{
-            break;
-        }
-    }
+    chat_message_label_ = item.label;
 }
 #else
 void LcdDisplay::SetupUI() {
     DisplayLockGuard lock(this);
 
+    InitThemeStyles();
     auto screen = lv_screen_active();
     lv_obj_set_style_text_font(screen, fonts_.text_font, 0);
-    lv_obj_set_style_text_color(screen, current_theme.text, 0);
-    lv_obj_set_style_bg_color(screen, current_theme.background, 0);
+    lv_obj_add_style(screen, &theme_styles_.screen, 0);
 
     /* Container */
     container_ = lv_obj_create(screen);
@@ -551,15 +685,13 @@ void LcdDisplay::SetupUI() {
     lv_obj_set_style_pad_all(container_, 0, 0);
     lv_obj_set_style_border_width(container_, 0, 0);
     lv_obj_set_style_pad_row(container_, 0, 0);
-    lv_obj_set_style_bg_color(container_, current_theme.background, 0);
-    lv_obj_set_style_border_color(container_, current_theme.border, 0);
+    lv_obj_add_style(container_, &theme_styles_.container, 0);
 
     /* Status bar */
     status_bar_ = lv_obj_create(container_);
     lv_obj_set_size(status_bar_, LV_HOR_RES, fonts_.text_font->line_height);
     lv_obj_set_style_radius(status_bar_, 0, 0);
-    lv_obj_set_style_bg_color(status_bar_, current_theme.background, 0);
-    lv_obj_set_style_text_color(status_bar_, current_theme.text, 0);
+    lv_obj_add_style(status_bar_, &theme_styles_.status_bar, 0);
     
     /* Content */
     content_ = lv_obj_create(container_);
@@ -568,23 +700,30 @@ void LcdDisplay::SetupUI() {
     lv_obj_set_width(content_, LV_HOR_RES);
     lv_obj_set_flex_grow(content_, 1);
     lv_obj_set_style_pad_all(content_, 5, 0);
-    lv_obj_set_style_bg_color(content_, current_theme.chat_background, 0);
-    lv_obj_set_style_border_color(content_, current_theme.border, 0); // Border color for content
+    lv_obj_add_style(content_, &theme_styles_.content, 0);
 
     lv_obj_set_flex_flow(content_, LV_FLEX_FLOW_COLUMN); // 垂直布局（从上到下）
     lv_obj_set_flex_align(content_, LV_FLEX_ALIGN_CENTER, LV_FLEX_ALIGN_CENTER, LV_FLEX_ALIGN_SPACE_EVENLY); // 子对象居中对齐，等距分布
 
     emotion_label_ = lv_label_create(content_);
     lv_obj_set_style_text_font(emotion_label_, &font_awesome_30_4, 0);
-    lv_obj_set_style_text_color(emotion_label_, current_theme.text, 0);
     lv_label_set_text(emotion_label_, FONT_AWESOME_AI_CHIP);
+#if CONFIG_USE_EMOJI_SPRITES
+    CreateEmojiSprites();
+#endif
 
     chat_message_label_ = lv_label_create(content_);
     lv_label_set_text(chat_message_label_, "");
     lv_obj_set_width(chat_message_label_, LV_HOR_RES * 0.9); // 限制宽度为屏幕宽度的 90%
     lv_label_set_long_mode(chat_message_label_, LV_LABEL_LONG_WRAP); // 设置为自动换行模式
     lv_obj_set_style_text_align(chat_message_label_, LV_TEXT_ALIGN_CENTER, 0); // 设置文本居中对齐
-    lv_obj_set_style_text_color(chat_message_label_, current_theme.text, 0);
+
+#if CONFIG_USE_STREAMING_TEXT
+    // 助手回复在这里逐行显示，与 chat_message_label_ 同时只显示一个
+    streaming_text_ = new StreamingText(content_, fonts_.text_font, LV_HOR_RES * 0.9, []() {
+        return Application::GetInstance().GetPlayoutPositionMs();
+    });
+#endif
 
     /* Status bar */
     lv_obj_set_flex_flow(status_bar_, LV_FLEX_FLOW_ROW);
@@ -597,12 +736,10 @@ void LcdDisplay::SetupUI() {
     network_label_ = lv_label_create(status_bar_);
     lv_label_set_text(network_label_, "");
     lv_obj_set_style_text_font(network_label_, fonts_.icon_font, 0);
-    lv_obj_set_style_text_color(network_label_, current_theme.text, 0);
 
     notification_label_ = lv_label_create(status_bar_);
     lv_obj_set_flex_grow(notification_label_, 1);
     lv_obj_set_style_text_align(notification_label_, LV_TEXT_ALIGN_CENTER, 0);
-    lv_obj_set_style_text_color(notification_label_, current_theme.text, 0);
     lv_label_set_text(notification_label_, "");
     lv_obj_add_flag(notification_label_, LV_OBJ_FLAG_HIDDEN);
 
@@ -610,23 +747,20 @@ void LcdDisplay::SetupUI() {
     lv_obj_set_flex_grow(status_label_, 1);
     lv_label_set_long_mode(status_label_, LV_LABEL_LONG_SCROLL_CIRCULAR);
     lv_obj_set_style_text_align(status_label_, LV_TEXT_ALIGN_CENTER, 0);
-    lv_obj_set_style_text_color(status_label_, current_theme.text, 0);
     lv_label_set_text(status_label_, Lang::Strings::INITIALIZING);
     mute_label_ = lv_label_create(status_bar_);
     lv_label_set_text(mute_label_, "");
     lv_obj_set_style_text_font(mute_label_, fonts_.icon_font, 0);
-    lv_obj_set_style_text_color(mute_label_, current_theme.text, 0);
 
     battery_label_ = lv_label_create(status_bar_);
     lv_label_set_text(battery_label_, "");
     lv_obj_set_style_text_font(battery_label_, fonts_.icon_font, 0);
-    lv_obj_set_style_text_color(battery_label_, current_theme.text, 0);
 
     low_battery_popup_ = lv_obj_create(screen);
     lv_obj_set_scrollbar_mode(low_battery_popup_, LV_SCROLLBAR_MODE_OFF);
     lv_obj_set_size(low_battery_popup_, LV_HOR_RES * 0.9, fonts_.text_font->line_height * 2);
     lv_obj_align(low_battery_popup_, LV_ALIGN_BOTTOM_MID, 0, 0);
-    lv_obj_set_style_bg_color(low_battery_popup_, current_theme.low_battery, 0);
+    lv_obj_add_style(low_battery_popup_, &theme_styles_.low_battery, 0);
     lv_obj_set_style_radius(low_battery_popup_, 10, 0);
     lv_obj_t* low_battery_label = lv_label_create(low_battery_popup_);
     lv_label_set_text(low_battery_label, Lang::Strings::BATTERY_NEED_CHARGE);
@@ -634,54 +768,52 @@ void LcdDisplay::SetupUI() {
     lv_obj_center(low_battery_label);
     lv_obj_add_flag(low_battery_popup_, LV_OBJ_FLAG_HIDDEN);
 }
-#endif
 
-void LcdDisplay::SetEmotion(const char* emotion) {
-    struct Emotion {
-        const char* icon;
-        const char* text;
-    };
+#if CONFIG_USE_STREAMING_TEXT
+// 用户消息、系统提示和清空都结束当前的流式回复
+void LcdDisplay::SetChatMessage(const char* role, const char* content) {
+    DisplayLockGuard lock(this);
+    if (streaming_text_ != nullptr && !streaming_text_->empty()) {
+        streaming_text_->Clear();
+        SetHidden(chat_message_label_, false);
+    }
+    Display::SetChatMessage(role, content);
+}
 
-    static const std::vector<Emotion> emotions = {
-        {"😶", "neutral"},
-        {"🙂", "happy"},
-        {"😆", "laughing"},
-        {"😂", "funny"},
-        {"😔", "sad"},
-        {"😠", "angry"},
-        {"😭", "crying"},
-        {"😍", "loving"},
-        {"😳", "embarrassed"},
-        {"😯", "surprised"},
-        {"😱", "shocked"},
-        {"🤔", "thinking"},
-        {"😉", "winking"},
-        {"😎", "cool"},
-        {"😌", "relaxed"},
-        {"🤤", "delicious"},
-        {"😘", "kissy"},
-        {"😏", "confident"},
-        {"😴", "sleepy"},
-        {"😜", "silly"},
-        {"🙄", "confused"}
-    };
-    
-    // 查找匹配的表情
-    std::string_view emotion_view(emotion);
-    auto it = std::find_if(emotions.begin(), emotions.end(),
-        [&emotion_view](const Emotion& e) { return e.text == emotion_view; });
+void LcdDisplay::AppendChatMessage(const char* content, uint32_t start_ms) {
+    DisplayLockGuard lock(this);
+    if (streaming_text_ == nullptr) {
+        return;
+    }
+    if (streaming_text_->empty()) {
+        SetHidden(chat_message_label_, true);
+    }
+    streaming_text_->Append(content, start_ms);
+}
+#endif
+#endif
 
+void LcdDisplay::SetEmotion(const char* emotion) {
+    auto& info = FindEmotion(emotion);
     DisplayLockGuard lock(this);
     if (emotion_label_ == nullptr) {
         return;
     }
-
-    // 如果找到匹配的表情就显示对应图标，否则显示默认的neutral表情
-    lv_obj_set_style_text_font(emotion_label_, fonts_.emoji_font, 0);
-    if (it != emotions.end()) {
-        lv_label_set_text(emotion_label_, it->icon);
+#if CONFIG_USE_EMOJI_SPRITES
+    if (emotion_image_ != nullptr) {
+        auto sprite = &emoji_sprites_[&info - kEmotions];
+        if (lv_image_get_src(emotion_image_) != sprite) {
+            lv_image_set_src(emotion_image_, sprite);
+        }
+        SetHidden(emotion_label_, true);
+        SetHidden(emotion_image_, false);
+        return;
+    }
+#endif
+    if (fonts_.emoji_font != nullptr) {
+        ShowEmotion(info, info.emoji, fonts_.emoji_font);
     } else {
-        lv_label_set_text(emotion_label_, "😶");
+        ShowEmotion(info, info.icon, &font_awesome_30_4);
     }
 }
 
@@ -690,9 +822,83 @@ void LcdDisplay::SetIcon(const char* icon) {
     if (emotion_label_ == nullptr) {
         return;
     }
-    lv_obj_set_style_text_font(emotion_label_, &font_awesome_30_4, 0);
-    lv_label_set_text(emotion_label_, icon);
+#if CONFIG_USE_EMOJI_SPRITES
+    if (emotion_image_ != nullptr) {
+        SetHidden(emotion_image_, true);
+        SetHidden(emotion_label_, false);
+    }
+#endif
+    ShowIcon(icon, &font_awesome_30_4);
+}
+
+#if CONFIG_USE_EMOJI_SPRITES
+// 在 emotion_label_ 后面创建图片对象，并为每个表情分配一张图片
+void LcdDisplay::CreateEmojiSprites() {
+    if (fonts_.emoji_font == nullptr) {
+        return;
+    }
+    // 表情字体的字形都是正方形，边长等于行高
+    int size = fonts_.emoji_font->line_height;
+    uint32_t stride = lv_draw_buf_width_to_stride(size, LV_COLOR_FORMAT_RGB565);
+    uint32_t sprite_size = (stride * size + LV_DRAW_BUF_ALIGN - 1) / LV_DRAW_BUF_ALIGN * LV_DRAW_BUF_ALIGN;
+    size_t count = emotion_table::kEmotionCount;
+    emoji_sprite_data_ = (uint8_t*)heap_caps_aligned_alloc(LV_DRAW_BUF_ALIGN, sprite_size * count, MALLOC_CAP_SPIRAM);
+    if (emoji_sprite_data_ == nullptr) {
+        ESP_LOGW(TAG, "Failed to allocate emoji sprites, fall back to font rendering");
+        return;
+    }
+    emoji_sprites_.resize(count);
+    for (size_t i = 0; i < count; i++) {
+        lv_draw_buf_init(&emoji_sprites_[i], size, size, LV_COLOR_FORMAT_RGB565, stride,
+            emoji_sprite_data_ + i * sprite_size, sprite_size);
+    }
+
+    auto parent = lv_obj_get_parent(emotion_label_);
+    emotion_image_ = lv_image_create(parent);
+    lv_obj_move_to_index(emotion_image_, lv_obj_get_index(emotion_label_) + 1);
+    lv_obj_add_flag(emotion_image_, LV_OBJ_FLAG_HIDDEN);
+    RenderEmojiSprites();
+    ESP_LOGI(TAG, "Pre-rendered %d emoji sprites (%dx%d, %lu bytes)", (int)count, size, size, (unsigned long)(sprite_size * count));
+}
+
+// 图片不带透明通道，字形预先混合到所在区域的背景色上，切换主题后需要重新渲染
+void LcdDisplay::RenderEmojiSprites() {
+    if (emotion_image_ == nullptr) {
+        return;
+    }
+    auto background_obj = lv_obj_get_parent(emotion_image_);
+    while (lv_obj_get_parent(background_obj) != nullptr &&
+        lv_obj_get_style_bg_opa(background_obj, LV_PART_MAIN) < LV_OPA_COVER) {
+        background_obj = lv_obj_get_parent(background_obj);
+    }
+    lv_color_t background = lv_obj_get_style_bg_color(background_obj, LV_PART_MAIN);
+
+    // 借用一个隐藏的画布依次绘制到每张图片的缓冲区
+    lv_obj_t* canvas = lv_canvas_create(lv_layer_top());
+    lv_obj_add_flag(canvas, LV_OBJ_FLAG_HIDDEN);
+    for (size_t i = 0; i < emoji_sprites_.size(); i++) {
+        auto& sprite = emoji_sprites_[i];
+        lv_canvas_set_draw_buf(canvas, &sprite);
+        lv_canvas_fill_bg(canvas, background, LV_OPA_COVER);
+
+        lv_layer_t layer;
+        lv_canvas_init_layer(canvas, &layer);
+        lv_draw_label_dsc_t label_dsc;
+        lv_draw_label_dsc_init(&label_dsc);
+        label_dsc.font = fonts_.emoji_font;
+        label_dsc.color = current_theme.text;
+        label_dsc.text = kEmotions[i].emoji;
+        lv_area_t area = {0, 0, (int32_t)sprite.header.w - 1, (int32_t)sprite.header.h - 1};
+        lv_draw_label(&layer, &label_dsc, &area);
+        lv_canvas_finish_layer(canvas, &layer);
+
+        // 缓冲区内容变了，丢弃图片缓存中的旧条目
+        lv_image_cache_drop(&sprite);
+    }
+    lv_obj_delete(canvas);
+    lv_obj_invalidate(emotion_image_);
 }
+#endif
 
 void LcdDisplay::SetTheme(const std::string& theme_name) {
     DisplayLockGuard lock(this);
@@ -707,181 +913,13 @@ void LcdDisplay::SetTheme(const std::string& theme_name) {
         return;
     }
     
-    // Get the active screen
-    lv_obj_t* screen = lv_screen_active();
-    
-    // Update the screen colors
-    lv_obj_set_style_bg_color(screen, current_theme.background, 0);
-    lv_obj_set_style_text_color(screen, current_theme.text, 0);
-    
-    // Update container colors
-    if (container_ != nullptr) {
-        lv_obj_set_style_bg_color(container_, current_theme.background, 0);
-        lv_obj_set_style_border_color(container_, current_theme.border, 0);
-    }
-    
-    // Update status bar colors
-    if (status_bar_ != nullptr) {
-        lv_obj_set_style_bg_color(status_bar_, current_theme.background, 0);
-        lv_obj_set_style_text_color(status_bar_, current_theme.text, 0);
-        
-        // Update status bar elements
-        if (network_label_ != nullptr) {
-            lv_obj_set_style_text_color(network_label_, current_theme.text, 0);
-        }
-        if (status_label_ != nullptr) {
-            lv_obj_set_style_text_color(status_label_, current_theme.text, 0);
-        }
-        if (notification_label_ != nullptr) {
-            lv_obj_set_style_text_color(notification_label_, current_theme.text, 0);
-        }
-        if (mute_label_ != nullptr) {
-            lv_obj_set_style_text_color(mute_label_, current_theme.text, 0);
-        }
-        if (battery_label_ != nullptr) {
-            lv_obj_set_style_text_color(battery_label_, current_theme.text, 0);
-        }
-        if (emotion_label_ != nullptr) {
-            lv_obj_set_style_text_color(emotion_label_, current_theme.text, 0);
-        }
+    // 所有对象使用共用样式，更新样式后 LVGL 一次刷新
+    if (theme_styles_ready_) {
+        UpdateThemeStyles();
     }
-    
-    // Update content area colors
-    if (content_ != nullptr) {
-        lv_obj_set_style_bg_color(content_, current_theme.chat_background, 0);
-        lv_obj_set_style_border_color(content_, current_theme.border, 0);
-        
-        // If we have the chat message style, update all message bubbles
-#if CONFIG_USE_WECHAT_MESSAGE_STYLE
-        // Iterate through all children of content (message containers or bubbles)
-        uint32_t child_count = lv_obj_get_child_cnt(content_);
-        for (uint32_t i = 0; i < child_count; i++) {
-            lv_obj_t* obj = lv_obj_get_child(content_, i);
-            if (obj == nullptr) continue;
-            
-            lv_obj_t* bubble = nullptr;
-            
-            // 检查这个对象是容器还是气泡
-            // 如果是容器（用户或系统消息），则获取其子对象作为气泡
-            // 如果是气泡（助手消息），则直接使用
-            if (lv_obj_get_child_cnt(obj) > 0) {
-                // 可能是容器，检查它是否为用户或系统消息容器
-                // 用户和系统消息容器是透明的
-                lv_opa_t bg_opa = lv_obj_get_style_bg_opa(obj, 0);
-                if (bg_opa == LV_OPA_TRANSP) {
-                    // 这是用户或系统消息的容器
-                    bubble = lv_obj_get_child(obj, 0);
-                } else {
-                    // 这可能是助手消息的气泡自身
-                    bubble = obj;
-                }
-            } else {
-                // 没有子元素，可能是其他UI元素，跳过
-                continue;
-            }
-            
-            if (bubble == nullptr) continue;
-            
-            // 使用保存的用户数据来识别气泡类型
-            void* bubble_type_ptr = lv_obj_get_user_data(bubble);
-            if (bubble_type_ptr != nullptr) {
-                const char* bubble_type = static_cast<const char*>(bubble_type_ptr);
-                
-                // 根据气泡类型应用正确的颜色
-                if (strcmp(bubble_type, "user") == 0) {
-                    lv_obj_set_style_bg_color(bubble, current_theme.user_bubble, 0);
-                } else if (strcmp(bubble_type, "assistant") == 0) {
-                    lv_obj_set_style_bg_color(bubble, current_theme.assistant_bubble, 0); 
-                } else if (strcmp(bubble_type, "system") == 0) {
-                    lv_obj_set_style_bg_color(bubble, current_theme.system_bubble, 0);
-                }
-                
-                // Update border color
-                lv_obj_set_style_border_color(bubble, current_theme.border, 0);
-                
-                // Update text color for the message
-                if (lv_obj_get_child_cnt(bubble) > 0) {
-                    lv_obj_t* text = lv_obj_get_child(bubble, 0);
-                    if (text != nullptr) {
-                        // 根据气泡类型设置文本颜色
-                        if (strcmp(bubble_type, "system") == 0) {
-                            lv_obj_set_style_text_color(text, current_theme.system_text, 0);
-                        } else {
-                            lv_obj_set_style_text_color(text, current_theme.text, 0);
-                        }
-                    }
-                }
-            } else {
-                // 如果没有标记，回退到之前的逻辑（颜色比较）
-                // ...保留原有的回退逻辑...
-                lv_color_t bg_color = lv_obj_get_style_bg_color(bubble, 0);
-            
-                // 改进bubble类型检测逻辑，不仅使用颜色比较
-                bool is_user_bubble = false;
-                bool is_assistant_bubble = false;
-                bool is_system_bubble = false;
-            
-                // 检查用户bubble
-                if (lv_color_eq(bg_color, DARK_USER_BUBBLE_COLOR) || 
-                    lv_color_eq(bg_color, LIGHT_USER_BUBBLE_COLOR) ||
-                    lv_color_eq(bg_color, current_theme.user_bubble)) {
-                    is_user_bubble = true;
-                }
-                // 检查系统bubble
-                else if (lv_color_eq(bg_color, DARK_SYSTEM_BUBBLE_COLOR) || 
-                         lv_color_eq(bg_color, LIGHT_SYSTEM_BUBBLE_COLOR) ||
-                         lv_color_eq(bg_color, current_theme.system_bubble)) {
-                    is_system_bubble = true;
-                }
-                // 剩余的都当作助手bubble处理
-                else {
-                    is_assistant_bubble = true;
-                }
-            
-                // 根据bubble类型应用正确的颜色
-                if (is_user_bubble) {
-                    lv_obj_set_style_bg_color(bubble, current_theme.user_bubble, 0);
-                } else if (is_assistant_bubble) {
-                    lv_obj_set_style_bg_color(bubble, current_theme.assistant_bubble, 0);
-                } else if (is_system_bubble) {
-                    lv_obj_set_style_bg_color(bubble, current_theme.system_bubble, 0);
-                }
-                
-                // Update border color
-                lv_obj_set_style_border_color(bubble, current_theme.border, 0);
-                
-                // Update text color for the message
-                if (lv_obj_get_child_cnt(bubble) > 0) {
-                    lv_obj_t* text = lv_obj_get_child(bubble, 0);
-                    if (text != nullptr) {
-                        // 回退到颜色检测逻辑
-                        if (lv_color_eq(bg_color, current_theme.system_bubble) ||
-                            lv_color_eq(bg_color, DARK_SYSTEM_BUBBLE_COLOR) || 
-                            lv_color_eq(bg_color, LIGHT_SYSTEM_BUBBLE_COLOR)) {
-                            lv_obj_set_style_text_color(text, current_theme.system_text, 0);
-                        } else {
-                            lv_obj_set_style_text_color(text, current_theme.text, 0);
-                        }
-                    }
-                }
-            }
-        }
-#else
-        // Simple UI mode - just update the main chat message
-        if (chat_message_label_ != nullptr) {
-            lv_obj_set_style_text_color(chat_message_label_, current_theme.text, 0);
-        }
-        
-        if (emotion_label_ != nullptr) {
-            lv_obj_set_style_text_color(emotion_label_, current_theme.text, 0);
-        }
+#if CONFIG_USE_EMOJI_SPRITES
+    RenderEmojiSprites();
 #endif
-    }
-    
-    // Update low battery popup
-    if (low_battery_popup_ != nullptr) {
-        lv_obj_set_style_bg_color(low_battery_popup_, current_theme.low_battery, 0);
-    }
 
     // No errors occurred. Save theme to settings
     Display::SetTheme(theme_name);
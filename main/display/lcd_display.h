@@ -8,6 +8,11 @@
 #include <font_emoji.h>
 
 #include <atomic>
+#include <vector>
+
+class MetricHistogram;
+class StreamingText;
+class MetricGauge;
 
 class LcdDisplay : public Display {
 protected:
@@ -22,6 +27,87 @@ protected:
 
     DisplayFonts fonts_;
 
+    // 界面对象共用的主题样式，颜色只保存在这里，切换主题时只修改样式本身
+    struct ThemeStyles {
+        lv_style_t screen;
+        lv_style_t container;
+        lv_style_t status_bar;
+        lv_style_t content;
+        lv_style_t low_battery;
+    };
+    ThemeStyles theme_styles_;
+    bool theme_styles_ready_ = false;
+
+    void InitThemeStyles();
+    void UpdateThemeStyles();
+
+#if CONFIG_USE_WECHAT_MESSAGE_STYLE
+    enum ChatRole {
+        kChatRoleUser,
+        kChatRoleAssistant,
+        kChatRoleSystem,
+        kChatRoleCount
+    };
+
+    // 预先创建的消息气泡，循环复用，不再在每条消息时创建和删除对象
+    struct ChatBubble {
+        lv_obj_t* row = nullptr;        // 全宽透明行，气泡在其中按角色对齐
+        lv_obj_t* bubble = nullptr;
+        lv_obj_t* label = nullptr;
+        ChatRole role = kChatRoleAssistant;
+    };
+
+    ChatBubble chat_bubbles_[CONFIG_CHAT_BUBBLE_POOL_SIZE];
+    int next_chat_bubble_ = 0;
+    // 所有气泡共用的样式，切换主题时只需修改样式本身
+    lv_style_t chat_row_style_;
+    lv_style_t chat_bubble_style_;
+    lv_style_t chat_role_styles_[kChatRoleCount];
+
+    void CreateChatBubbles();
+    void UpdateChatBubbleStyles();
+#endif
+
+#if CONFIG_USE_STREAMING_TEXT
+    StreamingText* streaming_text_ = nullptr;
+#endif
+
+#if CONFIG_USE_EMOJI_SPRITES
+    // 启动时把表情字形渲染成 RGB565 图片放在 PSRAM，按 kEmotions 的顺序排列，
+    // 切换表情只需更换 emotion_image_ 的图片源。显示图标时仍使用 emotion_label_
+    lv_obj_t* emotion_image_ = nullptr;
+    std::vector<lv_draw_buf_t> emoji_sprites_;
+    uint8_t* emoji_sprite_data_ = nullptr;
+
+    void CreateEmojiSprites();
+    void RenderEmojiSprites();
+#endif
+
+#if CONFIG_LCD_COALESCE_DIRTY_AREAS
+    // 本刷新周期内已合并的脏区域
+    lv_area_t dirty_area_;
+    bool has_dirty_area_ = false;
+
+    // 只用于分块刷新的 SPI/QSPI 屏幕，整屏刷新时每帧都渲染整个屏幕，合并没有意义
+    void SetupDirtyAreaCoalescing();
+    void CoalesceDirtyArea(lv_area_t* area);
+#endif
+
+#if CONFIG_LCD_RENDER_PIPELINE
+    MetricHistogram* render_time_ = nullptr;
+    MetricHistogram* flush_wait_time_ = nullptr;
+    MetricGauge* fps_ = nullptr;
+    int64_t render_start_us_ = 0;
+    int64_t flush_wait_start_us_ = 0;
+    int64_t flush_wait_us_ = 0;
+    int64_t last_frame_us_ = 0;
+    int64_t fps_window_start_us_ = 0;
+    uint32_t fps_frames_ = 0;
+
+    void SetupRenderPipeline();
+    void OnDisplayEvent(lv_event_t* e);
+#endif
+
     void SetupUI();
     virtual bool Lock(int timeout_ms = 0) override;
     virtual void Unlock() override;
@@ -35,9 +121,12 @@ public:
     ~LcdDisplay();
     virtual void SetEmotion(const char* emotion) override;
     virtual void SetIcon(const char* icon) override;
-#if CONFIG_USE_WECHAT_MESSAGE_STYLE
+#if CONFIG_USE_WECHAT_MESSAGE_STYLE || CONFIG_USE_STREAMING_TEXT
     virtual void SetChatMessage(const char* role, const char* content) override; 
 #endif  
+#if CONFIG_USE_STREAMING_TEXT
+    virtual void AppendChatMessage(const char* content, uint32_t start_ms) override;
+#endif
 
     // Add theme switching function
     virtual void SetTheme(const std::string& theme_name) override;
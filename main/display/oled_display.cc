@@ -8,6 +8,9 @@
 #include <esp_log.h>
 #include <esp_err.h>
 #include <esp_lvgl_port.h>
+#if CONFIG_USE_OLED_SHADOW_FRAMEBUFFER
+#include "oled_framebuffer.h"
+#endif
 
 #define TAG "OledDisplay"
 
@@ -54,6 +57,12 @@ OledDisplay::OledDisplay(esp_lcd_panel_io_handle_t panel_io, esp_lcd_panel_handl
         ESP_LOGE(TAG, "Failed to add display");
         return;
     }
+#if CONFIG_USE_OLED_SHADOW_FRAMEBUFFER
+    // 只发送与屏幕上现有内容不同的部分。显示仍按 1bpp 渲染，只替换 flush 回调
+    framebuffer_ = new OledFramebuffer(panel_, width_, height_);
+    framebuffer_->Attach(display_);
+#endif
+    TraceRefresh();
 
     if (height_ == 64) {
         SetupUI_128x64();
@@ -75,6 +84,8 @@ OledDisplay::~OledDisplay() {
     if (container_ != nullptr) {
         lv_obj_del(container_);
     }
+    // 状态栏上的标签已随父对象删除，~Display 不再重复删除
+    network_label_ = nullptr;
 
     if (panel_ != nullptr) {
         esp_lcd_panel_del(panel_);
@@ -83,6 +94,9 @@ OledDisplay::~OledDisplay() {
         esp_lcd_panel_io_del(panel_io_);
     }
     lvgl_port_deinit();
+#if CONFIG_USE_OLED_SHADOW_FRAMEBUFFER
+    delete framebuffer_;
+#endif
 }
 
 bool OledDisplay::Lock(int timeout_ms) {
@@ -104,13 +118,13 @@ void OledDisplay::SetChatMessage(const char* role, const char* content) {
     std::replace(content_str.begin(), content_str.end(), '\n', ' ');
 
     if (content_right_ == nullptr) {
-        lv_label_set_text(chat_message_label_, content_str.c_str());
+        SetLabelText(chat_message_label_, content_str.c_str());
     } else {
         if (content == nullptr || content[0] == '\0') {
-            lv_obj_add_flag(content_right_, LV_OBJ_FLAG_HIDDEN);
+            SetHidden(content_right_, true);
         } else {
-            lv_label_set_text(chat_message_label_, content_str.c_str());
-            lv_obj_clear_flag(content_right_, LV_OBJ_FLAG_HIDDEN);
+            SetLabelText(chat_message_label_, content_str.c_str());
+            SetHidden(content_right_, false);
         }
     }
 }
@@ -6,6 +6,8 @@
 #include <esp_lcd_panel_io.h>
 #include <esp_lcd_panel_ops.h>
 
+class OledFramebuffer;
+
 class OledDisplay : public Display {
 private:
     esp_lcd_panel_io_handle_t panel_io_ = nullptr;
@@ -20,6 +22,10 @@ private:
 
     DisplayFonts fonts_;
 
+#if CONFIG_USE_OLED_SHADOW_FRAMEBUFFER
+    OledFramebuffer* framebuffer_ = nullptr;
+#endif
+
     virtual bool Lock(int timeout_ms = 0) override;
     virtual void Unlock() override;
 
@@ -0,0 +1,189 @@
+#include "oled_framebuffer.h"
+#include "metrics.h"
+
+#include <esp_log.h>
+
+#include <algorithm>
+#include <cstring>
+#include <map>
+
+#define TAG "OledFramebuffer"
+
+// 同一页中相隔不超过这么多列的变化合并为一段，每发送一个矩形还要设置列和页地址
+#define RUN_GAP_COLUMNS 8
+// 每页最多分成这么多段，再多时合并成一段
+#define MAX_RUNS_PER_PAGE 4
+// 按字节估计的每个矩形的额外开销：两条地址命令和一次数据传输的起始
+#define RECT_OVERHEAD_BYTES 12
+
+// display 的用户数据归 esp_lvgl_port 所有，flush 回调通过这张表找到对应的影子帧缓冲区。
+// 只在 LVGL 任务和显示屏创建、销毁时访问
+static std::map<lv_display_t*, OledFramebuffer*> attached_framebuffers;
+
+// 深色像素点亮，与 esp_lvgl_port 的单色转换一致
+static inline bool IsLit(uint16_t rgb565) {
+    uint32_t r = (rgb565 >> 11) << 3;
+    uint32_t g = ((rgb565 >> 5) & 0x3F) << 2;
+    uint32_t b = (rgb565 & 0x1F) << 3;
+    return (r * 77 + g * 151 + b * 28) >> 8 < 128;
+}
+
+OledFramebuffer::OledFramebuffer(esp_lcd_panel_handle_t panel, int width, int height)
+    : panel_(panel), width_(width), pages_((height + 7) / 8) {
+    frame_.resize(width_ * pages_, 0);
+    sent_.resize(width_ * pages_, 0);
+    staging_.resize(width_ * pages_, 0);
+
+    auto& metrics = Metrics::GetInstance();
+    tx_bytes_ = metrics.RegisterCounter("oled_tx_bytes");
+    tx_rects_ = metrics.RegisterCounter("oled_tx_rects");
+}
+
+OledFramebuffer::~OledFramebuffer() {
+    if (display_ != nullptr) {
+        attached_framebuffers.erase(display_);
+    }
+}
+
+void OledFramebuffer::Attach(lv_display_t* display) {
+    display_ = display;
+    attached_framebuffers[display] = this;
+    lv_display_set_flush_cb(display, [](lv_display_t* display, const lv_area_t* area, uint8_t* px_map) {
+        attached_framebuffers.at(display)->Flush(display, area, px_map);
+    });
+    ESP_LOGI(TAG, "Shadow framebuffer %dx%d attached", width_, pages_ * 8);
+}
+
+// 在 LVGL 任务中调用，一次刷新的最后一块写入后才发送
+void OledFramebuffer::Flush(lv_display_t* display, const lv_area_t* area, uint8_t* px_map) {
+    Convert(area, px_map, lv_display_get_color_format(display));
+    if (lv_display_flush_is_last(display)) {
+        Sync();
+    }
+    lv_display_flush_ready(display);
+}
+
+void OledFramebuffer::Convert(const lv_area_t* area, const uint8_t* px_map, lv_color_format_t color_format) {
+    int32_t x1 = std::max<int32_t>(area->x1, 0);
+    int32_t x2 = std::min<int32_t>(area->x2, width_ - 1);
+    int32_t y1 = std::max<int32_t>(area->y1, 0);
+    int32_t y2 = std::min<int32_t>(area->y2, pages_ * 8 - 1);
+    uint32_t stride = lv_draw_buf_width_to_stride(lv_area_get_width(area), color_format);
+    if (color_format == LV_COLOR_FORMAT_I1) {
+        // 跳过调色板，索引 0 为深色
+        px_map += 8;
+    }
+
+    for (int32_t y = y1; y <= y2; y++) {
+        const uint8_t* row = px_map + (y - area->y1) * stride;
+        uint8_t* page = &frame_[(y / 8) * width_];
+        uint8_t bit = 1 << (y % 8);
+        for (int32_t x = x1; x <= x2; x++) {
+            int32_t i = x - area->x1;
+            bool lit;
+            if (color_format == LV_COLOR_FORMAT_I1) {
+                lit = (row[i / 8] & (0x80 >> (i % 8))) == 0;
+            } else {
+                lit = IsLit(reinterpret_cast<const uint16_t*>(row)[i]);
+            }
+            if (lit) {
+                page[x] |= bit;
+            } else {
+                page[x] &= ~bit;
+            }
+        }
+    }
+}
+
+// 逐页找出变化的列段；只有一段的相邻页在多发送的字节不超过单独发送的开销时合并成一个矩形
+void OledFramebuffer::Sync() {
+    if (!sent_valid_) {
+        Send({0, width_, 0, pages_});
+        return;
+    }
+
+    Rect pending = {};
+    bool has_pending = false;
+    for (int p = 0; p < pages_; p++) {
+        const uint8_t* now = &frame_[p * width_];
+        const uint8_t* old = &sent_[p * width_];
+        Rect runs[MAX_RUNS_PER_PAGE];
+        int count = 0;
+        int x = 0;
+        while (x < width_) {
+            if (now[x] == old[x]) {
+                x++;
+                continue;
+            }
+            int start = x;
+            int end = x + 1;
+            for (int gap = 0, i = x + 1; i < width_ && gap < RUN_GAP_COLUMNS; i++) {
+                if (now[i] != old[i]) {
+                    end = i + 1;
+                    gap = 0;
+                } else {
+                    gap++;
+                }
+            }
+            if (count == MAX_RUNS_PER_PAGE) {
+                runs[count - 1].x2 = end;
+            } else {
+                runs[count++] = {start, end, p, p + 1};
+            }
+            x = end;
+        }
+
+        if (count == 1 && has_pending && pending.page2 == p) {
+            auto& run = runs[0];
+            Rect merged = {std::min(pending.x1, run.x1), std::max(pending.x2, run.x2), pending.page1, p + 1};
+            int added = (merged.x2 - merged.x1) * (merged.page2 - merged.page1) -
+                (pending.x2 - pending.x1) * (pending.page2 - pending.page1);
+            if (added <= (run.x2 - run.x1) + RECT_OVERHEAD_BYTES) {
+                pending = merged;
+                continue;
+            }
+        }
+        if (has_pending) {
+            Send(pending);
+            has_pending = false;
+        }
+        if (count == 1) {
+            pending = runs[0];
+            has_pending = true;
+        } else {
+            for (int i = 0; i < count; i++) {
+                Send(runs[i]);
+            }
+        }
+    }
+    if (has_pending) {
+        Send(pending);
+    }
+}
+
+void OledFramebuffer::Send(const Rect& rect) {
+    int width = rect.x2 - rect.x1;
+    uint8_t* out = staging_.data();
+    for (int p = rect.page1; p < rect.page2; p++) {
+        memcpy(out, &frame_[p * width_ + rect.x1], width);
+        out += width;
+    }
+
+    size_t bytes = out - staging_.data();
+    esp_err_t err = esp_lcd_panel_draw_bitmap(panel_, rect.x1, rect.page1 * 8, rect.x2, rect.page2 * 8, staging_.data());
+    if (err != ESP_OK) {
+        // 不确定屏幕上的内容，下一次发送整屏
+        ESP_LOGW(TAG, "Failed to send %dx%d at (%d, %d): %s", width, (rect.page2 - rect.page1) * 8,
+            rect.x1, rect.page1 * 8, esp_err_to_name(err));
+        sent_valid_ = false;
+        return;
+    }
+    for (int p = rect.page1; p < rect.page2; p++) {
+        memcpy(&sent_[p * width_ + rect.x1], &frame_[p * width_ + rect.x1], width);
+    }
+    if (rect.x1 == 0 && rect.x2 == width_ && rect.page1 == 0 && rect.page2 == pages_) {
+        sent_valid_ = true;
+    }
+    tx_bytes_->Add(bytes);
+    tx_rects_->Add();
+}
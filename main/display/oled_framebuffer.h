@@ -0,0 +1,54 @@
+#ifndef OLED_FRAMEBUFFER_H
+#define OLED_FRAMEBUFFER_H
+
+#include <lvgl.h>
+#include <esp_lcd_panel_ops.h>
+
+#include <vector>
+#include <cstdint>
+
+class MetricCounter;
+
+/*
+ * SSD1306 一类单色 OLED 的影子帧缓冲区，按屏幕的页格式保存（每字节是一列中竖向 8 个像素）。
+ * 接管 LVGL 的 flush 回调：一次刷新的所有区域先转换到缓冲区，最后一块写入后
+ * 与上次发送的内容逐页逐列比较，只把变化的部分合并成尽量少的矩形发送，
+ * 减少与音频编解码芯片共用的 I2C 总线占用。
+ * 发送使用同一块中转缓冲区，要求面板 IO 同步发送（I2C）
+ */
+class OledFramebuffer {
+public:
+    OledFramebuffer(esp_lcd_panel_handle_t panel, int width, int height);
+    ~OledFramebuffer();
+
+    // 替换 display 的 flush 回调，不改动 esp_lvgl_port 保存在 display 用户数据中的上下文
+    void Attach(lv_display_t* display);
+
+private:
+    // 列 [x1, x2)，页 [page1, page2)
+    struct Rect {
+        int x1;
+        int x2;
+        int page1;
+        int page2;
+    };
+
+    esp_lcd_panel_handle_t panel_;
+    lv_display_t* display_ = nullptr;
+    int width_;
+    int pages_;
+    std::vector<uint8_t> frame_;    // 最新的渲染结果
+    std::vector<uint8_t> sent_;     // 屏幕上现有的内容
+    std::vector<uint8_t> staging_;  // 发送一个矩形时的连续数据
+    bool sent_valid_ = false;       // 屏幕内容未知时下一次发送整屏
+
+    MetricCounter* tx_bytes_ = nullptr;
+    MetricCounter* tx_rects_ = nullptr;
+
+    void Flush(lv_display_t* display, const lv_area_t* area, uint8_t* px_map);
+    void Convert(const lv_area_t* area, const uint8_t* px_map, lv_color_format_t color_format);
+    void Sync();
+    void Send(const Rect& rect);
+};
+
+#endif // OLED_FRAMEBUFFER_H
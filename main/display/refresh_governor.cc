@@ -0,0 +1,177 @@
+#include "refresh_governor.h"
+#include "metrics.h"
+
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <cJSON.h>
+
+#define TAG "RefreshGovernor"
+
+RefreshGovernor::RefreshGovernor() {
+    Metrics::GetInstance().RegisterSection("display_refresh", [this](bool reset) {
+        return ToJson(reset);
+    });
+}
+
+void RefreshGovernor::Attach(lv_display_t* display, esp_pm_lock_handle_t pm_lock) {
+    if (display_ != nullptr) {
+        return;
+    }
+    display_ = display;
+    pm_lock_ = pm_lock;
+
+    boost_timer_ = lv_timer_create([](lv_timer_t* timer) {
+        auto self = static_cast<RefreshGovernor*>(lv_timer_get_user_data(timer));
+        self->EndBoost();
+    }, CONFIG_REFRESH_GOVERNOR_BOOST_MS, this);
+    lv_timer_pause(boost_timer_);
+
+    lv_display_add_event_cb(display_, [](lv_event_t* e) {
+        auto self = static_cast<RefreshGovernor*>(lv_event_get_user_data(e));
+        self->OnDisplayEvent(e);
+    }, LV_EVENT_ALL, this);
+    ESP_LOGI(TAG, "Refresh period %d ms, %d ms during audio", LV_DEF_REFR_PERIOD, CONFIG_REFRESH_GOVERNOR_LOW_PERIOD_MS);
+}
+
+void RefreshGovernor::SetState(const char* state, bool audio_critical) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto now = esp_timer_get_time();
+        if (current_ != nullptr) {
+            current_->wall_us += now - state_enter_us_;
+        }
+        state_enter_us_ = now;
+        current_ = nullptr;
+        for (auto& stats : states_) {
+            if (stats.name == nullptr || stats.name == state) {
+                stats.name = state;
+                current_ = &stats;
+                break;
+            }
+        }
+    }
+
+    if (display_ == nullptr || audio_critical == audio_critical_) {
+        audio_critical_ = audio_critical;
+        return;
+    }
+    audio_critical_ = audio_critical;
+    Apply();
+}
+
+// 动画按时间计算进度，周期拉长后只是帧数变少，不会变慢
+void RefreshGovernor::Apply() {
+    uint32_t period = audio_critical_ && !boosting_ ? CONFIG_REFRESH_GOVERNOR_LOW_PERIOD_MS : LV_DEF_REFR_PERIOD;
+    auto refresh_timer = lv_display_get_refr_timer(display_);
+    if (refresh_timer != nullptr) {
+        lv_timer_set_period(refresh_timer, period);
+    }
+    auto anim_timer = lv_anim_get_timer();
+    if (anim_timer != nullptr) {
+        lv_timer_set_period(anim_timer, period);
+    }
+}
+
+// 聊天消息滚动时调用，持续时间内按正常周期刷新，重复调用会延长
+void RefreshGovernor::Boost(int duration_ms) {
+    if (display_ == nullptr) {
+        return;
+    }
+    if (!boosting_) {
+        boosting_ = true;
+        if (pm_lock_ != nullptr) {
+            esp_pm_lock_acquire(pm_lock_);
+        }
+        if (audio_critical_) {
+            Apply();
+        }
+    }
+    lv_timer_set_period(boost_timer_, duration_ms);
+    lv_timer_reset(boost_timer_);
+    lv_timer_resume(boost_timer_);
+}
+
+void RefreshGovernor::EndBoost() {
+    lv_timer_pause(boost_timer_);
+    if (!boosting_) {
+        return;
+    }
+    boosting_ = false;
+    if (pm_lock_ != nullptr) {
+        esp_pm_lock_release(pm_lock_);
+    }
+    if (audio_critical_) {
+        Apply();
+    }
+}
+
+// 在 LVGL 任务中调用：刷新定时器每次触发都计入 CPU 占用，实际绘制了内容才计为一帧
+void RefreshGovernor::OnDisplayEvent(lv_event_t* e) {
+    auto now = esp_timer_get_time();
+    switch (lv_event_get_code(e)) {
+    case LV_EVENT_REFR_START:
+        refresh_start_us_ = now;
+        break;
+    case LV_EVENT_RENDER_START:
+        render_start_us_ = now;
+        break;
+    case LV_EVENT_RENDER_READY: {
+        uint32_t frame_us = now - render_start_us_;
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (current_ != nullptr) {
+            current_->frames++;
+            current_->frame_us += frame_us;
+            if (frame_us > current_->max_frame_us) {
+                current_->max_frame_us = frame_us;
+            }
+        }
+        break;
+    }
+    case LV_EVENT_REFR_READY: {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (current_ != nullptr && refresh_start_us_ > 0) {
+            current_->busy_us += now - refresh_start_us_;
+        }
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+cJSON* RefreshGovernor::ToJson(bool reset) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto now = esp_timer_get_time();
+    if (current_ != nullptr) {
+        current_->wall_us += now - state_enter_us_;
+        state_enter_us_ = now;
+    }
+
+    cJSON* root = nullptr;
+    for (auto& stats : states_) {
+        if (stats.name == nullptr) {
+            break;
+        }
+        if (stats.wall_us == 0) {
+            continue;
+        }
+        if (root == nullptr) {
+            root = cJSON_CreateObject();
+        }
+        cJSON* item = cJSON_CreateObject();
+        cJSON_AddNumberToObject(item, "frames", stats.frames);
+        cJSON_AddNumberToObject(item, "avg_frame_us", stats.frames > 0 ? stats.frame_us / stats.frames : 0);
+        cJSON_AddNumberToObject(item, "max_frame_us", stats.max_frame_us);
+        // 千分比
+        cJSON_AddNumberToObject(item, "cpu", stats.busy_us * 1000 / stats.wall_us);
+        cJSON_AddItemToObject(root, stats.name, item);
+        if (reset) {
+            stats.frames = 0;
+            stats.frame_us = 0;
+            stats.max_frame_us = 0;
+            stats.busy_us = 0;
+            stats.wall_us = 0;
+        }
+    }
+    return root;
+}
@@ -0,0 +1,65 @@
+#ifndef REFRESH_GOVERNOR_H
+#define REFRESH_GOVERNOR_H
+
+#include <lvgl.h>
+#include <esp_pm.h>
+
+#include <mutex>
+#include <cstdint>
+
+struct cJSON;
+
+/*
+ * 按设备状态调整 LVGL 刷新：录音和播放期间拉长刷新和动画定时器的周期，把 CPU 让给 AFE 和 Opus，
+ * 聊天消息滚动时临时恢复正常周期并持有 esp_pm 锁；按状态统计帧时间和刷新占用的 CPU 比例，随性能指标上报
+ * 除 ToJson 外都要在持有显示锁时调用
+ */
+class RefreshGovernor {
+public:
+    static RefreshGovernor& GetInstance() {
+        static RefreshGovernor instance;
+        return instance;
+    }
+    // 删除拷贝构造函数和赋值运算符
+    RefreshGovernor(const RefreshGovernor&) = delete;
+    RefreshGovernor& operator=(const RefreshGovernor&) = delete;
+
+    void Attach(lv_display_t* display, esp_pm_lock_handle_t pm_lock);
+    // state 必须是字符串常量
+    void SetState(const char* state, bool audio_critical);
+    void Boost(int duration_ms = CONFIG_REFRESH_GOVERNOR_BOOST_MS);
+
+private:
+    RefreshGovernor();
+
+    static constexpr int kMaxStates = 12;
+
+    struct StateStats {
+        const char* name;
+        uint32_t frames;
+        uint64_t frame_us;
+        uint32_t max_frame_us;
+        uint64_t busy_us;
+        uint64_t wall_us;
+    };
+
+    lv_display_t* display_ = nullptr;
+    esp_pm_lock_handle_t pm_lock_ = nullptr;
+    lv_timer_t* boost_timer_ = nullptr;
+    bool audio_critical_ = false;
+    bool boosting_ = false;
+    int64_t refresh_start_us_ = 0;
+    int64_t render_start_us_ = 0;
+
+    std::mutex mutex_;
+    StateStats states_[kMaxStates] = {};
+    StateStats* current_ = nullptr;
+    int64_t state_enter_us_ = 0;
+
+    void Apply();
+    void EndBoost();
+    void OnDisplayEvent(lv_event_t* e);
+    cJSON* ToJson(bool reset);
+};
+
+#endif // REFRESH_GOVERNOR_H
@@ -0,0 +1,229 @@
+#include "streaming_text.h"
+#if CONFIG_USE_REFRESH_GOVERNOR
+#include "refresh_governor.h"
+#endif
+
+// 检查播放位置的周期
+#define REVEAL_PERIOD_MS 50
+// 这句话的音频已经开始播放，之后播放位置停止前进这么久，认为已经播放完
+#define PLAYOUT_STALL_MS 500
+// 一直没有收到这句话的音频时，等待这么久后直接显示
+#define NO_AUDIO_TIMEOUT_MS 2000
+
+static uint32_t DecodeUtf8(const std::string& text, size_t& pos) {
+    uint8_t c = text[pos++];
+    if (c < 0x80) {
+        return c;
+    }
+    int extra = c >= 0xF0 ? 3 : c >= 0xE0 ? 2 : c >= 0xC0 ? 1 : 0;
+    uint32_t letter = c & (0x3F >> extra);
+    while (extra-- > 0 && pos < text.size()) {
+        letter = (letter << 6) | (text[pos++] & 0x3F);
+    }
+    return letter;
+}
+
+static uint32_t CountUtf8(const char* text) {
+    uint32_t count = 0;
+    for (auto p = text; *p != '\0'; p++) {
+        if ((*p & 0xC0) != 0x80) {
+            count++;
+        }
+    }
+    return count;
+}
+
+StreamingText::StreamingText(lv_obj_t* parent, const lv_font_t* font, int max_width, std::function<uint32_t()> position_ms)
+    : font_(font), max_width_(max_width), position_ms_(position_ms) {
+    container_ = lv_obj_create(parent);
+    lv_obj_remove_style_all(container_);
+    lv_obj_set_size(container_, max_width_, LV_SIZE_CONTENT);
+    lv_obj_set_flex_flow(container_, LV_FLEX_FLOW_COLUMN);
+    lv_obj_set_flex_align(container_, LV_FLEX_ALIGN_START, LV_FLEX_ALIGN_CENTER, LV_FLEX_ALIGN_CENTER);
+    lv_obj_set_style_text_font(container_, font_, 0);
+    lv_obj_remove_flag(container_, LV_OBJ_FLAG_SCROLLABLE);
+    lv_obj_add_flag(container_, LV_OBJ_FLAG_HIDDEN);
+    lines_.resize(CONFIG_STREAMING_TEXT_MAX_LINES, nullptr);
+
+    timer_ = lv_timer_create([](lv_timer_t* timer) {
+        auto self = static_cast<StreamingText*>(lv_timer_get_user_data(timer));
+        self->OnTimer();
+    }, REVEAL_PERIOD_MS, this);
+    lv_timer_pause(timer_);
+}
+
+StreamingText::~StreamingText() {
+    lv_timer_delete(timer_);
+    lv_obj_delete(container_);
+}
+
+void StreamingText::Append(const char* text, uint32_t start_ms) {
+    if (text[0] == '\0') {
+        return;
+    }
+    text_ += text;
+    sentences_.push_back({text_.size(), start_ms, CountUtf8(text)});
+    position_changed_tick_ = lv_tick_get();
+    lv_obj_remove_flag(container_, LV_OBJ_FLAG_HIDDEN);
+    lv_timer_resume(timer_);
+}
+
+void StreamingText::Clear() {
+    lv_timer_pause(timer_);
+    lv_obj_add_flag(container_, LV_OBJ_FLAG_HIDDEN);
+    for (auto line : lines_) {
+        if (line != nullptr) {
+            lv_obj_add_flag(line, LV_OBJ_FLAG_HIDDEN);
+        }
+    }
+    text_.clear();
+    sentences_.clear();
+    revealed_ = 0;
+    first_line_ = 0;
+    line_count_ = 0;
+    tail_.clear();
+    tail_width_ = 0;
+    break_pos_ = 0;
+    break_width_ = 0;
+}
+
+void StreamingText::OnTimer() {
+    auto position = position_ms_();
+    if (position != last_position_ms_) {
+        last_position_ms_ = position;
+        position_changed_tick_ = lv_tick_get();
+    }
+
+    size_t target = RevealTarget(position);
+    // 最后一句的时长只能估计，播放停止后直接显示剩下的文字
+    auto& last = sentences_.back();
+    uint32_t stalled_ms = lv_tick_elaps(position_changed_tick_);
+    if ((position > last.start_ms && stalled_ms >= PLAYOUT_STALL_MS) || stalled_ms >= NO_AUDIO_TIMEOUT_MS) {
+        target = text_.size();
+    }
+
+    if (target > revealed_) {
+        Layout(target);
+    }
+    if (revealed_ == text_.size()) {
+        lv_timer_pause(timer_);
+    }
+}
+
+// 已经知道下一句开始位置的句子按实际时长均匀显示，最后一句按设定语速估计
+size_t StreamingText::RevealTarget(uint32_t position_ms) {
+    size_t begin = 0;
+    for (size_t i = 0; i < sentences_.size(); i++) {
+        auto& sentence = sentences_[i];
+        if (position_ms < sentence.start_ms) {
+            return begin;
+        }
+        uint32_t duration = sentence.chars * 1000 / CONFIG_STREAMING_TEXT_CHARS_PER_SECOND;
+        if (i + 1 < sentences_.size()) {
+            duration = sentences_[i + 1].start_ms > sentence.start_ms ? sentences_[i + 1].start_ms - sentence.start_ms : 0;
+        }
+        uint32_t elapsed = position_ms - sentence.start_ms;
+        if (elapsed >= duration) {
+            begin = sentence.end;
+            continue;
+        }
+
+        uint32_t chars = (uint64_t)sentence.chars * elapsed / duration;
+        size_t pos = begin;
+        while (chars > 0 && pos < sentence.end) {
+            DecodeUtf8(text_, pos);
+            chars--;
+        }
+        return pos;
+    }
+    return text_.size();
+}
+
+// 逐字累加宽度决定换行，只修改最后一行的标签
+void StreamingText::Layout(size_t end) {
+    if (line_count_ == 0) {
+        NewLine();
+    }
+    bool new_line = false;
+    while (revealed_ < end) {
+        size_t next = revealed_;
+        uint32_t letter = DecodeUtf8(text_, next);
+        if (letter == '\n') {
+            lv_label_set_text(TailLabel(), tail_.c_str());
+            NewLine();
+            new_line = true;
+            revealed_ = next;
+            continue;
+        }
+        if (letter == ' ' && tail_.empty() && line_count_ > 1) {
+            // 换行后行首的空格不显示
+            revealed_ = next;
+            continue;
+        }
+
+        size_t peek = next;
+        uint32_t letter_next = next < text_.size() ? DecodeUtf8(text_, peek) : 0;
+        int width = lv_font_get_glyph_width(font_, letter, letter_next);
+        if (tail_width_ + width > max_width_ && !tail_.empty()) {
+            // 英文单词整体移到下一行，中文可以在任意字符后换行
+            std::string carry;
+            int carry_width = 0;
+            if (break_pos_ > 0 && break_pos_ < tail_.size()) {
+                carry = tail_.substr(break_pos_);
+                carry_width = tail_width_ - break_width_;
+                tail_.resize(break_pos_);
+            }
+            lv_label_set_text(TailLabel(), tail_.c_str());
+            NewLine();
+            new_line = true;
+            tail_ = std::move(carry);
+            tail_width_ = carry_width;
+        }
+
+        tail_.append(text_, revealed_, next - revealed_);
+        tail_width_ += width;
+        if (letter == ' ' || letter >= 0x2E80) {
+            break_pos_ = tail_.size();
+            break_width_ = tail_width_;
+        }
+        revealed_ = next;
+    }
+
+    lv_label_set_text(TailLabel(), tail_.c_str());
+    if (new_line) {
+#if CONFIG_USE_REFRESH_GOVERNOR
+        RefreshGovernor::GetInstance().Boost();
+#endif
+        lv_obj_scroll_to_view_recursive(TailLabel(), LV_ANIM_ON);
+    }
+}
+
+// 行数达到上限时把最上面一行移到末尾复用
+void StreamingText::NewLine() {
+    int max_lines = lines_.size();
+    lv_obj_t* label;
+    if (line_count_ < max_lines) {
+        int index = (first_line_ + line_count_) % max_lines;
+        if (lines_[index] == nullptr) {
+            lines_[index] = lv_label_create(container_);
+            lv_label_set_long_mode(lines_[index], LV_LABEL_LONG_CLIP);
+        }
+        label = lines_[index];
+        line_count_++;
+    } else {
+        label = lines_[first_line_];
+        first_line_ = (first_line_ + 1) % max_lines;
+    }
+    lv_obj_move_foreground(label);
+    lv_label_set_text(label, "");
+    lv_obj_remove_flag(label, LV_OBJ_FLAG_HIDDEN);
+
+    tail_.clear();
+    tail_width_ = 0;
+    break_pos_ = 0;
+    break_width_ = 0;
+}
+
+lv_obj_t* StreamingText::TailLabel() const {
+    return lines_[(first_line_ + line_count_ - 1) % lines_.size()];
+}
@@ -0,0 +1,66 @@
+#ifndef STREAMING_TEXT_H
+#define STREAMING_TEXT_H
+
+#include <lvgl.h>
+
+#include <string>
+#include <vector>
+#include <functional>
+#include <cstdint>
+
+/*
+ * 流式显示助手回复：每句话追加到末尾，按音频播放位置逐字显示。
+ * 每行文字是一个单行标签，换行位置在追加时按字形宽度增量计算并缓存，
+ * 已经排满的行不再修改，每次只重新排版最后一行；行数超过上限后循环复用最早的行。
+ * 都要在持有显示锁时调用
+ */
+class StreamingText {
+public:
+    // position_ms 返回当前音频播放位置，在 LVGL 任务中调用
+    StreamingText(lv_obj_t* parent, const lv_font_t* font, int max_width, std::function<uint32_t()> position_ms);
+    ~StreamingText();
+
+    // 追加一句话，start_ms 为这句话开始播放时的播放位置
+    void Append(const char* text, uint32_t start_ms);
+    // 清空并隐藏，下一次 Append 从第一行开始
+    void Clear();
+    bool empty() const { return sentences_.empty(); }
+    lv_obj_t* container() const { return container_; }
+
+private:
+    struct Sentence {
+        size_t end;             // 在 text_ 中的结束位置
+        uint32_t start_ms;
+        uint32_t chars;         // 字符数，用于按播放进度计算显示到哪里
+    };
+
+    lv_obj_t* container_ = nullptr;
+    lv_timer_t* timer_ = nullptr;
+    const lv_font_t* font_;
+    int max_width_;
+    std::function<uint32_t()> position_ms_;
+
+    std::string text_;                  // 已追加的全部文字
+    std::vector<Sentence> sentences_;
+    size_t revealed_ = 0;               // text_ 中已经排版显示的字节数
+    uint32_t last_position_ms_ = 0;
+    uint32_t position_changed_tick_ = 0;
+
+    // 行标签按显示顺序排列，lines_[first_line_] 是最上面一行
+    std::vector<lv_obj_t*> lines_;
+    int first_line_ = 0;
+    int line_count_ = 0;
+    // 最后一行的排版状态
+    std::string tail_;
+    int tail_width_ = 0;
+    size_t break_pos_ = 0;              // 最后一个空格之后的位置，英文单词不从中间断开
+    int break_width_ = 0;
+
+    void OnTimer();
+    size_t RevealTarget(uint32_t position_ms);
+    void Layout(size_t end);
+    void NewLine();
+    lv_obj_t* TailLabel() const;
+};
+
+#endif // STREAMING_TEXT_H
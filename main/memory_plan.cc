@@ -0,0 +1,216 @@
+#include "memory_plan.h"
+#include "task_stacks.h"
+
+#include <esp_log.h>
+#include <esp_heap_caps.h>
+#include <cstring>
+
+#define TAG "MemoryPlan"
+
+// 所有常驻任务和缓冲区，任务栈大小见 task_stacks.h
+static const MemoryPlanEntry kMemoryPlan[] = {
+    {"main_loop", kMemoryPlanStack, MAIN_LOOP_STACK_SIZE, MALLOC_CAP_INTERNAL, 1},
+    {"background_", kMemoryPlanStack, BACKGROUND_TASK_STACK_SIZE, MALLOC_CAP_INTERNAL, CONFIG_BACKGROUND_TASK_WORKERS},
+    {"co_blocking", kMemoryPlanStack, CO_BLOCKING_STACK_SIZE, MALLOC_CAP_INTERNAL, 1},
+#if CONFIG_USE_AUDIO_PROCESSOR
+    {"audio_communication", kMemoryPlanStack, AUDIO_PROCESSOR_STACK_SIZE, MALLOC_CAP_INTERNAL, 1},
+#endif
+#if CONFIG_USE_WAKE_WORD_DETECT
+    {"audio_detection", kMemoryPlanStack, WAKE_WORD_DETECT_STACK_SIZE, MALLOC_CAP_INTERNAL, 1},
+    {"wake_word_encode_stack", kMemoryPlanBuffer, WAKE_WORD_ENCODE_STACK_SIZE, MALLOC_CAP_SPIRAM, 1},
+#endif
+#if CONFIG_USE_TURN_ARENA
+    {"turn_arena", kMemoryPlanBuffer, CONFIG_TURN_ARENA_SIZE * 1024, MALLOC_CAP_SPIRAM, 1},
+#endif
+};
+
+static const MemoryPlanEntry* FindEntry(const char* name) {
+    for (auto& entry : kMemoryPlan) {
+        size_t length = strlen(entry.name);
+        bool prefix = entry.name[length - 1] == '_';
+        if (prefix ? strncmp(name, entry.name, length) == 0 : strcmp(name, entry.name) == 0) {
+            return &entry;
+        }
+    }
+    return nullptr;
+}
+
+#if CONFIG_USE_STATIC_ALLOCATION
+#define MAX_EVENT_GROUPS 4
+static StaticEventGroup_t event_group_buffers[MAX_EVENT_GROUPS];
+
+static inline uint32_t AlignSize(uint32_t size) {
+    return (size + 15) & ~15;
+}
+
+// 每类内存只分配一次，所有计划中的任务栈和缓冲区从中切分
+MemoryPlan::MemoryPlan() {
+    for (auto& entry : kMemoryPlan) {
+        slot_count_ += entry.count;
+    }
+    slots_ = new Slot[slot_count_]();
+
+    static const uint32_t kCaps[] = {MALLOC_CAP_INTERNAL, MALLOC_CAP_SPIRAM};
+    for (auto caps : kCaps) {
+        size_t total = 0;
+        for (auto& entry : kMemoryPlan) {
+            if (entry.caps == caps) {
+                total += AlignSize(entry.size) * entry.count;
+            }
+            // 任务控制块必须在内部 SRAM
+            if (entry.kind == kMemoryPlanStack && caps == MALLOC_CAP_INTERNAL) {
+                total += AlignSize(sizeof(StaticTask_t)) * entry.count;
+            }
+        }
+        if (total == 0) {
+            continue;
+        }
+        auto region = (uint8_t*)heap_caps_malloc(total, caps);
+        if (region == nullptr) {
+            ESP_LOGE(TAG, "Failed to reserve %zu bytes (caps 0x%lx), falling back to dynamic allocation",
+                total, (unsigned long)caps);
+            failed_ = true;
+            continue;
+        }
+
+        int index = 0;
+        for (auto& entry : kMemoryPlan) {
+            for (int i = 0; i < entry.count; i++, index++) {
+                auto& slot = slots_[index];
+                slot.entry = &entry;
+                if (entry.caps == caps) {
+                    slot.memory = region;
+                    region += AlignSize(entry.size);
+                }
+                if (entry.kind == kMemoryPlanStack && caps == MALLOC_CAP_INTERNAL) {
+                    slot.task_buffer = (StaticTask_t*)region;
+                    region += AlignSize(sizeof(StaticTask_t));
+                }
+            }
+        }
+    }
+    PrintReport();
+}
+
+MemoryPlan::Slot* MemoryPlan::FindSlot(const char* name, MemoryPlanKind kind, size_t size) {
+    auto entry = FindEntry(name);
+    if (entry == nullptr || entry->kind != kind) {
+        ESP_LOGE(TAG, "%s is not in the memory plan", name);
+        return nullptr;
+    }
+    if (size > entry->size) {
+        ESP_LOGE(TAG, "%s needs %zu bytes, planned %lu", name, size, (unsigned long)entry->size);
+        return nullptr;
+    }
+    for (int i = 0; i < slot_count_; i++) {
+        auto& slot = slots_[i];
+        if (slot.entry != entry || slot.memory == nullptr) {
+            continue;
+        }
+        // 缓冲区同名返回同一块内存
+        if (!slot.used || kind == kMemoryPlanBuffer) {
+            slot.used = true;
+            return &slot;
+        }
+    }
+    ESP_LOGE(TAG, "No planned memory left for %s", name);
+    return nullptr;
+}
+
+TaskHandle_t MemoryPlan::CreateTask(TaskFunction_t entry, const char* name, uint32_t stack_size, void* arg,
+    UBaseType_t priority, BaseType_t core) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto slot = FindSlot(name, kMemoryPlanStack, stack_size);
+    if (slot != nullptr && slot->task_buffer != nullptr) {
+        return xTaskCreateStaticPinnedToCore(entry, name, slot->entry->size, arg, priority,
+            (StackType_t*)slot->memory, slot->task_buffer, core);
+    }
+    TaskHandle_t handle = nullptr;
+    xTaskCreatePinnedToCore(entry, name, stack_size, arg, priority, &handle, core);
+    return handle;
+}
+
+EventGroupHandle_t MemoryPlan::CreateEventGroup() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (event_group_count_ < MAX_EVENT_GROUPS) {
+        return xEventGroupCreateStatic(&event_group_buffers[event_group_count_++]);
+    }
+    ESP_LOGE(TAG, "More than %d event groups, increase MAX_EVENT_GROUPS", MAX_EVENT_GROUPS);
+    return xEventGroupCreate();
+}
+
+void* MemoryPlan::Allocate(const char* name, size_t size) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto slot = FindSlot(name, kMemoryPlanBuffer, size);
+    if (slot != nullptr) {
+        return slot->memory;
+    }
+    auto entry = FindEntry(name);
+    return heap_caps_malloc(size, entry != nullptr ? entry->caps : MALLOC_CAP_DEFAULT);
+}
+
+void MemoryPlan::Free(void* ptr) {
+    if (ptr == nullptr) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (int i = 0; i < slot_count_; i++) {
+            if (slots_[i].memory == ptr) {
+                return;
+            }
+        }
+    }
+    heap_caps_free(ptr);
+}
+
+void MemoryPlan::PrintReport() {
+    ESP_LOGI(TAG, "Static memory plan%s:", failed_ ? " (incomplete)" : "");
+    size_t internal = 0;
+    size_t spiram = 0;
+    for (auto& entry : kMemoryPlan) {
+        size_t size = AlignSize(entry.size) * entry.count;
+        if (entry.kind == kMemoryPlanStack) {
+            internal += AlignSize(sizeof(StaticTask_t)) * entry.count;
+        }
+        (entry.caps == MALLOC_CAP_SPIRAM ? spiram : internal) += size;
+        ESP_LOGI(TAG, "  %-24s %-6s %6lu x %u  %s", entry.name, entry.kind == kMemoryPlanStack ? "stack" : "buffer",
+            (unsigned long)entry.size, entry.count, entry.caps == MALLOC_CAP_SPIRAM ? "spiram" : "internal");
+    }
+    ESP_LOGI(TAG, "  %-24s %-6s %6zu x %d  %s", "event_groups", "static", sizeof(StaticEventGroup_t), MAX_EVENT_GROUPS, "bss");
+    ESP_LOGI(TAG, "Total: internal %zu bytes, spiram %zu bytes; internal free %zu, largest block %zu", internal, spiram,
+        heap_caps_get_free_size(MALLOC_CAP_INTERNAL), heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL));
+}
+
+#else
+
+MemoryPlan::MemoryPlan() {
+}
+
+TaskHandle_t MemoryPlan::CreateTask(TaskFunction_t entry, const char* name, uint32_t stack_size, void* arg,
+    UBaseType_t priority, BaseType_t core) {
+    TaskHandle_t handle = nullptr;
+    xTaskCreatePinnedToCore(entry, name, stack_size, arg, priority, &handle, core);
+    return handle;
+}
+
+EventGroupHandle_t MemoryPlan::CreateEventGroup() {
+    return xEventGroupCreate();
+}
+
+void* MemoryPlan::Allocate(const char* name, size_t size) {
+    auto entry = FindEntry(name);
+    return heap_caps_malloc(size, entry != nullptr ? entry->caps : MALLOC_CAP_DEFAULT);
+}
+
+void MemoryPlan::Free(void* ptr) {
+    if (ptr != nullptr) {
+        heap_caps_free(ptr);
+    }
+}
+
+void MemoryPlan::PrintReport() {
+    ESP_LOGI(TAG, "Static allocation disabled, tasks and buffers are allocated on demand");
+}
+
+#endif
@@ -0,0 +1,71 @@
+#ifndef MEMORY_PLAN_H
+#define MEMORY_PLAN_H
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/event_groups.h>
+
+#include <mutex>
+#include <cstdint>
+#include <cstddef>
+
+enum MemoryPlanKind {
+    kMemoryPlanStack,      // 任务栈，由 CreateTask 使用
+    kMemoryPlanBuffer,     // 常驻缓冲区，由 Allocate 使用
+};
+
+struct MemoryPlanEntry {
+    const char* name;      // 任务名或缓冲区名，以 '_' 结尾的按前缀匹配，例如 "background_"
+    MemoryPlanKind kind;
+    uint32_t size;
+    uint32_t caps;
+    uint8_t count;         // 同名的实例数
+};
+
+/*
+ * 常驻任务、事件组和音频缓冲区的内存计划
+ * 启用 CONFIG_USE_STATIC_ALLOCATION 时，开机第一次使用时按计划一次性分配所有内存并输出报告，
+ * 之后创建任务和事件组都不再申请内存，长时间运行后也不会因为碎片在对话中途分配失败；
+ * 未启用时按原来的方式动态创建
+ */
+class MemoryPlan {
+public:
+    static MemoryPlan& GetInstance() {
+        static MemoryPlan instance;
+        return instance;
+    }
+    // 删除拷贝构造函数和赋值运算符
+    MemoryPlan(const MemoryPlan&) = delete;
+    MemoryPlan& operator=(const MemoryPlan&) = delete;
+
+    TaskHandle_t CreateTask(TaskFunction_t entry, const char* name, uint32_t stack_size, void* arg,
+        UBaseType_t priority, BaseType_t core = tskNO_AFFINITY);
+    EventGroupHandle_t CreateEventGroup();
+    // 常驻缓冲区；按名字在计划中查找内存类型
+    void* Allocate(const char* name, size_t size);
+    // 释放 Allocate 返回的内存：计划内的内存保留（同名缓冲区共用），计划用完后退回堆上分配的才释放
+    void Free(void* ptr);
+    void PrintReport();
+
+private:
+    MemoryPlan();
+
+#if CONFIG_USE_STATIC_ALLOCATION
+    struct Slot {
+        const MemoryPlanEntry* entry;
+        uint8_t* memory;
+        StaticTask_t* task_buffer;
+        bool used;
+    };
+
+    std::mutex mutex_;
+    Slot* slots_ = nullptr;
+    int slot_count_ = 0;
+    int event_group_count_ = 0;
+    bool failed_ = false;
+
+    Slot* FindSlot(const char* name, MemoryPlanKind kind, size_t size);
+#endif
+};
+
+#endif // MEMORY_PLAN_H
@@ -0,0 +1,205 @@
+#include "metrics.h"
+#include "console.h"
+
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <esp_heap_caps.h>
+#include <cJSON.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#define TAG "Metrics"
+
+MetricHistogram::MetricHistogram(const char* name, std::initializer_list<int> bounds) : name_(name) {
+    for (auto bound : bounds) {
+        if (bucket_count_ == kMaxBuckets) {
+            ESP_LOGW(TAG, "Histogram %s has more than %d buckets", name, kMaxBuckets);
+            break;
+        }
+        bounds_[bucket_count_++] = bound;
+    }
+}
+
+void MetricHistogram::Record(int value) {
+    int bucket = 0;
+    while (bucket < bucket_count_ && value > bounds_[bucket]) {
+        bucket++;
+    }
+    buckets_[bucket].fetch_add(1, std::memory_order_relaxed);
+    sum_.fetch_add(value, std::memory_order_relaxed);
+    int max = max_.load(std::memory_order_relaxed);
+    while (value > max && !max_.compare_exchange_weak(max, value, std::memory_order_relaxed)) {
+    }
+}
+
+MetricCounter* Metrics::RegisterCounter(const char* name) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& counter : counters_) {
+        if (strcmp(counter.name(), name) == 0) {
+            return &counter;
+        }
+    }
+    return &counters_.emplace_back(name);
+}
+
+MetricGauge* Metrics::RegisterGauge(const char* name) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& gauge : gauges_) {
+        if (strcmp(gauge.name(), name) == 0) {
+            return &gauge;
+        }
+    }
+    return &gauges_.emplace_back(name);
+}
+
+MetricHistogram* Metrics::RegisterHistogram(const char* name, std::initializer_list<int> bounds) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& histogram : histograms_) {
+        if (strcmp(histogram.name(), name) == 0) {
+            return &histogram;
+        }
+    }
+    return &histograms_.emplace_back(name, bounds);
+}
+
+void Metrics::RegisterSection(const char* name, std::function<cJSON*(bool reset)> builder) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    sections_.emplace_back(name, std::move(builder));
+}
+
+void Metrics::CollectSystemMetrics() {
+    // 多留几个位置，避免采集期间新建的任务导致获取失败
+    UBaseType_t array_size = uxTaskGetNumberOfTasks() + 5;
+    TaskStatus_t* status_array = (TaskStatus_t*)malloc(sizeof(TaskStatus_t) * array_size);
+    if (status_array == nullptr) {
+        ESP_LOGE(TAG, "Failed to allocate task status array");
+        return;
+    }
+    configRUN_TIME_COUNTER_TYPE total_run_time = 0;
+    array_size = uxTaskGetSystemState(status_array, array_size, &total_run_time);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    uint32_t elapsed = total_run_time - last_total_run_time_;
+    std::map<TaskHandle_t, TaskMetrics> tasks;
+    for (UBaseType_t i = 0; i < array_size; i++) {
+        auto& status = status_array[i];
+        TaskMetrics task = {};
+        strncpy(task.name, status.pcTaskName, sizeof(task.name) - 1);
+        task.run_time = status.ulRunTimeCounter;
+        task.stack_high_water_mark = status.usStackHighWaterMark;
+        // 已经存在的任务才能计算这段时间的占用，总运行时间按所有核心计算
+        auto previous = tasks_.find(status.xHandle);
+        if (previous != tasks_.end() && last_total_run_time_ != 0 && elapsed > 0) {
+            uint64_t task_elapsed = task.run_time - previous->second.run_time;
+            task.cpu_percent = task_elapsed * 100 / ((uint64_t)elapsed * portNUM_PROCESSORS);
+        }
+        tasks.emplace(status.xHandle, task);
+    }
+    free(status_array);
+    tasks_ = std::move(tasks);
+    last_total_run_time_ = total_run_time;
+
+    heaps_.clear();
+    static const struct {
+        const char* name;
+        uint32_t caps;
+    } kHeapCaps[] = {
+        {"internal", MALLOC_CAP_INTERNAL},
+        {"dma", MALLOC_CAP_DMA},
+#if CONFIG_SPIRAM
+        {"spiram", MALLOC_CAP_SPIRAM},
+#endif
+    };
+    for (auto& heap_caps : kHeapCaps) {
+        HeapMetrics heap = {};
+        heap.name = heap_caps.name;
+        heap.caps = heap_caps.caps;
+#ifndef CONFIG_IDF_TARGET_LINUX
+        multi_heap_info_t info;
+        heap_caps_get_info(&info, heap_caps.caps);
+        heap.total_free = info.total_free_bytes;
+        heap.largest_free_block = info.largest_free_block;
+        heap.minimum_free = info.minimum_free_bytes;
+#else
+        heap.total_free = heap_caps_get_free_size(heap_caps.caps);
+        heap.largest_free_block = heap.total_free;
+        heap.minimum_free = heap_caps_get_minimum_free_size(heap_caps.caps);
+#endif
+        heaps_.push_back(heap);
+    }
+}
+
+std::string Metrics::ToJson(bool reset_histograms) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto root = cJSON_CreateObject();
+    cJSON_AddStringToObject(root, "board", BOARD_TYPE);
+    cJSON_AddNumberToObject(root, "uptime", esp_timer_get_time() / 1000000);
+
+    auto counters = cJSON_CreateObject();
+    for (auto& counter : counters_) {
+        cJSON_AddNumberToObject(counters, counter.name(), counter.value());
+    }
+    cJSON_AddItemToObject(root, "counters", counters);
+
+    auto gauges = cJSON_CreateObject();
+    for (auto& gauge : gauges_) {
+        cJSON_AddNumberToObject(gauges, gauge.name(), gauge.value());
+    }
+    cJSON_AddItemToObject(root, "gauges", gauges);
+
+    // {"decode_us":{"le":[上限...],"n":[各桶计数...，最后一个为超出上限],"sum":总和,"max":最大值}}
+    auto histograms = cJSON_CreateObject();
+    for (auto& histogram : histograms_) {
+        auto item = cJSON_CreateObject();
+        cJSON_AddItemToObject(item, "le", cJSON_CreateIntArray(histogram.bounds_, histogram.bucket_count_));
+        int buckets[MetricHistogram::kMaxBuckets + 1];
+        for (int i = 0; i <= histogram.bucket_count_; i++) {
+            buckets[i] = reset_histograms ? histogram.buckets_[i].exchange(0) : histogram.buckets_[i].load();
+        }
+        cJSON_AddItemToObject(item, "n", cJSON_CreateIntArray(buckets, histogram.bucket_count_ + 1));
+        cJSON_AddNumberToObject(item, "sum", reset_histograms ? histogram.sum_.exchange(0) : histogram.sum_.load());
+        cJSON_AddNumberToObject(item, "max", reset_histograms ? histogram.max_.exchange(0) : histogram.max_.load());
+        cJSON_AddItemToObject(histograms, histogram.name(), item);
+    }
+    cJSON_AddItemToObject(root, "histograms", histograms);
+
+    // {"main_loop":[CPU 占用百分比, 栈余量字节]}
+    auto tasks = cJSON_CreateObject();
+    for (auto& [handle, task] : tasks_) {
+        int values[] = {task.cpu_percent, (int)task.stack_high_water_mark};
+        cJSON_AddItemToObject(tasks, task.name, cJSON_CreateIntArray(values, 2));
+    }
+    cJSON_AddItemToObject(root, "tasks", tasks);
+
+    // {"internal":[空闲, 最大连续块, 历史最小空闲, 碎片百分比]}
+    auto heaps = cJSON_CreateObject();
+    for (auto& heap : heaps_) {
+        int fragmentation = heap.total_free > 0 ? 100 - heap.largest_free_block * 100 / heap.total_free : 0;
+        int values[] = {(int)heap.total_free, (int)heap.largest_free_block, (int)heap.minimum_free, fragmentation};
+        cJSON_AddItemToObject(heaps, heap.name, cJSON_CreateIntArray(values, 4));
+    }
+    cJSON_AddItemToObject(root, "heap", heaps);
+
+    for (auto& [name, builder] : sections_) {
+        auto item = builder(reset_histograms);
+        if (item != nullptr) {
+            cJSON_AddItemToObject(root, name, item);
+        }
+    }
+
+    auto json = cJSON_PrintUnformatted(root);
+    std::string result(json);
+    cJSON_free(json);
+    cJSON_Delete(root);
+    return result;
+}
+
+void Metrics::RegisterConsoleCommand() {
+    Console::GetInstance().RegisterCommand("metrics", "Print runtime metrics as JSON",
+        [this](int argc, char** argv) {
+            // 不清零直方图，不影响定期上报的数据
+            printf("%s\n", ToJson(false).c_str());
+            return 0;
+        });
+}
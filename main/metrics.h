@@ -0,0 +1,120 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include <string>
+#include <list>
+#include <vector>
+#include <map>
+#include <functional>
+#include <mutex>
+#include <atomic>
+#include <cstdint>
+#include <initializer_list>
+
+struct cJSON;
+
+// 累加计数，例如丢包数
+class MetricCounter {
+public:
+    explicit MetricCounter(const char* name) : name_(name) {}
+    inline void Add(uint32_t value = 1) { value_.fetch_add(value, std::memory_order_relaxed); }
+    inline uint32_t value() const { return value_.load(std::memory_order_relaxed); }
+    inline const char* name() const { return name_; }
+
+private:
+    const char* name_;
+    std::atomic<uint32_t> value_{0};
+};
+
+// 当前值，例如队列深度
+class MetricGauge {
+public:
+    explicit MetricGauge(const char* name) : name_(name) {}
+    inline void Set(int32_t value) { value_.store(value, std::memory_order_relaxed); }
+    inline int32_t value() const { return value_.load(std::memory_order_relaxed); }
+    inline const char* name() const { return name_; }
+
+private:
+    const char* name_;
+    std::atomic<int32_t> value_{0};
+};
+
+// 固定分桶的直方图，bounds 为各桶的上限（含），超过最后一个上限的值计入最后一个额外的桶
+class MetricHistogram {
+public:
+    static constexpr int kMaxBuckets = 8;
+
+    MetricHistogram(const char* name, std::initializer_list<int> bounds);
+    void Record(int value);
+    inline const char* name() const { return name_; }
+
+private:
+    friend class Metrics;
+    const char* name_;
+    int bounds_[kMaxBuckets] = {};
+    int bucket_count_ = 0;
+    std::atomic<uint32_t> buckets_[kMaxBuckets + 1] = {};
+    std::atomic<uint32_t> sum_{0};
+    std::atomic<int> max_{0};
+};
+
+/*
+ * 运行时性能指标：应用注册的计数器、仪表和直方图，加上定期采集的任务 CPU 占用、栈余量和各类内存的碎片情况
+ * 注册返回的指针在整个运行期间有效，更新指标不加锁，可以在任意任务中调用
+ */
+class Metrics {
+public:
+    static Metrics& GetInstance() {
+        static Metrics instance;
+        return instance;
+    }
+    // 删除拷贝构造函数和赋值运算符
+    Metrics(const Metrics&) = delete;
+    Metrics& operator=(const Metrics&) = delete;
+
+    // name 必须是字符串常量，同名指标返回同一个对象
+    MetricCounter* RegisterCounter(const char* name);
+    MetricGauge* RegisterGauge(const char* name);
+    MetricHistogram* RegisterHistogram(const char* name, std::initializer_list<int> bounds);
+    // 其他模块自己维护的统计，输出时调用 builder 生成 JSON 对象放在 name 下，返回空则不输出
+    void RegisterSection(const char* name, std::function<cJSON*(bool reset)> builder);
+
+    // 采集任务和内存信息，CPU 占用按两次采集之间的运行时间计算，由 Application 每 10 秒调用一次
+    void CollectSystemMetrics();
+    // 紧凑的 JSON 对象，直方图的分桶计数在输出后清零，每次上报的是这段时间内的分布
+    std::string ToJson(bool reset_histograms);
+    void RegisterConsoleCommand();
+
+private:
+    Metrics() = default;
+
+    struct TaskMetrics {
+        char name[configMAX_TASK_NAME_LEN];
+        uint32_t run_time;
+        uint8_t cpu_percent;
+        uint32_t stack_high_water_mark;
+    };
+
+    struct HeapMetrics {
+        const char* name;
+        uint32_t caps;
+        size_t total_free;
+        size_t largest_free_block;
+        size_t minimum_free;
+    };
+
+    std::mutex mutex_;
+    std::list<MetricCounter> counters_;
+    std::list<MetricGauge> gauges_;
+    std::list<MetricHistogram> histograms_;
+    std::list<std::pair<const char*, std::function<cJSON*(bool reset)>>> sections_;
+
+    std::map<TaskHandle_t, TaskMetrics> tasks_;
+    uint32_t last_total_run_time_ = 0;
+    std::vector<HeapMetrics> heaps_;
+};
+
+#endif // METRICS_H
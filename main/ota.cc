@@ -185,7 +185,7 @@ void Ota::Upgrade(const std::string& firmware_url) {
         return;
     }
 
-    ESP_LOGI(TAG, "Writing to partition %s at offset 0x%lx", update_partition->label, update_partition->address);
+    ESP_LOGI(TAG, "Writing to partition %s at offset 0x%lx", update_partition->label, (unsigned long)update_partition->address);
     bool image_header_checked = false;
     std::string image_header;
 
@@ -13,7 +13,6 @@
 #define TAG "MQTT"
 
 MqttProtocol::MqttProtocol() {
-    event_group_handle_ = xEventGroupCreate();
 }
 
 MqttProtocol::~MqttProtocol() {
@@ -24,7 +23,6 @@ MqttProtocol::~MqttProtocol() {
     if (mqtt_ != nullptr) {
         delete mqtt_;
     }
-    vEventGroupDelete(event_group_handle_);
 }
 
 void MqttProtocol::Start() {
@@ -154,17 +152,20 @@ void MqttProtocol::CloseAudioChannel() {
     }
 }
 
-bool MqttProtocol::OpenAudioChannel() {
+CoTask<bool> MqttProtocol::OpenAudioChannel() {
     if (mqtt_ == nullptr || !mqtt_->IsConnected()) {
         ESP_LOGI(TAG, "MQTT is not connected, try to connect now");
-        if (!StartMqttClient(true)) {
-            return false;
+        bool started = co_await CoRunBlocking([this]() {
+            return StartMqttClient(true);
+        });
+        if (!started) {
+            co_return false;
         }
     }
 
     error_occurred_ = false;
     session_id_ = "";
-    xEventGroupClearBits(event_group_handle_, MQTT_PROTOCOL_SERVER_HELLO_EVENT);
+    server_hello_event_.Clear(MQTT_PROTOCOL_SERVER_HELLO_EVENT);
 
     // 发送 hello 消息申请 UDP 通道
     std::string message = "{";
@@ -177,11 +178,12 @@ bool MqttProtocol::OpenAudioChannel() {
     SendText(message);
 
     // 等待服务器响应
-    EventBits_t bits = xEventGroupWaitBits(event_group_handle_, MQTT_PROTOCOL_SERVER_HELLO_EVENT, pdTRUE, pdFALSE, pdMS_TO_TICKS(10000));
+    auto bits = co_await server_hello_event_.Wait(MQTT_PROTOCOL_SERVER_HELLO_EVENT, 10000);
+    server_hello_event_.Clear(MQTT_PROTOCOL_SERVER_HELLO_EVENT);
     if (!(bits & MQTT_PROTOCOL_SERVER_HELLO_EVENT)) {
         ESP_LOGE(TAG, "Failed to receive server hello");
         SetError(Lang::Strings::SERVER_TIMEOUT);
-        return false;
+        co_return false;
     }
 
     std::lock_guard<std::mutex> lock(channel_mutex_);
@@ -231,7 +233,7 @@ bool MqttProtocol::OpenAudioChannel() {
     if (on_audio_channel_opened_ != nullptr) {
         on_audio_channel_opened_();
     }
-    return true;
+    co_return true;
 }
 
 void MqttProtocol::ParseServerHello(const cJSON* root) {
@@ -273,7 +275,7 @@ void MqttProtocol::ParseServerHello(const cJSON* root) {
     mbedtls_aes_setkey_enc(&aes_ctx_, (const unsigned char*)DecodeHexString(key).c_str(), 128);
     local_sequence_ = 0;
     remote_sequence_ = 0;
-    xEventGroupSetBits(event_group_handle_, MQTT_PROTOCOL_SERVER_HELLO_EVENT);
+    server_hello_event_.Set(MQTT_PROTOCOL_SERVER_HELLO_EVENT);
 }
 
 static const char hex_chars[] = "0123456789ABCDEF";
@@ -7,8 +7,6 @@
 #include <udp.h>
 #include <cJSON.h>
 #include <mbedtls/aes.h>
-#include <freertos/FreeRTOS.h>
-#include <freertos/event_groups.h>
 
 #include <functional>
 #include <string>
@@ -27,12 +25,12 @@ public:
 
     void Start() override;
     void SendAudio(const std::vector<uint8_t>& data) override;
-    bool OpenAudioChannel() override;
+    CoTask<bool> OpenAudioChannel() override;
     void CloseAudioChannel() override;
     bool IsAudioChannelOpened() const override;
 
 private:
-    EventGroupHandle_t event_group_handle_;
+    AsyncEvent server_hello_event_;
 
     std::string endpoint_;
     std::string client_id_;
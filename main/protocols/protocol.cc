@@ -115,13 +115,18 @@ void Protocol::SendIotStates(const std::string& states) {
     SendText(message);
 }
 
+void Protocol::SendMetrics(const std::string& metrics) {
+    std::string message = "{\"session_id\":\"" + session_id_ + "\",\"type\":\"metrics\",\"metrics\":" + metrics + "}";
+    SendText(message);
+}
+
 bool Protocol::IsTimeout() const {
     const int kTimeoutSeconds = 120;
     auto now = std::chrono::steady_clock::now();
     auto duration = std::chrono::duration_cast<std::chrono::seconds>(now - last_incoming_time_);
     bool timeout = duration.count() > kTimeoutSeconds;
     if (timeout) {
-        ESP_LOGE(TAG, "Channel timeout %lld seconds", duration.count());
+        ESP_LOGE(TAG, "Channel timeout %lld seconds", (long long)duration.count());
     }
     return timeout;
 }
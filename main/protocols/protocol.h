@@ -6,6 +6,8 @@
 #include <functional>
 #include <chrono>
 
+#include "coroutine.h"
+
 struct BinaryProtocol3 {
     uint8_t type;
     uint8_t reserved;
@@ -42,7 +44,8 @@ public:
     void OnNetworkError(std::function<void(const std::string& message)> callback);
 
     virtual void Start() = 0;
-    virtual bool OpenAudioChannel() = 0;
+    // 在主循环中 co_await，等待服务器响应时不阻塞主循环
+    virtual CoTask<bool> OpenAudioChannel() = 0;
     virtual void CloseAudioChannel() = 0;
     virtual bool IsAudioChannelOpened() const = 0;
     virtual void SendAudio(const std::vector<uint8_t>& data) = 0;
@@ -52,6 +55,7 @@ public:
     virtual void SendAbortSpeaking(AbortReason reason);
     virtual void SendIotDescriptors(const std::string& descriptors);
     virtual void SendIotStates(const std::string& states);
+    virtual void SendMetrics(const std::string& metrics);
 
 protected:
     std::function<void(const cJSON* root)> on_incoming_json_;
@@ -12,14 +12,12 @@
 #define TAG "WS"
 
 WebsocketProtocol::WebsocketProtocol() {
-    event_group_handle_ = xEventGroupCreate();
 }
 
 WebsocketProtocol::~WebsocketProtocol() {
     if (websocket_ != nullptr) {
         delete websocket_;
     }
-    vEventGroupDelete(event_group_handle_);
 }
 
 void WebsocketProtocol::Start() {
@@ -49,18 +47,29 @@ bool WebsocketProtocol::IsAudioChannelOpened() const {
 }
 
 void WebsocketProtocol::CloseAudioChannel() {
+    if (connecting_) {
+        ESP_LOGI(TAG, "Close requested while connecting, close after connect returns");
+        close_requested_ = true;
+        return;
+    }
     if (websocket_ != nullptr) {
         delete websocket_;
         websocket_ = nullptr;
     }
 }
 
-bool WebsocketProtocol::OpenAudioChannel() {
+CoTask<bool> WebsocketProtocol::OpenAudioChannel() {
+    if (connecting_) {
+        ESP_LOGW(TAG, "Another connection is in progress");
+        co_return false;
+    }
     if (websocket_ != nullptr) {
         delete websocket_;
     }
 
     error_occurred_ = false;
+    close_requested_ = false;
+    server_hello_event_.Clear(WEBSOCKET_PROTOCOL_SERVER_HELLO_EVENT);
     std::string url = CONFIG_WEBSOCKET_URL;
     std::string token = "Bearer " + std::string(CONFIG_WEBSOCKET_ACCESS_TOKEN);
     websocket_ = Board::GetInstance().CreateWebSocket();
@@ -101,10 +110,23 @@ bool WebsocketProtocol::OpenAudioChannel() {
         }
     });
 
-    if (!websocket_->Connect(url.c_str())) {
+    // 建立 TLS 连接会阻塞，放到阻塞调用任务中执行
+    auto websocket = websocket_;
+    connecting_ = true;
+    bool connected = co_await CoRunBlocking([websocket, url]() {
+        return websocket->Connect(url.c_str());
+    });
+    connecting_ = false;
+    if (close_requested_) {
+        // 连接期间被关闭，阻塞调用任务已经不再使用 websocket，现在可以删除
+        close_requested_ = false;
+        CloseAudioChannel();
+        co_return false;
+    }
+    if (!connected) {
         ESP_LOGE(TAG, "Failed to connect to websocket server");
         SetError(Lang::Strings::SERVER_NOT_FOUND);
-        return false;
+        co_return false;
     }
 
     // Send hello message to describe the client
@@ -119,18 +141,23 @@ bool WebsocketProtocol::OpenAudioChannel() {
     websocket_->Send(message);
 
     // Wait for server hello
-    EventBits_t bits = xEventGroupWaitBits(event_group_handle_, WEBSOCKET_PROTOCOL_SERVER_HELLO_EVENT, pdTRUE, pdFALSE, pdMS_TO_TICKS(10000));
+    auto bits = co_await server_hello_event_.Wait(WEBSOCKET_PROTOCOL_SERVER_HELLO_EVENT, 10000);
+    server_hello_event_.Clear(WEBSOCKET_PROTOCOL_SERVER_HELLO_EVENT);
+    if (websocket_ != websocket) {
+        // 等待期间通道已被关闭
+        co_return false;
+    }
     if (!(bits & WEBSOCKET_PROTOCOL_SERVER_HELLO_EVENT)) {
         ESP_LOGE(TAG, "Failed to receive server hello");
         SetError(Lang::Strings::SERVER_TIMEOUT);
-        return false;
+        co_return false;
     }
 
     if (on_audio_channel_opened_ != nullptr) {
         on_audio_channel_opened_();
     }
 
-    return true;
+    co_return true;
 }
 
 void WebsocketProtocol::ParseServerHello(const cJSON* root) {
@@ -148,5 +175,5 @@ void WebsocketProtocol::ParseServerHello(const cJSON* root) {
         }
     }
 
-    xEventGroupSetBits(event_group_handle_, WEBSOCKET_PROTOCOL_SERVER_HELLO_EVENT);
+    server_hello_event_.Set(WEBSOCKET_PROTOCOL_SERVER_HELLO_EVENT);
 }
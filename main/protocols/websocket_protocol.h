@@ -5,8 +5,6 @@
 #include "protocol.h"
 
 #include <web_socket.h>
-#include <freertos/FreeRTOS.h>
-#include <freertos/event_groups.h>
 
 #define WEBSOCKET_PROTOCOL_SERVER_HELLO_EVENT (1 << 0)
 
@@ -17,13 +15,17 @@ public:
 
     void Start() override;
     void SendAudio(const std::vector<uint8_t>& data) override;
-    bool OpenAudioChannel() override;
+    CoTask<bool> OpenAudioChannel() override;
     void CloseAudioChannel() override;
     bool IsAudioChannelOpened() const override;
 
 private:
-    EventGroupHandle_t event_group_handle_;
+    AsyncEvent server_hello_event_;
     WebSocket* websocket_ = nullptr;
+    // 连接在阻塞调用任务中进行时 websocket_ 归 OpenAudioChannel 所有，
+    // 期间的关闭请求等连接返回后由 OpenAudioChannel 执行
+    bool connecting_ = false;
+    bool close_requested_ = false;
 
     void ParseServerHello(const cJSON* root);
     void SendText(const std::string& text) override;
@@ -0,0 +1,172 @@
+#include "session_recorder.h"
+#include "board.h"
+#include "audio_codec.h"
+#include "console.h"
+
+#include <esp_log.h>
+#include <esp_timer.h>
+#ifndef CONFIG_IDF_TARGET_LINUX
+#include <esp_heap_caps.h>
+#endif
+#include <mbedtls/base64.h>
+#include <cstring>
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+
+#define TAG "SessionRecorder"
+
+SessionRecorder::~SessionRecorder() {
+    if (buffer_ != nullptr) {
+        free(buffer_);
+    }
+}
+
+bool SessionRecorder::Start(int input_sample_rate, int input_channels, int output_sample_rate) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (dumping_) {
+        ESP_LOGW(TAG, "Session log is being dumped, try again later");
+        return false;
+    }
+    if (buffer_ == nullptr) {
+        capacity_ = CONFIG_SESSION_RECORDER_BUFFER_SIZE * 1024;
+#ifdef CONFIG_IDF_TARGET_LINUX
+        buffer_ = (uint8_t*)malloc(capacity_);
+#else
+        // 一分钟 16kHz 单声道的麦克风数据约 1.9MB，只能放在 PSRAM 中
+        buffer_ = (uint8_t*)heap_caps_malloc(capacity_, MALLOC_CAP_SPIRAM);
+#endif
+        if (buffer_ == nullptr) {
+            ESP_LOGE(TAG, "Failed to allocate %u bytes for session log", (unsigned)capacity_);
+            capacity_ = 0;
+            return false;
+        }
+    }
+
+    header_.magic = SESSION_LOG_MAGIC;
+    header_.version = SESSION_LOG_VERSION;
+    header_.input_channels = input_channels;
+    header_.input_sample_rate = input_sample_rate;
+    header_.output_sample_rate = output_sample_rate;
+    memcpy(buffer_, &header_, sizeof(header_));
+    size_ = sizeof(header_);
+    records_ = 0;
+    last_time_us_ = esp_timer_get_time();
+    recording_ = true;
+    ESP_LOGI(TAG, "Session recording started, buffer %u KB", (unsigned)(capacity_ / 1024));
+    return true;
+}
+
+void SessionRecorder::Stop() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (recording_) {
+        recording_ = false;
+        ESP_LOGI(TAG, "Session recording stopped, %lu records %u bytes", (unsigned long)records_, (unsigned)size_);
+    }
+}
+
+void SessionRecorder::Record(SessionEventType type, const void* data, size_t size) {
+    if (!recording_) {
+        return;
+    }
+    if (size > UINT16_MAX) {
+        ESP_LOGW(TAG, "Record type %d too large: %u bytes", type, (unsigned)size);
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!recording_) {
+        return;
+    }
+    if (size_ + sizeof(SessionRecordHeader) + size > capacity_) {
+        recording_ = false;
+        ESP_LOGW(TAG, "Session log full, recording stopped after %lu records", (unsigned long)records_);
+        return;
+    }
+
+    auto now = esp_timer_get_time();
+    SessionRecordHeader header = {};
+    header.type = type;
+    header.payload_size = size;
+    header.delta_us = now - last_time_us_;
+    last_time_us_ = now;
+    memcpy(buffer_ + size_, &header, sizeof(header));
+    size_ += sizeof(header);
+    if (size > 0) {
+        memcpy(buffer_ + size_, data, size);
+        size_ += size;
+    }
+    records_++;
+}
+
+bool SessionRecorder::SaveToFile(const std::string& path) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (size_ == 0) {
+        ESP_LOGW(TAG, "Session log is empty");
+        return false;
+    }
+    FILE* file = fopen(path.c_str(), "wb");
+    if (file == nullptr) {
+        ESP_LOGE(TAG, "Failed to open %s", path.c_str());
+        return false;
+    }
+    fwrite(buffer_, 1, size_, file);
+    fclose(file);
+    ESP_LOGI(TAG, "Session log saved to %s, %u bytes", path.c_str(), (unsigned)size_);
+    return true;
+}
+
+void SessionRecorder::Dump() {
+    size_t size;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (dumping_) {
+            ESP_LOGW(TAG, "Session log is already being dumped");
+            return;
+        }
+        // 停止录制后缓冲区不再变化，输出几 MB 数据时不必阻塞麦克风和网络任务
+        if (recording_) {
+            recording_ = false;
+            ESP_LOGI(TAG, "Session recording stopped for dump");
+        }
+        size = size_;
+        dumping_ = true;
+    }
+
+    printf("SESSION_LOG_BEGIN %u\n", (unsigned)size);
+    // 每行 48 字节原始数据，对应 64 个 base64 字符
+    unsigned char line[80];
+    for (size_t offset = 0; offset < size; offset += 48) {
+        size_t length = std::min<size_t>(48, size - offset);
+        size_t written = 0;
+        mbedtls_base64_encode(line, sizeof(line) - 1, &written, buffer_ + offset, length);
+        line[written] = '\0';
+        printf("%s\n", line);
+    }
+    printf("SESSION_LOG_END\n");
+    fflush(stdout);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    dumping_ = false;
+}
+
+void SessionRecorder::RegisterConsoleCommand() {
+    Console::GetInstance().RegisterCommand("session", "Session recorder: session start|stop|info|dump|save <file>",
+        [this](int argc, char** argv) {
+            std::string action = argc > 1 ? argv[1] : "info";
+            if (action == "start") {
+                auto codec = Board::GetInstance().GetAudioCodec();
+                Start(codec->input_sample_rate(), codec->input_channels(), codec->output_sample_rate());
+            } else if (action == "stop") {
+                Stop();
+            } else if (action == "dump") {
+                Dump();
+            } else if (action == "save" && argc > 2) {
+                SaveToFile(argv[2]);
+            } else {
+                printf("recording=%d records=%lu size=%u capacity=%u\n", recording_.load() ? 1 : 0,
+                    (unsigned long)records_, (unsigned)size_, (unsigned)capacity_);
+            }
+            return 0;
+        });
+}
@@ -0,0 +1,87 @@
+#ifndef SESSION_RECORDER_H
+#define SESSION_RECORDER_H
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+
+/*
+ * 会话录制文件格式（小端）：
+ * 文件头 SessionLogHeader，之后是若干条记录，每条记录为 SessionRecordHeader + payload
+ * 时间戳保存为相对上一条记录的微秒增量，麦克风帧保存 Codec 原始 PCM（重采样之前）
+ */
+#define SESSION_LOG_MAGIC 0x52535a58 // "XZSR"
+#define SESSION_LOG_VERSION 1
+
+enum SessionEventType : uint8_t {
+    kSessionEventMicFrame = 1,      // int16 PCM，交错存放 input_channels 个声道
+    kSessionEventIncomingJson = 2,  // 服务器下发的 JSON 文本
+    kSessionEventIncomingAudio = 3, // 服务器下发的 Opus 数据包
+    kSessionEventChannelOpened = 4, // uint32 服务器采样率
+    kSessionEventChannelClosed = 5, // 无 payload
+    kSessionEventState = 6,         // uint8 DeviceState
+    kSessionEventCommand = 7,       // 用户输入：toggle / start / stop / wake <唤醒词>
+};
+
+struct SessionLogHeader {
+    uint32_t magic;
+    uint8_t version;
+    uint8_t input_channels;
+    uint16_t reserved;
+    uint32_t input_sample_rate;
+    uint32_t output_sample_rate;
+} __attribute__((packed));
+
+struct SessionRecordHeader {
+    uint8_t type;
+    uint8_t reserved;
+    uint16_t payload_size;
+    uint32_t delta_us;
+} __attribute__((packed));
+
+// 把一次会话的输入（麦克风、下行消息、用户操作）和状态变化录制到 PSRAM 中的缓冲区，供主机回放
+class SessionRecorder {
+public:
+    static SessionRecorder& GetInstance() {
+        static SessionRecorder instance;
+        return instance;
+    }
+    // 删除拷贝构造函数和赋值运算符
+    SessionRecorder(const SessionRecorder&) = delete;
+    SessionRecorder& operator=(const SessionRecorder&) = delete;
+
+    bool Start(int input_sample_rate, int input_channels, int output_sample_rate);
+    void Stop();
+    inline bool IsRecording() const { return recording_; }
+
+    // 缓冲区写满后自动停止录制，保证日志从头到尾是连续的
+    void Record(SessionEventType type, const void* data, size_t size);
+    inline void Record(SessionEventType type, const std::string& text) {
+        Record(type, text.data(), text.size());
+    }
+
+    bool SaveToFile(const std::string& path);
+    // 先停止录制，再以 base64 输出到标准输出，夹在 SESSION_LOG_BEGIN / SESSION_LOG_END 之间，
+    // 由 scripts/session_replay 提取。输出期间不持有锁，也不能重新开始录制
+    void Dump();
+    void RegisterConsoleCommand();
+
+private:
+    SessionRecorder() = default;
+    ~SessionRecorder();
+
+    std::mutex mutex_;
+    uint8_t* buffer_ = nullptr;
+    size_t capacity_ = 0;
+    size_t size_ = 0;
+    int64_t last_time_us_ = 0;
+    uint32_t records_ = 0;
+    std::atomic<bool> recording_ = false;
+    bool dumping_ = false;
+    SessionLogHeader header_ = {};
+};
+
+#endif // SESSION_RECORDER_H
@@ -0,0 +1,142 @@
+#include "stack_profiler.h"
+#include "application.h"
+#include "console.h"
+#include "task_stacks.h"
+
+#include <esp_log.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#define TAG "StackProfiler"
+
+// 栈大小可以由生成的头文件调整的任务，以 '_' 结尾的按前缀匹配
+static const struct {
+    const char* task;
+    const char* macro;
+    uint32_t size;
+} kProfiledTasks[] = {
+    {"main_loop", "MAIN_LOOP_STACK_SIZE", MAIN_LOOP_STACK_SIZE},
+    {"background_", "BACKGROUND_TASK_STACK_SIZE", BACKGROUND_TASK_STACK_SIZE},
+    {"co_blocking", "CO_BLOCKING_STACK_SIZE", CO_BLOCKING_STACK_SIZE},
+    {"audio_communication", "AUDIO_PROCESSOR_STACK_SIZE", AUDIO_PROCESSOR_STACK_SIZE},
+    {"audio_detection", "WAKE_WORD_DETECT_STACK_SIZE", WAKE_WORD_DETECT_STACK_SIZE},
+    {"encode_detect_packets", "WAKE_WORD_ENCODE_STACK_SIZE", WAKE_WORD_ENCODE_STACK_SIZE},
+};
+
+void StackProfiler::Record(const char* name, uint32_t free_bytes) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = min_free_.find(name);
+    if (it == min_free_.end()) {
+        min_free_.emplace(name, free_bytes);
+    } else if (free_bytes < it->second) {
+        it->second = free_bytes;
+    }
+}
+
+void StackProfiler::Sample() {
+    UBaseType_t array_size = uxTaskGetNumberOfTasks() + 5;
+    TaskStatus_t* status_array = (TaskStatus_t*)malloc(sizeof(TaskStatus_t) * array_size);
+    if (status_array == nullptr) {
+        return;
+    }
+    array_size = uxTaskGetSystemState(status_array, array_size, nullptr);
+    for (UBaseType_t i = 0; i < array_size; i++) {
+        // ESP-IDF 中栈的单位是字节
+        Record(status_array[i].pcTaskName, status_array[i].usStackHighWaterMark);
+    }
+    free(status_array);
+}
+
+void StackProfiler::RecordCurrentTask() {
+    Record(pcTaskGetName(nullptr), uxTaskGetStackHighWaterMark(nullptr));
+}
+
+// 每行：任务名,宏名,栈大小,最小剩余；不在 kProfiledTasks 中的任务宏名和栈大小为 -
+void StackProfiler::Dump() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    printf("STACK_PROFILE_BEGIN %s\n", BOARD_TYPE);
+    for (auto& [name, free_bytes] : min_free_) {
+        const char* macro = nullptr;
+        uint32_t size = 0;
+        for (auto& task : kProfiledTasks) {
+            size_t length = strlen(task.task);
+            bool prefix = task.task[length - 1] == '_';
+            if (prefix ? name.compare(0, length, task.task) == 0 : name == task.task) {
+                macro = task.macro;
+                size = task.size;
+                break;
+            }
+        }
+        if (macro != nullptr) {
+            printf("%s,%s,%lu,%lu\n", name.c_str(), macro, (unsigned long)size, (unsigned long)free_bytes);
+        } else {
+            printf("%s,-,-,%lu\n", name.c_str(), (unsigned long)free_bytes);
+        }
+    }
+    printf("STACK_PROFILE_END\n");
+    fflush(stdout);
+}
+
+// 等待设备进入（equal 为 true）或离开 state
+static CoTask<bool> WaitForState(DeviceState state, bool equal, int timeout_ms) {
+    auto& app = Application::GetInstance();
+    for (int elapsed = 0; elapsed < timeout_ms; elapsed += 100) {
+        if ((app.GetDeviceState() == state) == equal) {
+            co_return true;
+        }
+        co_await CoDelay(100);
+    }
+    co_return (app.GetDeviceState() == state) == equal;
+}
+
+// 需要连接 scripts/mock_server：每轮从空闲开始对话，等服务器回复播放完后结束对话
+CoTask<void> StackProfiler::RunWorkload(int cycles) {
+    auto& app = Application::GetInstance();
+    for (int i = 0; i < cycles; i++) {
+        if (!co_await WaitForState(kDeviceStateIdle, true, 30000)) {
+            ESP_LOGW(TAG, "Cycle %d: device is not idle, stop workload", i);
+            break;
+        }
+        app.ToggleChatState();
+        if (!co_await WaitForState(kDeviceStateSpeaking, true, 20000)) {
+            ESP_LOGW(TAG, "Cycle %d: no response from server", i);
+        } else {
+            co_await WaitForState(kDeviceStateSpeaking, false, 60000);
+        }
+        // 自动模式播放完后回到聆听，再次切换结束对话
+        if (app.GetDeviceState() != kDeviceStateIdle) {
+            app.ToggleChatState();
+        }
+        ESP_LOGI(TAG, "Cycle %d/%d done", i + 1, cycles);
+    }
+    co_await WaitForState(kDeviceStateIdle, true, 10000);
+    Sample();
+    Dump();
+    workload_running_ = false;
+}
+
+void StackProfiler::RegisterConsoleCommand() {
+    Console::GetInstance().RegisterCommand("stack_profile", "Stack usage profiler: stack_profile run [cycles]|dump",
+        [this](int argc, char** argv) {
+            std::string action = argc > 1 ? argv[1] : "dump";
+            if (action == "run") {
+                int cycles = argc > 2 ? atoi(argv[2]) : 5;
+                auto& app = Application::GetInstance();
+                app.Schedule([this, cycles]() {
+                    if (workload_running_) {
+                        ESP_LOGW(TAG, "Workload is already running");
+                        return;
+                    }
+                    workload_running_ = true;
+                    CoSpawn(RunWorkload(cycles));
+                });
+            } else {
+                Sample();
+                Dump();
+            }
+            return 0;
+        });
+}
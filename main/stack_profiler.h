@@ -0,0 +1,44 @@
+#ifndef STACK_PROFILER_H
+#define STACK_PROFILER_H
+
+#include "coroutine.h"
+
+#include <string>
+#include <map>
+#include <mutex>
+#include <cstdint>
+
+/*
+ * 栈用量分析：定期记录每个任务栈的历史最小剩余（uxTaskGetStackHighWaterMark），
+ * 由 stack_profile run 按固定流程反复对话覆盖各任务的最深调用，stack_profile dump 输出结果，
+ * 再由 scripts/stack_profile/stack_tool.py 生成板子的 task_stack_sizes.h
+ */
+class StackProfiler {
+public:
+    static StackProfiler& GetInstance() {
+        static StackProfiler instance;
+        return instance;
+    }
+    // 删除拷贝构造函数和赋值运算符
+    StackProfiler(const StackProfiler&) = delete;
+    StackProfiler& operator=(const StackProfiler&) = delete;
+
+    // 采集所有任务，由 Application 每秒调用一次
+    void Sample();
+    // 在即将退出的任务中调用，记录当前任务
+    void RecordCurrentTask();
+    void Dump();
+    void RegisterConsoleCommand();
+
+private:
+    StackProfiler() = default;
+
+    std::mutex mutex_;
+    std::map<std::string, uint32_t> min_free_;
+    bool workload_running_ = false;
+
+    void Record(const char* name, uint32_t free_bytes);
+    CoTask<void> RunWorkload(int cycles);
+};
+
+#endif // STACK_PROFILER_H
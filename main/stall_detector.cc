@@ -0,0 +1,144 @@
+#include "stall_detector.h"
+#include "metrics.h"
+#include "console.h"
+#include "tracer.h"
+
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <cJSON.h>
+#include <cstdio>
+#include <cstring>
+
+#define TAG "StallDetector"
+
+// 卡顿较多时日志本身也会拖慢主循环，每秒最多输出一条警告
+#define STALL_WARNING_INTERVAL_US 1000000
+
+static MetricCounter* stall_counter = nullptr;
+
+static const char* BaseName(const char* path) {
+    auto slash = strrchr(path, '/');
+    return slash != nullptr ? slash + 1 : path;
+}
+
+StallDetector::StallDetector() {
+    stall_counter = Metrics::GetInstance().RegisterCounter("stalls");
+    Metrics::GetInstance().RegisterSection("stalls", [this](bool reset) {
+        return ToJson(reset);
+    });
+}
+
+StallDetector::SiteStats* StallDetector::FindSite(const CallSite& site, const char* queue) {
+    // 同一个调用位置的文件名指针相同，不需要比较字符串
+    uintptr_t hash = (uintptr_t)site.file_name() * 31 + site.line() * 17 + (uintptr_t)queue;
+    for (int i = 0; i < kMaxSites; i++) {
+        auto& stats = sites_[(hash + i) % kMaxSites];
+        if (stats.file == nullptr) {
+            stats.file = site.file_name();
+            stats.function = site.function_name();
+            stats.line = site.line();
+            stats.queue = queue;
+            return &stats;
+        }
+        if (stats.file == site.file_name() && stats.line == site.line() && stats.queue == queue) {
+            return &stats;
+        }
+    }
+    return nullptr;
+}
+
+void StallDetector::Record(const CallSite& site, const char* queue, int64_t duration_us, int64_t budget_us) {
+    bool stalled = budget_us > 0 && duration_us > budget_us;
+    bool warn = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto stats = FindSite(site, queue);
+        if (stats == nullptr) {
+            untracked_++;
+        } else {
+            stats->count++;
+            stats->total_us += duration_us;
+            if (duration_us > stats->max_us) {
+                stats->max_us = duration_us;
+            }
+            if (stalled) {
+                stats->stalls++;
+            }
+        }
+        if (stalled) {
+            auto now = esp_timer_get_time();
+            if (now - last_warning_time_ >= STALL_WARNING_INTERVAL_US) {
+                last_warning_time_ = now;
+                warn = true;
+            }
+        }
+    }
+
+    if (stalled) {
+        stall_counter->Add();
+        TRACE_INSTANT("stall");
+        if (warn) {
+            ESP_LOGW(TAG, "%s: %s:%lu took %lld us (budget %lld us) in %s", queue, BaseName(site.file_name()),
+                (unsigned long)site.line(), (long long)duration_us, (long long)budget_us, site.function_name());
+        }
+    }
+}
+
+// {"application.cc:532":{"q":"main_loop","n":次数,"stall":超过预算次数,"avg":平均耗时,"max":最大耗时}}
+cJSON* StallDetector::ToJson(bool reset) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    cJSON* root = nullptr;
+    for (auto& stats : sites_) {
+        if (stats.file == nullptr || stats.count == 0) {
+            continue;
+        }
+        if (stats.stalls > 0) {
+            if (root == nullptr) {
+                root = cJSON_CreateObject();
+            }
+            char key[64];
+            snprintf(key, sizeof(key), "%s:%lu", BaseName(stats.file), (unsigned long)stats.line);
+            auto item = cJSON_CreateObject();
+            cJSON_AddStringToObject(item, "q", stats.queue);
+            cJSON_AddNumberToObject(item, "n", stats.count);
+            cJSON_AddNumberToObject(item, "stall", stats.stalls);
+            cJSON_AddNumberToObject(item, "avg", (double)(stats.total_us / stats.count));
+            cJSON_AddNumberToObject(item, "max", stats.max_us);
+            cJSON_AddItemToObject(root, key, item);
+        }
+        if (reset) {
+            // 保留位置信息，只清零这段时间的统计
+            stats.count = 0;
+            stats.stalls = 0;
+            stats.total_us = 0;
+            stats.max_us = 0;
+        }
+    }
+    return root;
+}
+
+void StallDetector::Print() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    printf("%-12s %-32s %8s %6s %8s %8s  %s\n", "queue", "site", "count", "stall", "avg_us", "max_us", "function");
+    for (auto& stats : sites_) {
+        if (stats.file == nullptr || stats.count == 0) {
+            continue;
+        }
+        char site[64];
+        snprintf(site, sizeof(site), "%s:%lu", BaseName(stats.file), (unsigned long)stats.line);
+        printf("%-12s %-32s %8lu %6lu %8llu %8lu  %s\n", stats.queue, site, (unsigned long)stats.count,
+            (unsigned long)stats.stalls, (unsigned long long)(stats.total_us / stats.count),
+            (unsigned long)stats.max_us, stats.function);
+    }
+    if (untracked_ > 0) {
+        printf("untracked: %lu\n", (unsigned long)untracked_);
+    }
+}
+
+void StallDetector::RegisterConsoleCommand() {
+    Console::GetInstance().RegisterCommand("stalls", "Print closure run time per call site since the last report",
+        [this](int argc, char** argv) {
+            Print();
+            return 0;
+        });
+}
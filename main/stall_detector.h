@@ -0,0 +1,70 @@
+#ifndef STALL_DETECTOR_H
+#define STALL_DETECTOR_H
+
+#include <cstdint>
+
+#if CONFIG_USE_STALL_DETECTOR
+#include <source_location>
+#include <mutex>
+
+// 投递闭包的调用位置，作为 Schedule 的默认参数在调用处取得
+using CallSite = std::source_location;
+#else
+// 未启用卡顿检测时为空对象，不占用队列空间，也不会把文件名和函数名编译进固件
+struct CallSite {
+    static constexpr CallSite current() { return CallSite(); }
+};
+#endif
+
+#if CONFIG_USE_STALL_DETECTOR
+
+struct cJSON;
+
+/*
+ * 主循环和后台任务的卡顿检测：记录每个投递位置的闭包执行耗时，超过预算时输出警告并计数，
+ * 统计随性能指标定期上报（只上报这段时间内超过预算的位置），上报后清零
+ */
+class StallDetector {
+public:
+    static StallDetector& GetInstance() {
+        static StallDetector instance;
+        return instance;
+    }
+    // 删除拷贝构造函数和赋值运算符
+    StallDetector(const StallDetector&) = delete;
+    StallDetector& operator=(const StallDetector&) = delete;
+
+    // queue 必须是字符串常量
+    void Record(const CallSite& site, const char* queue, int64_t duration_us, int64_t budget_us);
+    void Print();
+    void RegisterConsoleCommand();
+
+private:
+    StallDetector();
+
+    // 按调用位置的哈希开放寻址，满了之后新的位置不再统计
+    static constexpr int kMaxSites = 64;
+
+    struct SiteStats {
+        const char* file;
+        const char* function;
+        uint32_t line;
+        const char* queue;
+        uint32_t count;
+        uint32_t stalls;
+        uint64_t total_us;
+        uint32_t max_us;
+    };
+
+    std::mutex mutex_;
+    SiteStats sites_[kMaxSites] = {};
+    uint32_t untracked_ = 0;
+    int64_t last_warning_time_ = 0;
+
+    SiteStats* FindSite(const CallSite& site, const char* queue);
+    cJSON* ToJson(bool reset);
+};
+
+#endif // CONFIG_USE_STALL_DETECTOR
+
+#endif // STALL_DETECTOR_H
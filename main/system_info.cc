@@ -2,8 +2,10 @@
 
 #include <freertos/task.h>
 #include <esp_log.h>
+#ifndef CONFIG_IDF_TARGET_LINUX
 #include <esp_flash.h>
 #include <esp_mac.h>
+#endif
 #include <esp_system.h>
 #include <esp_partition.h>
 #include <esp_app_desc.h>
@@ -13,12 +15,16 @@
 #define TAG "SystemInfo"
 
 size_t SystemInfo::GetFlashSize() {
+#ifdef CONFIG_IDF_TARGET_LINUX
+    return 0;
+#else
     uint32_t flash_size;
     if (esp_flash_get_size(NULL, &flash_size) != ESP_OK) {
         ESP_LOGE(TAG, "Failed to get flash size");
         return 0;
     }
     return (size_t)flash_size;
+#endif
 }
 
 size_t SystemInfo::GetMinimumFreeHeapSize() {
@@ -30,11 +36,17 @@ size_t SystemInfo::GetFreeHeapSize() {
 }
 
 std::string SystemInfo::GetMacAddress() {
+#ifdef CONFIG_IDF_TARGET_LINUX
+    // 主机构建没有 WiFi MAC，可通过环境变量模拟不同的设备
+    const char* mac_env = getenv("XIAOZHI_MAC_ADDRESS");
+    return mac_env != nullptr ? std::string(mac_env) : std::string("02:00:00:00:00:01");
+#else
     uint8_t mac[6];
     esp_read_mac(mac, ESP_MAC_WIFI_STA);
     char mac_str[18];
     snprintf(mac_str, sizeof(mac_str), "%02x:%02x:%02x:%02x:%02x:%02x", mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
     return std::string(mac_str);
+#endif
 }
 
 std::string SystemInfo::GetChipModelName() {
@@ -103,7 +115,8 @@ esp_err_t SystemInfo::PrintRealTimeStats(TickType_t xTicksToWait) {
         if (k >= 0) {
             uint32_t task_elapsed_time = end_array[k].ulRunTimeCounter - start_array[i].ulRunTimeCounter;
             uint32_t percentage_time = (task_elapsed_time * 100UL) / (total_elapsed_time * CONFIG_FREERTOS_NUMBER_OF_CORES);
-            printf("| %-16s | %8lu | %4lu%%\n", start_array[i].pcTaskName, task_elapsed_time, percentage_time);
+            printf("| %-16s | %8lu | %4lu%%\n", start_array[i].pcTaskName,
+                (unsigned long)task_elapsed_time, (unsigned long)percentage_time);
         }
     }
 
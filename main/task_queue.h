@@ -0,0 +1,290 @@
+#ifndef TASK_QUEUE_H
+#define TASK_QUEUE_H
+
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include <atomic>
+#include <mutex>
+#include <list>
+#include <new>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <type_traits>
+
+#include "stall_detector.h"
+
+// 小对象优化的 void() 可调用对象：捕获不超过 Capacity 字节时直接存放在内部，不分配堆内存
+template <size_t Capacity>
+class InlineFunction {
+public:
+    InlineFunction() = default;
+
+    template <typename F, typename = std::enable_if_t<!std::is_same_v<std::decay_t<F>, InlineFunction>>>
+    InlineFunction(F&& callable) {
+        using T = std::decay_t<F>;
+        if constexpr (sizeof(T) <= Capacity && alignof(T) <= alignof(std::max_align_t)
+                && std::is_nothrow_move_constructible_v<T>) {
+            new (storage_) T(std::forward<F>(callable));
+            invoke_ = [](void* storage) { (*static_cast<T*>(storage))(); };
+            manage_ = [](void* dest, void* src) {
+                if (dest != nullptr) {
+                    new (dest) T(std::move(*static_cast<T*>(src)));
+                }
+                static_cast<T*>(src)->~T();
+            };
+        } else {
+            // 捕获过大时退化为堆分配，只搬移指针
+            *reinterpret_cast<T**>(storage_) = new T(std::forward<F>(callable));
+            invoke_ = [](void* storage) { (**static_cast<T**>(storage))(); };
+            manage_ = [](void* dest, void* src) {
+                if (dest != nullptr) {
+                    *static_cast<T**>(dest) = *static_cast<T**>(src);
+                } else {
+                    delete *static_cast<T**>(src);
+                }
+            };
+            heap_allocated_ = true;
+        }
+    }
+
+    InlineFunction(InlineFunction&& other) noexcept {
+        MoveFrom(other);
+    }
+
+    InlineFunction& operator=(InlineFunction&& other) noexcept {
+        if (this != &other) {
+            Reset();
+            MoveFrom(other);
+        }
+        return *this;
+    }
+
+    InlineFunction(const InlineFunction&) = delete;
+    InlineFunction& operator=(const InlineFunction&) = delete;
+
+    ~InlineFunction() {
+        Reset();
+    }
+
+    void operator()() {
+        invoke_(storage_);
+    }
+
+    explicit operator bool() const { return invoke_ != nullptr; }
+    inline bool heap_allocated() const { return heap_allocated_; }
+
+    void Reset() {
+        if (manage_ != nullptr) {
+            manage_(nullptr, storage_);
+        }
+        invoke_ = nullptr;
+        manage_ = nullptr;
+        heap_allocated_ = false;
+    }
+
+private:
+    alignas(std::max_align_t) unsigned char storage_[Capacity];
+    void (*invoke_)(void* storage) = nullptr;
+    // dest 为空时销毁 src，否则把 src 搬移到 dest 并销毁 src
+    void (*manage_)(void* dest, void* src) = nullptr;
+    bool heap_allocated_ = false;
+
+    void MoveFrom(InlineFunction& other) {
+        if (other.manage_ != nullptr) {
+            other.manage_(storage_, other.storage_);
+        }
+        invoke_ = other.invoke_;
+        manage_ = other.manage_;
+        heap_allocated_ = other.heap_allocated_;
+        other.invoke_ = nullptr;
+        other.manage_ = nullptr;
+        other.heap_allocated_ = false;
+    }
+};
+
+struct TaskQueueStats {
+    uint32_t executed = 0;
+    uint32_t overflows = 0;        // 环形缓冲区已满，进入溢出链表的任务数
+    uint32_t heap_allocations = 0; // 捕获过大而分配堆内存的任务数
+    uint32_t peak_depth = 0;       // 单次 Drain 执行的最多任务数
+    int64_t total_latency_us = 0;  // 从入队到开始执行的时间
+    int64_t max_latency_us = 0;
+};
+
+/*
+ * 固定容量的多生产者单消费者任务队列（基于 Vyukov 有界队列）
+ * 入队无锁、无堆分配；环形缓冲区满时退化到加锁的溢出链表，保证任务不会丢失
+ * Drain 只能在一个任务中调用
+ * 启用卡顿检测时记录每个任务的入队位置，执行超过 budget_us 的任务会被 StallDetector 报告
+ */
+template <size_t Capacity, size_t TaskSize = 8 * sizeof(void*)>
+class TaskQueue {
+    static_assert((Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+    using Task = InlineFunction<TaskSize>;
+
+    explicit TaskQueue(const char* name = "tasks", int64_t budget_us = 0) : name_(name), budget_us_(budget_us) {
+        for (size_t i = 0; i < Capacity; i++) {
+            cells_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    template <typename F>
+    void Push(F&& callable, const CallSite& site = CallSite::current()) {
+        Task task(std::forward<F>(callable));
+        if (task.heap_allocated()) {
+            heap_allocations_.fetch_add(1, std::memory_order_relaxed);
+        }
+        auto now = esp_timer_get_time();
+
+        if (!overflow_pending_.load(std::memory_order_acquire) && TryPush(task, now, site)) {
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(overflow_mutex_);
+        overflow_.push_back({std::move(task), now, site});
+        overflow_pending_.store(true, std::memory_order_release);
+        overflows_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // 执行所有已入队的任务，先执行环形缓冲区中的任务，再执行溢出链表中的任务，保持先后顺序
+    void Drain() {
+        Task task;
+        int64_t enqueue_time;
+        CallSite site;
+        TaskQueueStats drained;
+        while (TryPop(task, enqueue_time, site)) {
+            Run(task, enqueue_time, site, drained);
+        }
+
+        if (overflow_pending_.load(std::memory_order_acquire)) {
+            std::list<Entry> overflow;
+            size_t end_position;
+            {
+                std::lock_guard<std::mutex> lock(overflow_mutex_);
+                overflow = std::move(overflow_);
+                overflow_.clear();
+                end_position = enqueue_position_.load(std::memory_order_relaxed);
+                overflow_pending_.store(false, std::memory_order_release);
+            }
+            // 在溢出之前占用的槽位可能还没写完，这些任务必须先于溢出链表执行
+            while (dequeue_position_ < end_position) {
+                if (TryPop(task, enqueue_time, site)) {
+                    Run(task, enqueue_time, site, drained);
+                } else {
+                    vTaskDelay(1);
+                }
+            }
+            for (auto& entry : overflow) {
+                Run(entry.task, entry.enqueue_time, entry.site, drained);
+            }
+        }
+
+        // 统计在本地累加，每次 Drain 只加一次锁
+        std::lock_guard<std::mutex> lock(stats_mutex_);
+        stats_.executed += drained.executed;
+        stats_.total_latency_us += drained.total_latency_us;
+        if (drained.max_latency_us > stats_.max_latency_us) {
+            stats_.max_latency_us = drained.max_latency_us;
+        }
+        if (drained.executed > stats_.peak_depth) {
+            stats_.peak_depth = drained.executed;
+        }
+    }
+
+    TaskQueueStats GetStats() {
+        std::lock_guard<std::mutex> lock(stats_mutex_);
+        TaskQueueStats stats = stats_;
+        stats.overflows = overflows_.load(std::memory_order_relaxed);
+        stats.heap_allocations = heap_allocations_.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        int64_t enqueue_time;
+        [[no_unique_address]] CallSite site;
+        Task task;
+    };
+    struct Entry {
+        Task task;
+        int64_t enqueue_time;
+        [[no_unique_address]] CallSite site;
+    };
+
+    const char* name_;
+    int64_t budget_us_;
+
+    Cell cells_[Capacity];
+    std::atomic<size_t> enqueue_position_{0};
+    size_t dequeue_position_ = 0;
+
+    std::atomic<bool> overflow_pending_{false};
+    std::mutex overflow_mutex_;
+    std::list<Entry> overflow_;
+
+    std::atomic<uint32_t> overflows_{0};
+    std::atomic<uint32_t> heap_allocations_{0};
+    std::mutex stats_mutex_;
+    TaskQueueStats stats_;
+
+    bool TryPush(Task& task, int64_t now, const CallSite& site) {
+        size_t position = enqueue_position_.load(std::memory_order_relaxed);
+        while (true) {
+            Cell& cell = cells_[position & (Capacity - 1)];
+            size_t sequence = cell.sequence.load(std::memory_order_acquire);
+            intptr_t diff = (intptr_t)sequence - (intptr_t)position;
+            if (diff == 0) {
+                if (enqueue_position_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    cell.task = std::move(task);
+                    cell.enqueue_time = now;
+                    cell.site = site;
+                    cell.sequence.store(position + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                position = enqueue_position_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    bool TryPop(Task& task, int64_t& enqueue_time, CallSite& site) {
+        Cell& cell = cells_[dequeue_position_ & (Capacity - 1)];
+        size_t sequence = cell.sequence.load(std::memory_order_acquire);
+        if ((intptr_t)sequence - (intptr_t)(dequeue_position_ + 1) < 0) {
+            return false;
+        }
+        task = std::move(cell.task);
+        enqueue_time = cell.enqueue_time;
+        site = cell.site;
+        // 先把任务搬出再释放槽位，任务执行期间生产者就可以复用这个槽位
+        cell.sequence.store(dequeue_position_ + Capacity, std::memory_order_release);
+        dequeue_position_++;
+        return true;
+    }
+
+    void Run(Task& task, int64_t enqueue_time, const CallSite& site, TaskQueueStats& stats) {
+        auto start_time = esp_timer_get_time();
+        auto latency = start_time - enqueue_time;
+        task();
+        task.Reset();
+#if CONFIG_USE_STALL_DETECTOR
+        StallDetector::GetInstance().Record(site, name_, esp_timer_get_time() - start_time, budget_us_);
+#endif
+
+        stats.executed++;
+        stats.total_latency_us += latency;
+        if (latency > stats.max_latency_us) {
+            stats.max_latency_us = latency;
+        }
+    }
+};
+
+#endif // TASK_QUEUE_H
@@ -0,0 +1,37 @@
+#ifndef TASK_STACKS_H
+#define TASK_STACKS_H
+
+/*
+ * 常驻任务的栈大小（字节）
+ * 板子目录下有 scripts/stack_profile/stack_tool.py 生成的 task_stack_sizes.h 时使用其中按实测用量计算的大小，
+ * 没有生成的任务使用下面的默认值；栈用量分析模式下始终使用默认值，避免按上次的结果测量
+ */
+#if defined(BOARD_TASK_STACK_SIZES_H) && !CONFIG_USE_STACK_PROFILER
+#include BOARD_TASK_STACK_SIZES_H
+#endif
+
+#ifndef MAIN_LOOP_STACK_SIZE
+#define MAIN_LOOP_STACK_SIZE (4096 * 2)
+#endif
+
+#ifndef BACKGROUND_TASK_STACK_SIZE
+#define BACKGROUND_TASK_STACK_SIZE (4096 * 8)
+#endif
+
+#ifndef CO_BLOCKING_STACK_SIZE
+#define CO_BLOCKING_STACK_SIZE (4096 * 2)
+#endif
+
+#ifndef AUDIO_PROCESSOR_STACK_SIZE
+#define AUDIO_PROCESSOR_STACK_SIZE 4096
+#endif
+
+#ifndef WAKE_WORD_DETECT_STACK_SIZE
+#define WAKE_WORD_DETECT_STACK_SIZE 4096
+#endif
+
+#ifndef WAKE_WORD_ENCODE_STACK_SIZE
+#define WAKE_WORD_ENCODE_STACK_SIZE (4096 * 8)
+#endif
+
+#endif // TASK_STACKS_H
@@ -0,0 +1,192 @@
+#include "tracer.h"
+#include "console.h"
+
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <freertos/task.h>
+#ifndef CONFIG_IDF_TARGET_LINUX
+#include <esp_heap_caps.h>
+#endif
+#include <new>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#define TAG "Tracer"
+
+Tracer::~Tracer() {
+    for (auto& ring : rings_) {
+        if (ring.events != nullptr) {
+            free(ring.events);
+        }
+    }
+}
+
+bool Tracer::Start() {
+    if (running_) {
+        return true;
+    }
+    if (capacity_ == 0) {
+        // 容量取 2 的幂，写入时用掩码代替取模
+        uint32_t capacity = 1;
+        while (capacity * 2 <= CONFIG_TRACER_BUFFER_EVENTS) {
+            capacity *= 2;
+        }
+        size_t size = capacity * sizeof(TraceEvent);
+        for (auto& ring : rings_) {
+#if defined(CONFIG_IDF_TARGET_LINUX) || !CONFIG_SPIRAM
+            void* buffer = malloc(size);
+#else
+            void* buffer = heap_caps_malloc(size, MALLOC_CAP_SPIRAM);
+#endif
+            if (buffer == nullptr) {
+                ESP_LOGE(TAG, "Failed to allocate %u bytes for trace buffer", (unsigned)size);
+                // 释放已经分配的缓冲区，下次 Start 重新分配全部
+                for (auto& allocated : rings_) {
+                    if (allocated.events != nullptr) {
+                        free(allocated.events);
+                        allocated.events = nullptr;
+                    }
+                }
+                return false;
+            }
+            ring.events = (TraceEvent*)buffer;
+            for (uint32_t i = 0; i < capacity; i++) {
+                new (&ring.events[i]) TraceEvent();
+            }
+        }
+        capacity_ = capacity;
+    }
+
+    for (auto& ring : rings_) {
+        for (uint32_t i = 0; i < capacity_; i++) {
+            ring.events[i].info.store(0, std::memory_order_relaxed);
+        }
+        ring.head.store(0, std::memory_order_relaxed);
+    }
+    start_time_us_ = esp_timer_get_time();
+    running_ = true;
+    ESP_LOGI(TAG, "Tracing started, %lu events per core", (unsigned long)capacity_);
+    return true;
+}
+
+void Tracer::Stop() {
+    if (running_.exchange(false)) {
+        ESP_LOGI(TAG, "Tracing stopped");
+    }
+}
+
+uint8_t Tracer::GetTaskIndex() {
+    // 每个任务第一次记录时登记任务名，之后直接使用缓存的编号
+    static thread_local int task_index = -1;
+    if (task_index >= 0) {
+        return task_index;
+    }
+
+    std::lock_guard<std::mutex> lock(task_mutex_);
+    int count = task_count_.load(std::memory_order_relaxed);
+    if (count >= kMaxTasks) {
+        // 超出登记数量的任务共用最后一个编号
+        task_index = kMaxTasks - 1;
+        strncpy(task_names_[task_index], "other", kTaskNameLength - 1);
+        return task_index;
+    }
+    strncpy(task_names_[count], pcTaskGetName(NULL), kTaskNameLength - 1);
+    task_index = count;
+    task_count_.store(count + 1, std::memory_order_release);
+    return task_index;
+}
+
+void Tracer::Write(TraceEventType type, const char* name, int32_t value) {
+    uint32_t timestamp = esp_timer_get_time() - start_time_us_;
+#if portNUM_PROCESSORS > 1
+    int core = xPortGetCoreID();
+#else
+    int core = 0;
+#endif
+    auto& ring = rings_[core];
+    // 同一核心上的任务可能互相抢占，用原子递增占用槽位，不需要加锁
+    uint32_t slot = ring.head.fetch_add(1, std::memory_order_relaxed) & (capacity_ - 1);
+    auto& event = ring.events[slot];
+    event.info.store(0, std::memory_order_relaxed);
+    event.timestamp_us.store(timestamp, std::memory_order_relaxed);
+    event.value.store(value, std::memory_order_relaxed);
+    event.name.store(name, std::memory_order_relaxed);
+    event.info.store(type | GetTaskIndex() << 8 | core << 16, std::memory_order_release);
+}
+
+void Tracer::Dump() {
+    bool was_running = running_.exchange(false);
+    // 等待正在写入的事件完成
+    vTaskDelay(pdMS_TO_TICKS(10));
+
+    uint32_t total = 0;
+    for (auto& ring : rings_) {
+        uint32_t head = ring.head.load(std::memory_order_acquire);
+        total += head < capacity_ ? head : capacity_;
+    }
+    printf("TRACE_JSON_BEGIN %lu\n", (unsigned long)total);
+
+    int task_count = task_count_.load(std::memory_order_acquire);
+    for (int i = 0; i < task_count; i++) {
+        printf("{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":0,\"tid\":%d,\"args\":{\"name\":\"%s\"}}\n",
+            i, task_names_[i]);
+    }
+
+    static const char* phases[] = {"", "B", "E", "C", "i"};
+    for (auto& ring : rings_) {
+        if (ring.events == nullptr) {
+            continue;
+        }
+        uint32_t head = ring.head.load(std::memory_order_acquire);
+        uint32_t count = head < capacity_ ? head : capacity_;
+        // 从最早的事件开始输出
+        for (uint32_t i = head - count; i != head; i++) {
+            auto& event = ring.events[i & (capacity_ - 1)];
+            uint32_t info = event.info.load(std::memory_order_acquire);
+            int type = info & 0xff;
+            int task = (info >> 8) & 0xff;
+            int core = info >> 16;
+            if (type == kTraceEventNone || type > kTraceEventInstant) {
+                continue;
+            }
+            auto name = event.name.load(std::memory_order_relaxed);
+            unsigned long timestamp = event.timestamp_us.load(std::memory_order_relaxed);
+            if (type == kTraceEventCounter) {
+                printf("{\"ph\":\"C\",\"name\":\"%s\",\"ts\":%lu,\"pid\":0,\"tid\":%d,\"args\":{\"value\":%ld}}\n",
+                    name, timestamp, task, (long)event.value.load(std::memory_order_relaxed));
+            } else {
+                printf("{\"ph\":\"%s\",\"name\":\"%s\",\"ts\":%lu,\"pid\":0,\"tid\":%d,\"args\":{\"core\":%d}}\n",
+                    phases[type], name, timestamp, task, core);
+            }
+        }
+    }
+    printf("TRACE_JSON_END\n");
+    fflush(stdout);
+
+    if (was_running) {
+        running_ = true;
+    }
+}
+
+void Tracer::RegisterConsoleCommand() {
+    Console::GetInstance().RegisterCommand("trace", "Event tracer: trace start|stop|dump|info",
+        [this](int argc, char** argv) {
+            std::string action = argc > 1 ? argv[1] : "info";
+            if (action == "start") {
+                Start();
+            } else if (action == "stop") {
+                Stop();
+            } else if (action == "dump") {
+                Dump();
+            } else {
+                printf("running=%d capacity=%lu tasks=%d\n", IsRunning() ? 1 : 0,
+                    (unsigned long)capacity_, task_count_.load());
+                for (int core = 0; core < portNUM_PROCESSORS; core++) {
+                    printf("core %d: %lu events\n", core, (unsigned long)rings_[core].head.load());
+                }
+            }
+            return 0;
+        });
+}
@@ -0,0 +1,124 @@
+#ifndef TRACER_H
+#define TRACER_H
+
+/*
+ * 低开销事件跟踪，用于查看 30ms 音频周期内各个任务的耗时
+ * 未启用 CONFIG_USE_TRACER 时所有 TRACE_* 宏展开为空，参数也不会被求值
+ *
+ * TRACE_SCOPE("decode");                   // 作用域开始和结束
+ * TRACE_BEGIN("fetch"); ... TRACE_END("fetch");
+ * TRACE_COUNTER("send_queue", bytes);      // 计数器，例如队列深度、剩余内存
+ *
+ * name 必须是字符串常量，缓冲区中只保存指针；不能在中断中调用
+ */
+
+#if CONFIG_USE_TRACER
+
+#include <freertos/FreeRTOS.h>
+
+#include <atomic>
+#include <mutex>
+#include <cstdint>
+#include <cstddef>
+
+enum TraceEventType : uint8_t {
+    kTraceEventNone = 0,
+    kTraceEventBegin = 1,
+    kTraceEventEnd = 2,
+    kTraceEventCounter = 3,
+    kTraceEventInstant = 4,
+};
+
+// 缓冲区写满后新事件可能和被抢占的旧写入者落到同一个槽位，所以每个字段都是原子的（relaxed 写入等同于普通写入）
+struct TraceEvent {
+    std::atomic<uint32_t> timestamp_us; // 相对开始跟踪的时间
+    std::atomic<int32_t> value;
+    std::atomic<const char*> name;
+    // type | task << 8 | core << 16，最后写入，0 表示槽位为空或者正在写入
+    std::atomic<uint32_t> info;
+};
+
+// 每个核心一个环形缓冲区，写满后覆盖最早的事件，需要时导出最近一段时间的记录
+class Tracer {
+public:
+    static Tracer& GetInstance() {
+        static Tracer instance;
+        return instance;
+    }
+    // 删除拷贝构造函数和赋值运算符
+    Tracer(const Tracer&) = delete;
+    Tracer& operator=(const Tracer&) = delete;
+
+    bool Start();
+    void Stop();
+    inline bool IsRunning() const { return running_.load(std::memory_order_relaxed); }
+
+    inline void Record(TraceEventType type, const char* name, int32_t value = 0) {
+        if (running_.load(std::memory_order_relaxed)) {
+            Write(type, name, value);
+        }
+    }
+
+    // 以 Chrome trace JSON 输出到标准输出，每行一个事件，夹在 TRACE_JSON_BEGIN / TRACE_JSON_END 之间，
+    // 由 scripts/trace 转换为 Perfetto / chrome://tracing 可以打开的文件
+    void Dump();
+    void RegisterConsoleCommand();
+
+private:
+    Tracer() = default;
+    ~Tracer();
+
+    static constexpr int kMaxTasks = 32;
+    static constexpr int kTaskNameLength = 16;
+
+    struct Ring {
+        TraceEvent* events = nullptr;
+        std::atomic<uint32_t> head{0};
+    };
+
+    std::atomic<bool> running_{false};
+    Ring rings_[portNUM_PROCESSORS];
+    uint32_t capacity_ = 0;
+    int64_t start_time_us_ = 0;
+
+    std::mutex task_mutex_;
+    char task_names_[kMaxTasks][kTaskNameLength] = {};
+    std::atomic<int> task_count_{0};
+
+    void Write(TraceEventType type, const char* name, int32_t value);
+    uint8_t GetTaskIndex();
+};
+
+class TraceScope {
+public:
+    explicit TraceScope(const char* name) : name_(name) {
+        Tracer::GetInstance().Record(kTraceEventBegin, name_);
+    }
+    ~TraceScope() {
+        Tracer::GetInstance().Record(kTraceEventEnd, name_);
+    }
+
+private:
+    const char* name_;
+};
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+
+#define TRACE_BEGIN(name) Tracer::GetInstance().Record(kTraceEventBegin, name)
+#define TRACE_END(name) Tracer::GetInstance().Record(kTraceEventEnd, name)
+#define TRACE_INSTANT(name) Tracer::GetInstance().Record(kTraceEventInstant, name)
+#define TRACE_COUNTER(name, value) Tracer::GetInstance().Record(kTraceEventCounter, name, (int32_t)(value))
+#define TRACE_SCOPE(name) TraceScope TRACE_CONCAT(trace_scope_, __LINE__)(name)
+
+#else
+
+#define TRACE_BEGIN(name) ((void)0)
+#define TRACE_END(name) ((void)0)
+#define TRACE_INSTANT(name) ((void)0)
+#define TRACE_COUNTER(name, value) ((void)0)
+#define TRACE_SCOPE(name) ((void)0)
+
+#endif // CONFIG_USE_TRACER
+
+#endif // TRACER_H
@@ -0,0 +1,150 @@
+#include "turn_arena.h"
+#include "metrics.h"
+#include "memory_plan.h"
+
+#include <esp_log.h>
+#include <esp_heap_caps.h>
+#include <cstdlib>
+
+#define TAG "TurnArena"
+
+bool TurnArena::Initialize() {
+    initialized_ = true;
+#if CONFIG_USE_TURN_ARENA
+    int block_count = CONFIG_TURN_ARENA_SIZE * 1024 / kBlockSize;
+    base_ = (uint8_t*)MemoryPlan::GetInstance().Allocate("turn_arena", block_count * kBlockSize);
+    if (base_ == nullptr) {
+        ESP_LOGE(TAG, "Failed to allocate %d KB for turn arena", CONFIG_TURN_ARENA_SIZE);
+        return false;
+    }
+    blocks_.resize(block_count);
+    // 倒序放入，先使用地址低的块
+    for (int i = block_count - 1; i >= 0; i--) {
+        free_blocks_.push_back(i);
+    }
+    ESP_LOGI(TAG, "Turn arena: %d blocks of %u KB in PSRAM", block_count, (unsigned)(kBlockSize / 1024));
+    return true;
+#else
+    return false;
+#endif
+}
+
+// 当前块放不下时换一个空闲块，当前块等其中的分配全部释放后回收
+bool TurnArena::NextBlock() {
+    if (current_ >= 0 && blocks_[current_].live == 0) {
+        blocks_[current_].offset = 0;
+        return true;
+    }
+    if (free_blocks_.empty()) {
+        return false;
+    }
+    current_ = free_blocks_.back();
+    free_blocks_.pop_back();
+    blocks_[current_].offset = 0;
+
+    uint32_t used_blocks = blocks_.size() - free_blocks_.size();
+    if (used_blocks > stats_.peak_blocks) {
+        stats_.peak_blocks = used_blocks;
+    }
+    return true;
+}
+
+void* TurnArena::Allocate(size_t size) {
+    size = (size + kAlignment - 1) & ~(kAlignment - 1);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!initialized_) {
+            Initialize();
+        }
+        if (base_ != nullptr) {
+            stats_.allocations++;
+            if (size <= kBlockSize) {
+                if ((current_ >= 0 && blocks_[current_].offset + size <= kBlockSize) || NextBlock()) {
+                    auto& block = blocks_[current_];
+                    void* ptr = base_ + current_ * kBlockSize + block.offset;
+                    block.offset += size;
+                    block.live++;
+                    return ptr;
+                }
+            }
+            stats_.fallbacks++;
+        }
+    }
+    return malloc(size);
+}
+
+void TurnArena::Free(void* ptr) {
+    if (ptr == nullptr) {
+        return;
+    }
+    auto address = (uint8_t*)ptr;
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (base_ == nullptr || address < base_ || address >= base_ + blocks_.size() * kBlockSize) {
+        lock.unlock();
+        free(ptr);
+        return;
+    }
+
+    int index = (address - base_) / kBlockSize;
+    auto& block = blocks_[index];
+    if (--block.live == 0) {
+        if (index == current_) {
+            block.offset = 0;
+        } else {
+            free_blocks_.push_back(index);
+        }
+    }
+}
+
+// 一轮对话会经过连接、聆听、说话多个状态，只在第一次进入时记录
+void TurnArena::BeginTurn() {
+    int free_sram = heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
+    int largest_block = heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (in_turn_) {
+            return;
+        }
+        in_turn_ = true;
+        turn_start_free_ = free_sram;
+        turn_start_largest_ = largest_block;
+    }
+    ESP_LOGI(TAG, "Turn started: internal free %d largest block %d", free_sram, largest_block);
+}
+
+void TurnArena::EndTurn() {
+    TurnArenaStats stats;
+    uint32_t used_blocks;
+    bool in_turn;
+    int start_free;
+    int start_largest;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stats = stats_;
+        stats_ = TurnArenaStats();
+        used_blocks = blocks_.size() - free_blocks_.size();
+        stats_.peak_blocks = used_blocks;
+        in_turn = in_turn_;
+        in_turn_ = false;
+        start_free = turn_start_free_;
+        start_largest = turn_start_largest_;
+    }
+    // 启动后第一次进入空闲状态时还没有开始对话
+    if (!in_turn) {
+        return;
+    }
+
+    // 对比本轮前后内部 SRAM 的最大连续块，判断碎片是否改善
+    int free_sram = heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
+    int largest_block = heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL);
+    ESP_LOGI(TAG, "Turn ended: arena peak %lu KB, %lu allocations, %lu fallbacks, %lu blocks in use; "
+        "internal free %d -> %d largest block %d -> %d",
+        (unsigned long)(stats.peak_blocks * kBlockSize / 1024), (unsigned long)stats.allocations,
+        (unsigned long)stats.fallbacks, (unsigned long)used_blocks, start_free, free_sram, start_largest, largest_block);
+
+    auto& metrics = Metrics::GetInstance();
+    metrics.RegisterGauge("turn_arena_peak_kb")->Set(stats.peak_blocks * kBlockSize / 1024);
+    metrics.RegisterCounter("turn_arena_fallbacks")->Add(stats.fallbacks);
+    metrics.RegisterGauge("turn_start_internal_largest_block")->Set(start_largest);
+    metrics.RegisterGauge("turn_end_internal_largest_block")->Set(largest_block);
+}
@@ -0,0 +1,99 @@
+#ifndef TURN_ARENA_H
+#define TURN_ARENA_H
+
+#include <mutex>
+#include <vector>
+#include <list>
+#include <new>
+#include <cstdint>
+#include <cstddef>
+
+struct TurnArenaStats {
+    uint32_t peak_blocks = 0;      // 本轮对话同时占用的最多块数
+    uint32_t allocations = 0;
+    uint32_t fallbacks = 0;        // 区域用完或请求过大，退回 malloc 的次数
+};
+
+/*
+ * 一轮对话中的临时缓冲区（排队的 Opus 包、发送队列节点等）从 PSRAM 中的一块区域分配，
+ * 不再和长期存在的对象交错占用内部 SRAM，避免长时间运行后内部 SRAM 碎片化
+ *
+ * 区域分成固定大小的块，块内顺序分配；块内的分配全部释放后整块回收，队列这种先进先出的用法可以一直循环使用。
+ * 离开空闲状态时调用 BeginTurn 记录内部 SRAM 的空闲大小和最大连续块，进入空闲状态时调用 EndTurn
+ * 结束本轮对话，输出峰值用量以及这一轮前后的内部 SRAM 碎片情况
+ * 未启用 CONFIG_USE_TURN_ARENA 时直接使用 malloc
+ */
+class TurnArena {
+public:
+    static TurnArena& GetInstance() {
+        static TurnArena instance;
+        return instance;
+    }
+    // 删除拷贝构造函数和赋值运算符
+    TurnArena(const TurnArena&) = delete;
+    TurnArena& operator=(const TurnArena&) = delete;
+
+    void* Allocate(size_t size);
+    void Free(void* ptr);
+    void BeginTurn();
+    void EndTurn();
+
+private:
+    TurnArena() = default;
+
+    static constexpr size_t kBlockSize = 16 * 1024;
+    static constexpr size_t kAlignment = 8;
+
+    struct Block {
+        uint32_t offset = 0;
+        uint32_t live = 0;
+    };
+
+    std::mutex mutex_;
+    uint8_t* base_ = nullptr;
+    bool initialized_ = false;
+    std::vector<Block> blocks_;
+    std::vector<int> free_blocks_;
+    int current_ = -1;
+    TurnArenaStats stats_;
+    bool in_turn_ = false;
+    int turn_start_free_ = 0;       // 本轮开始时内部 SRAM 的空闲大小
+    int turn_start_largest_ = 0;    // 本轮开始时内部 SRAM 的最大连续块
+
+    bool Initialize();
+    bool NextBlock();
+};
+
+// STL 分配器适配，所有对象共用 TurnArena，可以互相交换内存
+template <typename T>
+class TurnAllocator {
+public:
+    using value_type = T;
+
+    TurnAllocator() noexcept = default;
+    template <typename U>
+    TurnAllocator(const TurnAllocator<U>&) noexcept {}
+
+    T* allocate(size_t n) {
+        void* ptr = TurnArena::GetInstance().Allocate(n * sizeof(T));
+        if (ptr == nullptr) {
+            throw std::bad_alloc();
+        }
+        return static_cast<T*>(ptr);
+    }
+    void deallocate(T* ptr, size_t) noexcept {
+        TurnArena::GetInstance().Free(ptr);
+    }
+};
+
+template <typename T, typename U>
+inline bool operator==(const TurnAllocator<T>&, const TurnAllocator<U>&) { return true; }
+template <typename T, typename U>
+inline bool operator!=(const TurnAllocator<T>&, const TurnAllocator<U>&) { return false; }
+
+template <typename T>
+using TurnVector = std::vector<T, TurnAllocator<T>>;
+template <typename T>
+using TurnList = std::list<T, TurnAllocator<T>>;
+
+#endif // TURN_ARENA_H
@@ -0,0 +1,90 @@
+# 比较音频 DSP 基准测试结果与基线，吞吐下降超过容差或低于最低实时倍数时返回非零
+import argparse
+import json
+import sys
+
+BEGIN_MARKER = 'AUDIO_BENCHMARK_BEGIN'
+END_MARKER = 'AUDIO_BENCHMARK_END'
+
+
+def load_result(path):
+    """读取 JSON 文件，或从串口日志中提取 AUDIO_BENCHMARK_BEGIN/END 之间的最后一次结果"""
+    with open(path, 'r', encoding='utf-8', errors='replace') as f:
+        text = f.read()
+    if BEGIN_MARKER in text:
+        start = text.rindex(BEGIN_MARKER) + len(BEGIN_MARKER)
+        end = text.find(END_MARKER, start)
+        if end < 0:
+            raise ValueError(f'{path}: missing {END_MARKER}')
+        text = text[start:end]
+    return json.loads(text)
+
+
+def index_results(result):
+    return {item['name']: item for item in result.get('results', [])}
+
+
+def main():
+    parser = argparse.ArgumentParser(description='音频 DSP 基准测试回归检查')
+    parser.add_argument('result', help='基准测试结果 JSON 或包含结果的串口日志')
+    parser.add_argument('--baseline', help='基线结果 JSON 或串口日志')
+    parser.add_argument('--tolerance', type=float, default=0.1,
+                        help='允许的吞吐下降比例，默认 0.1 即 10%%')
+    parser.add_argument('--thresholds', help='每个内核的最低实时倍数，格式 {"opus_encode_c3": 5.0}')
+    parser.add_argument('--update-baseline', action='store_true', help='检查后用本次结果覆盖基线文件')
+    args = parser.parse_args()
+
+    result = load_result(args.result)
+    current = index_results(result)
+    print(f"target {result.get('target')} board {result.get('board')} iterations {result.get('iterations')}")
+
+    baseline = {}
+    if args.baseline:
+        baseline_result = load_result(args.baseline)
+        if baseline_result.get('target') != result.get('target'):
+            print(f"warning: baseline target {baseline_result.get('target')} differs from {result.get('target')}")
+        baseline = index_results(baseline_result)
+
+    thresholds = {}
+    if args.thresholds:
+        with open(args.thresholds, 'r', encoding='utf-8') as f:
+            thresholds = json.load(f)
+
+    failures = []
+    print(f"{'kernel':<36}{'avg_us':>10}{'max_us':>10}{'x realtime':>12}{'baseline':>12}{'change':>9}")
+    for name, item in current.items():
+        factor = item['realtime_factor']
+        line = f"{name:<36}{item['avg_us']:>10}{item['max_us']:>10}{factor:>12}"
+        base = baseline.get(name)
+        if base is not None and base['realtime_factor'] > 0:
+            change = factor / base['realtime_factor'] - 1
+            line += f"{base['realtime_factor']:>12}{change:>+9.1%}"
+            if change < -args.tolerance:
+                failures.append(f'{name}: {factor}x realtime, baseline {base["realtime_factor"]}x ({change:+.1%})')
+        print(line)
+        minimum = thresholds.get(name)
+        if minimum is not None and factor < minimum:
+            failures.append(f'{name}: {factor}x realtime, below minimum {minimum}x')
+
+    for name in thresholds:
+        if name not in current:
+            failures.append(f'{name}: missing from result')
+    for name in baseline:
+        if name not in current:
+            print(f'warning: {name} missing from result')
+
+    if args.update_baseline and args.baseline and not failures:
+        with open(args.baseline, 'w', encoding='utf-8') as f:
+            json.dump(result, f, indent=2)
+        print(f'baseline updated: {args.baseline}')
+
+    if failures:
+        print('\nregressions:')
+        for failure in failures:
+            print(f'  {failure}')
+        sys.exit(1)
+    print('\nno regression')
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,279 @@
+# 端到端延迟基准客户端：模拟设备端协议流程，统计 唤醒->首个 TTS 音频包 的延迟分布和下行吞吐
+import argparse
+import asyncio
+import json
+import os
+import time
+
+import websockets
+
+from xiaozhi_protocol import (
+    OPUS_FRAME_DURATION_MS, UdpAudioCipher, read_p3_file, percentile,
+    MQTT_CONNACK, MQTT_PUBLISH, MQTT_PINGRESP,
+    mqtt_connect, mqtt_publish, mqtt_read_packet, mqtt_parse_publish,
+)
+
+DEFAULT_MIC = os.path.join(os.path.dirname(os.path.abspath(__file__)),
+                           '..', '..', 'main', 'assets', 'zh-CN', 'wificonfig.p3')
+
+
+class Turn:
+    def __init__(self):
+        self.channel_open_ms = None
+        self.wake_at = None
+        self.first_audio_at = None
+        self.last_audio_at = None
+        self.stop_at = None
+        self.audio_packets = 0
+        self.audio_bytes = 0
+        self.max_gap_ms = 0.0
+        self.tts_started = asyncio.Event()
+        self.tts_stopped = asyncio.Event()
+
+    def on_audio(self, opus):
+        now = time.monotonic()
+        if self.first_audio_at is None:
+            self.first_audio_at = now
+        elif self.audio_packets > 0:
+            self.max_gap_ms = max(self.max_gap_ms, (now - self.last_audio_at) * 1000)
+        self.last_audio_at = now
+        self.audio_packets += 1
+        self.audio_bytes += len(opus)
+
+    def on_json(self, message):
+        if message.get('type') == 'tts':
+            if message.get('state') == 'start':
+                self.tts_started.set()
+            elif message.get('state') == 'stop':
+                self.stop_at = time.monotonic()
+                self.tts_stopped.set()
+
+
+class WebsocketChannel:
+    def __init__(self, args):
+        self.args = args
+        self.websocket = None
+        self.session_id = ''
+        self.turn = None
+        self.opened = False
+
+    async def open(self, turn):
+        self.turn = turn
+        headers = {
+            'Authorization': f'Bearer {self.args.token}',
+            'Protocol-Version': '1',
+            'Device-Id': self.args.device_id,
+            'Client-Id': self.args.client_id,
+        }
+        try:
+            self.websocket = await websockets.connect(self.args.url, additional_headers=headers, max_size=None)
+        except TypeError:
+            self.websocket = await websockets.connect(self.args.url, extra_headers=headers, max_size=None)
+        await self.websocket.send(json.dumps({
+            'type': 'hello', 'version': 1, 'transport': 'websocket',
+            'audio_params': {'format': 'opus', 'sample_rate': 16000, 'channels': 1,
+                             'frame_duration': OPUS_FRAME_DURATION_MS},
+        }))
+        hello = json.loads(await self.websocket.recv())
+        self.session_id = hello.get('session_id', '')
+        self.reader = asyncio.ensure_future(self.read_loop())
+        self.opened = True
+
+    async def read_loop(self):
+        try:
+            async for data in self.websocket:
+                if isinstance(data, bytes):
+                    self.turn.on_audio(data)
+                else:
+                    self.turn.on_json(json.loads(data))
+        except websockets.ConnectionClosed:
+            pass
+
+    async def send_json(self, message):
+        message['session_id'] = self.session_id
+        await self.websocket.send(json.dumps(message, ensure_ascii=False))
+
+    async def send_audio(self, opus):
+        await self.websocket.send(opus)
+
+    async def close(self):
+        await self.websocket.close()
+        self.reader.cancel()
+        self.opened = False
+
+
+class MqttUdpChannel:
+    def __init__(self, args):
+        self.args = args
+        self.session_id = ''
+        self.turn = None
+        self.reader = None
+        self.writer = None
+        self.udp_transport = None
+        self.cipher = None
+        self.hello = None
+        self.opened = False
+
+    async def open(self, turn):
+        self.turn = turn
+        if self.writer is None:
+            self.reader, self.writer = await asyncio.open_connection(self.args.mqtt_host, self.args.mqtt_port)
+            self.writer.write(mqtt_connect(self.args.client_id, 'bench', 'bench'))
+            await self.writer.drain()
+            packet_type, _, _ = await mqtt_read_packet(self.reader)
+            if packet_type != MQTT_CONNACK:
+                raise RuntimeError('MQTT connect failed')
+            self.mqtt_task = asyncio.ensure_future(self.mqtt_loop())
+
+        self.hello = asyncio.get_running_loop().create_future()
+        await self.publish({
+            'type': 'hello', 'version': 3, 'transport': 'udp',
+            'audio_params': {'format': 'opus', 'sample_rate': 16000, 'channels': 1,
+                             'frame_duration': OPUS_FRAME_DURATION_MS},
+        })
+        hello = await asyncio.wait_for(self.hello, 10)
+        self.session_id = hello.get('session_id', '')
+        udp = hello['udp']
+        self.cipher = UdpAudioCipher(bytes.fromhex(udp['key']), bytes.fromhex(udp['nonce']))
+        channel = self
+
+        class UdpProtocol(asyncio.DatagramProtocol):
+            def datagram_received(self, data, addr):
+                result = channel.cipher.decrypt(data)
+                if result is not None:
+                    channel.turn.on_audio(result[1])
+
+        self.udp_transport, _ = await asyncio.get_running_loop().create_datagram_endpoint(
+            UdpProtocol, remote_addr=(udp['server'], udp['port']))
+        self.opened = True
+
+    async def mqtt_loop(self):
+        try:
+            while True:
+                packet_type, flags, body = await mqtt_read_packet(self.reader)
+                if packet_type == MQTT_PUBLISH:
+                    _, _, payload = mqtt_parse_publish(flags, body)
+                    message = json.loads(payload)
+                    if message.get('type') == 'hello' and not self.hello.done():
+                        self.hello.set_result(message)
+                    elif self.turn is not None:
+                        self.turn.on_json(message)
+                elif packet_type == MQTT_PINGRESP:
+                    pass
+        except (asyncio.IncompleteReadError, ConnectionError):
+            pass
+
+    async def publish(self, message):
+        self.writer.write(mqtt_publish(self.args.publish_topic, json.dumps(message, ensure_ascii=False)))
+        await self.writer.drain()
+
+    async def send_json(self, message):
+        message['session_id'] = self.session_id
+        await self.publish(message)
+
+    async def send_audio(self, opus):
+        self.udp_transport.sendto(self.cipher.encrypt(opus))
+
+    async def close(self):
+        await self.send_json({'type': 'goodbye'})
+        self.udp_transport.close()
+        self.opened = False
+
+
+async def stream_audio(channel, packets, realtime, until=None):
+    frame_seconds = OPUS_FRAME_DURATION_MS / 1000
+    start = time.monotonic()
+    for i, opus in enumerate(packets):
+        if until is not None and until.is_set():
+            return
+        await channel.send_audio(opus)
+        if realtime:
+            await asyncio.sleep(max(0, start + (i + 1) * frame_seconds - time.monotonic()))
+
+
+async def run_turn(channel, args, mic_packets):
+    turn = Turn()
+    if channel.opened:
+        channel.turn = turn
+        turn.channel_open_ms = 0.0
+    else:
+        start = time.monotonic()
+        await channel.open(turn)
+        turn.channel_open_ms = (time.monotonic() - start) * 1000
+
+    if args.flow == 'wake':
+        # 与固件唤醒流程一致：先突发发送唤醒词音频，再发送 detect
+        await stream_audio(channel, mic_packets[:args.wake_frames], realtime=False)
+        turn.wake_at = time.monotonic()
+        await channel.send_json({'type': 'listen', 'state': 'detect', 'text': args.wake_word})
+    else:
+        turn.wake_at = time.monotonic()
+        await channel.send_json({'type': 'listen', 'state': 'start', 'mode': 'auto'})
+        asyncio.ensure_future(stream_audio(channel, mic_packets, realtime=True, until=turn.tts_started))
+
+    await asyncio.wait_for(turn.tts_stopped.wait(), args.timeout)
+    if args.close_channel:
+        await channel.close()
+    return turn
+
+
+async def run(args):
+    mic_packets = read_p3_file(args.mic)
+    channel = WebsocketChannel(args) if args.transport == 'websocket' else MqttUdpChannel(args)
+    turns = []
+    for i in range(args.iterations):
+        turn = await run_turn(channel, args, mic_packets)
+        turns.append(turn)
+        latency = (turn.first_audio_at - turn.wake_at) * 1000 if turn.first_audio_at else float('nan')
+        print(f"turn {i + 1}: open {turn.channel_open_ms:.0f} ms, wake->first tts {latency:.0f} ms, "
+              f"{turn.audio_packets} packets, max gap {turn.max_gap_ms:.0f} ms")
+        await asyncio.sleep(args.interval_ms / 1000)
+
+    latencies = [(t.first_audio_at - t.wake_at) * 1000 for t in turns if t.first_audio_at]
+    opens = [t.channel_open_ms for t in turns]
+    total_bytes = sum(t.audio_bytes for t in turns)
+    total_seconds = sum(t.stop_at - t.first_audio_at for t in turns if t.first_audio_at and t.stop_at)
+    result = {
+        'transport': args.transport,
+        'flow': args.flow,
+        'iterations': len(turns),
+        'wake_to_first_audio_ms': {p: round(percentile(latencies, p), 1) for p in (50, 90, 99)},
+        'channel_open_ms': {p: round(percentile(opens, p), 1) for p in (50, 90, 99)},
+        'max_gap_ms': round(max((t.max_gap_ms for t in turns), default=0), 1),
+        'downstream_kbps': round(total_bytes * 8 / total_seconds / 1000, 1) if total_seconds > 0 else 0,
+        'downstream_packets_per_second': round(sum(t.audio_packets for t in turns) / total_seconds, 1)
+        if total_seconds > 0 else 0,
+    }
+    print(json.dumps(result, indent=2))
+    if args.output:
+        with open(args.output, 'w') as f:
+            json.dump(result, f, indent=2)
+
+
+def main():
+    parser = argparse.ArgumentParser(description='小智端到端延迟基准客户端')
+    parser.add_argument('--transport', choices=['websocket', 'mqtt'], default='websocket')
+    parser.add_argument('--url', default='ws://127.0.0.1:8000/', help='Websocket 地址')
+    parser.add_argument('--token', default='test-token')
+    parser.add_argument('--mqtt-host', default='127.0.0.1')
+    parser.add_argument('--mqtt-port', type=int, default=8883)
+    parser.add_argument('--publish-topic', default='device-server')
+    parser.add_argument('--device-id', default='00:00:00:00:be:9c')
+    parser.add_argument('--client-id', default='bench-client')
+    parser.add_argument('--flow', choices=['wake', 'listen'], default='wake',
+                        help='wake: 唤醒词流程；listen: 按键后自动停止的聆听流程')
+    parser.add_argument('--wake-word', default='你好小智')
+    parser.add_argument('--wake-frames', type=int, default=30, help='唤醒前突发发送的音频帧数')
+    parser.add_argument('--mic', default=DEFAULT_MIC, help='作为麦克风输入的 p3 文件')
+    parser.add_argument('--iterations', type=int, default=20)
+    parser.add_argument('--interval-ms', type=int, default=200)
+    parser.add_argument('--timeout', type=float, default=30)
+    parser.add_argument('--keep-channel', dest='close_channel', action='store_false',
+                        help='每轮之后不关闭音频通道')
+    parser.add_argument('--output', help='将统计结果写入 JSON 文件')
+    args = parser.parse_args()
+    asyncio.run(run(args))
+
+
+if __name__ == '__main__':
+    main()
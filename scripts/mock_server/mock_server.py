@@ -0,0 +1,413 @@
+# 本地模拟服务器：实现 hello/listen/tts/stt/llm/iot JSON 协议，支持 Websocket 与 MQTT+UDP 两种传输
+import argparse
+import asyncio
+import json
+import os
+import ssl
+import struct
+import sys
+import time
+import uuid
+
+import websockets
+
+from xiaozhi_protocol import (
+    OPUS_FRAME_DURATION_MS, Impairment, UdpAudioCipher, read_p3_file, percentile,
+    MQTT_CONNECT, MQTT_CONNACK, MQTT_PUBLISH, MQTT_PUBACK, MQTT_SUBSCRIBE, MQTT_SUBACK,
+    MQTT_PINGREQ, MQTT_PINGRESP, MQTT_DISCONNECT,
+    mqtt_packet, mqtt_publish, mqtt_read_packet, mqtt_parse_connect, mqtt_parse_publish,
+)
+
+DEFAULT_TTS = os.path.join(os.path.dirname(os.path.abspath(__file__)),
+                           '..', '..', 'main', 'assets', 'zh-CN', 'welcome.p3')
+
+
+def log(session, message):
+    print(f"[{time.strftime('%H:%M:%S')}] [{session}] {message}", flush=True)
+
+
+class Session:
+    """一次对话会话，与传输方式无关，负责协议状态机和 TTS 回放"""
+
+    def __init__(self, server, name, transport):
+        self.server = server
+        self.args = server.args
+        self.name = name
+        self.transport = transport
+        self.session_id = str(uuid.uuid4())
+        self.impairment = Impairment(self.args.delay_ms, self.args.jitter_ms, self.args.loss,
+                                     self.args.reorder, self.args.seed)
+        self.send_json_raw = None
+        self.send_audio_raw = None
+        self.listening = False
+        self.listen_mode = None
+        self.listen_started_at = None
+        self.wake_at = None
+        self.first_audio_at = None
+        self.upstream_packets = 0
+        self.upstream_bytes = 0
+        self.upstream_first_at = None
+        self.upstream_last_at = None
+        self.respond_task = None
+        self.auto_stop_task = None
+
+    async def send_json(self, message):
+        message.setdefault('session_id', self.session_id)
+        await self.send_json_raw(json.dumps(message, ensure_ascii=False))
+
+    async def send_audio(self, opus):
+        await self.impairment.send(self.send_audio_raw, opus)
+
+    def hello_reply(self):
+        return {
+            'type': 'hello',
+            'transport': self.transport,
+            'session_id': self.session_id,
+            'audio_params': {
+                'format': 'opus',
+                'sample_rate': self.args.sample_rate,
+                'channels': 1,
+                'frame_duration': OPUS_FRAME_DURATION_MS,
+            },
+        }
+
+    async def on_json(self, message):
+        msg_type = message.get('type')
+        if msg_type == 'listen':
+            state = message.get('state')
+            log(self.name, f"listen {state} {message.get('mode', message.get('text', ''))}")
+            if state == 'detect':
+                self.wake_at = time.monotonic()
+                self.start_response()
+            elif state == 'start':
+                self.listening = True
+                self.listen_mode = message.get('mode')
+                self.listen_started_at = time.monotonic()
+                if self.wake_at is None:
+                    self.wake_at = self.listen_started_at
+                if self.listen_mode == 'auto':
+                    self.auto_stop_task = asyncio.ensure_future(self.auto_stop())
+            elif state == 'stop':
+                self.listening = False
+                self.start_response()
+        elif msg_type == 'abort':
+            log(self.name, f"abort {message.get('reason', '')}")
+            if self.respond_task is not None and not self.respond_task.done():
+                self.respond_task.cancel()
+                await self.send_json({'type': 'tts', 'state': 'stop'})
+        elif msg_type == 'iot':
+            if 'descriptors' in message:
+                for descriptor in message['descriptors']:
+                    log(self.name, f"iot descriptor {descriptor.get('name')}")
+            if 'states' in message:
+                log(self.name, f"iot states {json.dumps(message['states'], ensure_ascii=False)}")
+        else:
+            log(self.name, f"unhandled message {message}")
+
+    def on_audio(self, opus):
+        now = time.monotonic()
+        if self.upstream_first_at is None:
+            self.upstream_first_at = now
+        self.upstream_last_at = now
+        self.upstream_packets += 1
+        self.upstream_bytes += len(opus)
+
+    async def auto_stop(self):
+        # 模拟服务端 VAD：收到一段时间的上行音频后结束本轮聆听
+        await asyncio.sleep(self.args.listen_ms / 1000)
+        if self.listening:
+            self.listening = False
+            self.start_response()
+
+    def start_response(self):
+        if self.respond_task is not None and not self.respond_task.done():
+            return
+        self.respond_task = asyncio.ensure_future(self.respond())
+
+    async def respond(self):
+        args = self.args
+        await asyncio.sleep(args.response_delay_ms / 1000)
+        await self.send_json({'type': 'stt', 'text': args.stt_text})
+        await self.send_json({'type': 'llm', 'text': '', 'emotion': args.emotion})
+        await self.send_json({'type': 'tts', 'state': 'start', 'sample_rate': args.sample_rate})
+        await self.send_json({'type': 'tts', 'state': 'sentence_start', 'text': args.tts_text})
+
+        # 按帧时长节奏发送，预先发送 prebuffer 帧以模拟服务端的突发
+        start = time.monotonic()
+        frame_seconds = OPUS_FRAME_DURATION_MS / 1000
+        for i, opus in enumerate(self.server.tts_packets):
+            if self.first_audio_at is None:
+                self.first_audio_at = time.monotonic()
+                if self.wake_at is not None:
+                    self.server.wake_to_first_audio.append((self.first_audio_at - self.wake_at) * 1000)
+            await self.send_audio(opus)
+            if args.pace > 0 and i >= args.prebuffer:
+                target = start + (i + 1 - args.prebuffer) * frame_seconds / args.pace
+                await asyncio.sleep(max(0, target - time.monotonic()))
+
+        await self.impairment.flush()
+        await self.send_json({'type': 'tts', 'state': 'sentence_end', 'text': args.tts_text})
+        await self.send_json({'type': 'tts', 'state': 'stop'})
+        self.report()
+        self.wake_at = None
+        self.first_audio_at = None
+
+    def report(self):
+        upstream = ''
+        if self.upstream_first_at is not None:
+            duration = self.upstream_last_at - self.upstream_first_at
+            upstream = (f", upstream {self.upstream_packets} packets {self.upstream_bytes} bytes "
+                        f"in {duration * 1000:.0f} ms")
+        latency = ''
+        if self.first_audio_at is not None and self.wake_at is not None:
+            latency = f", wake->first tts {(self.first_audio_at - self.wake_at) * 1000:.0f} ms"
+        impairment = ''
+        if self.impairment.enabled:
+            impairment = (f", impaired sent {self.impairment.sent} dropped {self.impairment.dropped} "
+                          f"reordered {self.impairment.reordered}")
+        log(self.name, f"turn done{latency}{upstream}{impairment}")
+
+    def close(self):
+        for task in (self.respond_task, self.auto_stop_task):
+            if task is not None and not task.done():
+                task.cancel()
+
+
+class MockServer:
+    def __init__(self, args):
+        self.args = args
+        self.tts_packets = read_p3_file(args.tts)
+        self.wake_to_first_audio = []
+        self.udp_sessions = {}
+        self.udp_transport = None
+        log('server', f"loaded {len(self.tts_packets)} tts packets from {args.tts}")
+
+    # ------------------------------------------------------------------ websocket
+    async def websocket_handler(self, websocket, path=None):
+        request = getattr(websocket, 'request', None)
+        headers = request.headers if request is not None else websocket.request_headers
+        name = f"ws {headers.get('Device-Id', websocket.remote_address[0])}"
+        session = Session(self, name, 'websocket')
+        session.send_json_raw = websocket.send
+        session.send_audio_raw = websocket.send
+        log(name, f"connected, protocol version {headers.get('Protocol-Version')}")
+        try:
+            async for data in websocket:
+                if isinstance(data, bytes):
+                    session.on_audio(data)
+                    continue
+                message = json.loads(data)
+                if message.get('type') == 'hello':
+                    await websocket.send(json.dumps(session.hello_reply()))
+                else:
+                    await session.on_json(message)
+        except websockets.ConnectionClosed:
+            pass
+        finally:
+            session.close()
+            log(name, "disconnected")
+
+    # ------------------------------------------------------------------ mqtt
+    async def mqtt_handler(self, reader, writer):
+        peer = writer.get_extra_info('peername')
+        name = f"mqtt {peer[0]}"
+        session = None
+        client_id = None
+        topic = None
+
+        async def publish(text):
+            writer.write(mqtt_publish(topic, text))
+            await writer.drain()
+
+        try:
+            while True:
+                packet_type, flags, body = await mqtt_read_packet(reader)
+                if packet_type == MQTT_CONNECT:
+                    client_id, username, _ = mqtt_parse_connect(body)
+                    topic = f"devices/p2p/{client_id}"
+                    name = f"mqtt {client_id}"
+                    writer.write(mqtt_packet(MQTT_CONNACK, 0, b'\x00\x00'))
+                    log(name, f"connected, username {username}")
+                elif packet_type == MQTT_PUBLISH:
+                    _, packet_id, payload = mqtt_parse_publish(flags, body)
+                    if packet_id is not None:
+                        writer.write(mqtt_packet(MQTT_PUBACK, 0, struct.pack('>H', packet_id)))
+                    message = json.loads(payload)
+                    msg_type = message.get('type')
+                    if msg_type == 'hello':
+                        if session is not None:
+                            self.close_udp_session(session)
+                        session = Session(self, name, 'udp')
+                        session.send_json_raw = publish
+                        self.open_udp_session(session)
+                        await publish(json.dumps(session.hello_reply()))
+                    elif msg_type == 'goodbye':
+                        if session is not None:
+                            self.close_udp_session(session)
+                            session = None
+                        log(name, "goodbye")
+                    elif session is not None:
+                        await session.on_json(message)
+                elif packet_type == MQTT_SUBSCRIBE:
+                    packet_id = body[:2]
+                    writer.write(mqtt_packet(MQTT_SUBACK, 0, packet_id + b'\x00'))
+                elif packet_type == MQTT_PINGREQ:
+                    writer.write(mqtt_packet(MQTT_PINGRESP, 0, b''))
+                elif packet_type == MQTT_DISCONNECT:
+                    break
+                await writer.drain()
+        except (asyncio.IncompleteReadError, ConnectionError):
+            pass
+        finally:
+            if session is not None:
+                self.close_udp_session(session)
+            writer.close()
+            log(name, "disconnected")
+
+    def open_udp_session(self, session):
+        cipher = UdpAudioCipher()
+        session.cipher = cipher
+        session.udp_addr = None
+        session.send_audio_raw = lambda opus: self.send_udp(session, opus)
+        self.udp_sessions[bytes(cipher.nonce[4:12])] = session
+        reply = session.hello_reply
+        session.hello_reply = lambda: dict(reply(), udp={
+            'server': self.args.public_host,
+            'port': self.args.udp_port,
+            'encryption': 'aes-128-ctr',
+            'key': cipher.key.hex(),
+            'nonce': bytes(cipher.nonce).hex(),
+        })
+
+    def close_udp_session(self, session):
+        session.close()
+        self.udp_sessions.pop(bytes(session.cipher.nonce[4:12]), None)
+
+    def send_udp(self, session, opus):
+        if session.udp_addr is None or self.udp_transport is None:
+            return
+        self.udp_transport.sendto(session.cipher.encrypt(opus), session.udp_addr)
+
+    def on_udp_packet(self, data, addr):
+        session = self.udp_sessions.get(bytes(data[4:12])) if len(data) >= 16 else None
+        if session is None:
+            return
+        session.udp_addr = addr
+        result = session.cipher.decrypt(data)
+        if result is None:
+            return
+        sequence, opus = result
+        expected = getattr(session, 'remote_sequence', 0) + 1
+        if sequence != expected:
+            log(session.name, f"udp sequence {sequence}, expected {expected}")
+        session.remote_sequence = sequence
+        session.on_audio(opus)
+
+    # ------------------------------------------------------------------ ota
+    async def ota_handler(self, reader, writer):
+        try:
+            request_line = await reader.readline()
+            headers = {}
+            while True:
+                line = await reader.readline()
+                if line in (b'\r\n', b'\n', b''):
+                    break
+                key, _, value = line.decode().partition(':')
+                headers[key.strip().lower()] = value.strip()
+            body = await reader.readexactly(int(headers.get('content-length', 0)))
+            version = '0.0.0'
+            if body:
+                version = json.loads(body).get('application', {}).get('version', version)
+            device_id = headers.get('device-id', 'mock-device')
+            response = json.dumps({
+                'firmware': {'version': version, 'url': ''},
+                'mqtt': {
+                    'endpoint': self.args.public_host,
+                    'client_id': device_id,
+                    'username': 'mock',
+                    'password': 'mock',
+                    'publish_topic': 'device-server',
+                },
+                'server_time': {'timestamp': int(time.time() * 1000), 'timezone_offset': 0},
+            }).encode()
+            log('ota', f"{request_line.decode().strip()} from {device_id}, version {version}")
+            writer.write(b'HTTP/1.1 200 OK\r\nContent-Type: application/json\r\n'
+                         + f'Content-Length: {len(response)}\r\nConnection: close\r\n\r\n'.encode()
+                         + response)
+            await writer.drain()
+        finally:
+            writer.close()
+
+    async def run(self):
+        args = self.args
+        ssl_context = None
+        if args.tls_cert:
+            ssl_context = ssl.create_default_context(ssl.Purpose.CLIENT_AUTH)
+            ssl_context.load_cert_chain(args.tls_cert, args.tls_key)
+
+        server = self
+
+        class UdpProtocol(asyncio.DatagramProtocol):
+            def connection_made(self, transport):
+                server.udp_transport = transport
+
+            def datagram_received(self, data, addr):
+                server.on_udp_packet(data, addr)
+
+        loop = asyncio.get_running_loop()
+        await loop.create_datagram_endpoint(UdpProtocol, local_addr=(args.host, args.udp_port))
+        await asyncio.start_server(self.mqtt_handler, args.host, args.mqtt_port, ssl=ssl_context)
+        await asyncio.start_server(self.ota_handler, args.host, args.ota_port)
+        log('server', f"websocket ws://{args.host}:{args.ws_port}/, mqtt {args.host}:{args.mqtt_port}"
+                      f"{' (tls)' if ssl_context else ''}, udp {args.udp_port}, ota http://{args.host}:{args.ota_port}/")
+        async with websockets.serve(self.websocket_handler, args.host, args.ws_port, max_size=None):
+            await asyncio.Future()
+
+    def summary(self):
+        values = self.wake_to_first_audio
+        if not values:
+            return
+        print(f"wake->first tts audio over {len(values)} turns: "
+              f"p50 {percentile(values, 50):.0f} ms, p90 {percentile(values, 90):.0f} ms, "
+              f"p99 {percentile(values, 99):.0f} ms")
+
+
+def main():
+    parser = argparse.ArgumentParser(description='小智本地模拟服务器')
+    parser.add_argument('--host', default='0.0.0.0', help='监听地址')
+    parser.add_argument('--public-host', default='127.0.0.1', help='下发给设备的 MQTT/UDP 地址')
+    parser.add_argument('--ws-port', type=int, default=8000)
+    parser.add_argument('--mqtt-port', type=int, default=8883, help='设备固定连接 8883 端口')
+    parser.add_argument('--udp-port', type=int, default=8884)
+    parser.add_argument('--ota-port', type=int, default=8002)
+    parser.add_argument('--tls-cert', help='MQTT TLS 证书，设备使用 8883 端口时需要')
+    parser.add_argument('--tls-key', help='MQTT TLS 私钥')
+    parser.add_argument('--tts', default=DEFAULT_TTS, help='回放的 TTS p3 文件')
+    parser.add_argument('--sample-rate', type=int, default=16000, help='p3 文件的采样率')
+    parser.add_argument('--stt-text', default='你好小智')
+    parser.add_argument('--tts-text', default='你好，我是小智。')
+    parser.add_argument('--emotion', default='happy')
+    parser.add_argument('--listen-ms', type=int, default=1500, help='auto 模式下收音多久后回复')
+    parser.add_argument('--response-delay-ms', type=int, default=0, help='模拟服务端处理耗时')
+    parser.add_argument('--pace', type=float, default=1.0, help='TTS 发送速度倍率，0 表示不限速')
+    parser.add_argument('--prebuffer', type=int, default=3, help='TTS 开始时突发发送的帧数')
+    parser.add_argument('--delay-ms', type=float, default=0, help='下行音频固定延迟')
+    parser.add_argument('--jitter-ms', type=float, default=0, help='下行音频随机抖动')
+    parser.add_argument('--loss', type=float, default=0.0, help='下行音频丢包率 0~1')
+    parser.add_argument('--reorder', type=float, default=0.0, help='下行音频乱序率 0~1')
+    parser.add_argument('--seed', type=int, help='损伤模拟的随机种子')
+    args = parser.parse_args()
+
+    if args.tls_cert and not args.tls_key:
+        parser.error('--tls-cert 需要同时指定 --tls-key')
+
+    server = MockServer(args)
+    try:
+        asyncio.run(server.run())
+    except KeyboardInterrupt:
+        server.summary()
+        sys.exit(0)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,238 @@
+# 小智通信协议的公共实现：P3 文件读取、UDP 音频包加解密、网络损伤模拟、最小 MQTT 编解码
+import asyncio
+import os
+import random
+import struct
+
+from cryptography.hazmat.primitives.ciphers import Cipher, algorithms, modes
+
+OPUS_FRAME_DURATION_MS = 60
+
+
+def read_p3_file(path):
+    """
+    读取 p3 文件，返回 Opus 数据包列表
+    p3格式: [1字节类型, 1字节保留, 2字节长度, Opus数据]
+    """
+    packets = []
+    with open(path, 'rb') as f:
+        while True:
+            header = f.read(4)
+            if len(header) < 4:
+                break
+            _, _, data_len = struct.unpack('>BBH', header)
+            opus_data = f.read(data_len)
+            if len(opus_data) < data_len:
+                break
+            packets.append(opus_data)
+    return packets
+
+
+class UdpAudioCipher:
+    """
+    与 MqttProtocol 相同的 AES-128-CTR 音频包格式
+    nonce: [1字节类型=0x01, 1字节保留, 2字节长度, 8字节会话数据, 4字节序号]
+    """
+
+    def __init__(self, key=None, nonce=None):
+        self.key = key or os.urandom(16)
+        self.nonce = bytearray(nonce or (b'\x01' + b'\x00' * 3 + os.urandom(8) + b'\x00' * 4))
+        self.nonce[0] = 0x01
+        self.local_sequence = 0
+
+    def encrypt(self, payload):
+        self.local_sequence += 1
+        nonce = bytearray(self.nonce)
+        struct.pack_into('>H', nonce, 2, len(payload))
+        struct.pack_into('>I', nonce, 12, self.local_sequence)
+        encryptor = Cipher(algorithms.AES(self.key), modes.CTR(bytes(nonce))).encryptor()
+        return bytes(nonce) + encryptor.update(payload) + encryptor.finalize()
+
+    def decrypt(self, packet):
+        """返回 (序号, 明文)，无效包返回 None"""
+        if len(packet) < 16 or packet[0] != 0x01:
+            return None
+        nonce = packet[:16]
+        sequence = struct.unpack_from('>I', nonce, 12)[0]
+        decryptor = Cipher(algorithms.AES(self.key), modes.CTR(nonce)).decryptor()
+        return sequence, decryptor.update(packet[16:]) + decryptor.finalize()
+
+
+class Impairment:
+    """
+    在发送方向上模拟网络损伤：固定延迟 + 抖动、随机丢包、随机乱序
+    send 为实际发送函数（可以是协程函数），所有包按计划时间在后台任务中发出
+    """
+
+    def __init__(self, delay_ms=0, jitter_ms=0, loss=0.0, reorder=0.0, seed=None):
+        self.delay_ms = delay_ms
+        self.jitter_ms = jitter_ms
+        self.loss = loss
+        self.reorder = reorder
+        self.random = random.Random(seed)
+        self.sent = 0
+        self.dropped = 0
+        self.reordered = 0
+        self.pending = set()
+
+    @property
+    def enabled(self):
+        return self.delay_ms > 0 or self.jitter_ms > 0 or self.loss > 0 or self.reorder > 0
+
+    async def send(self, send, data):
+        if self.loss > 0 and self.random.random() < self.loss:
+            self.dropped += 1
+            return
+        delay = self.delay_ms
+        if self.jitter_ms > 0:
+            delay += self.random.uniform(0, self.jitter_ms)
+        if self.reorder > 0 and self.random.random() < self.reorder:
+            # 推迟一到两帧发送，使其落在后续包之后
+            delay += OPUS_FRAME_DURATION_MS * self.random.uniform(1.0, 2.0)
+            self.reordered += 1
+        self.sent += 1
+        if delay <= 0:
+            await _call(send, data)
+            return
+
+        async def delayed():
+            await asyncio.sleep(delay / 1000)
+            try:
+                await _call(send, data)
+            except Exception:
+                # 连接已关闭，延迟包直接丢弃
+                pass
+        task = asyncio.ensure_future(delayed())
+        self.pending.add(task)
+        task.add_done_callback(self.pending.discard)
+
+    async def flush(self):
+        """等待所有延迟中的包发出"""
+        if self.pending:
+            await asyncio.gather(*self.pending, return_exceptions=True)
+
+
+async def _call(send, data):
+    result = send(data)
+    if asyncio.iscoroutine(result):
+        await result
+
+
+def percentile(values, p):
+    if not values:
+        return 0.0
+    values = sorted(values)
+    k = (len(values) - 1) * p / 100
+    f = int(k)
+    c = min(f + 1, len(values) - 1)
+    return values[f] + (values[c] - values[f]) * (k - f)
+
+
+# ---------------------------------------------------------------------------
+# 最小 MQTT 3.1.1 实现，只覆盖设备端 MqttProtocol 用到的报文
+# ---------------------------------------------------------------------------
+
+MQTT_CONNECT = 1
+MQTT_CONNACK = 2
+MQTT_PUBLISH = 3
+MQTT_PUBACK = 4
+MQTT_SUBSCRIBE = 8
+MQTT_SUBACK = 9
+MQTT_PINGREQ = 12
+MQTT_PINGRESP = 13
+MQTT_DISCONNECT = 14
+
+
+def mqtt_encode_length(length):
+    out = bytearray()
+    while True:
+        byte = length % 128
+        length //= 128
+        if length > 0:
+            byte |= 0x80
+        out.append(byte)
+        if length == 0:
+            return bytes(out)
+
+
+def mqtt_encode_string(s):
+    if isinstance(s, str):
+        s = s.encode()
+    return struct.pack('>H', len(s)) + s
+
+
+def mqtt_packet(packet_type, flags, body):
+    return bytes([(packet_type << 4) | flags]) + mqtt_encode_length(len(body)) + body
+
+
+def mqtt_publish(topic, payload, qos=0, packet_id=1):
+    if isinstance(payload, str):
+        payload = payload.encode()
+    body = mqtt_encode_string(topic)
+    if qos > 0:
+        body += struct.pack('>H', packet_id)
+    return mqtt_packet(MQTT_PUBLISH, qos << 1, body + payload)
+
+
+def mqtt_connect(client_id, username='', password='', keepalive=90):
+    flags = 0x02
+    payload = mqtt_encode_string(client_id)
+    if username:
+        flags |= 0x80
+        payload += mqtt_encode_string(username)
+    if password:
+        flags |= 0x40
+        payload += mqtt_encode_string(password)
+    body = mqtt_encode_string('MQTT') + bytes([4, flags]) + struct.pack('>H', keepalive)
+    return mqtt_packet(MQTT_CONNECT, 0, body + payload)
+
+
+def mqtt_subscribe(topic, packet_id=1):
+    body = struct.pack('>H', packet_id) + mqtt_encode_string(topic) + b'\x00'
+    return mqtt_packet(MQTT_SUBSCRIBE, 0x02, body)
+
+
+async def mqtt_read_packet(reader):
+    """返回 (类型, 标志, 报文体)，连接关闭时抛出 asyncio.IncompleteReadError"""
+    first = (await reader.readexactly(1))[0]
+    multiplier = 1
+    length = 0
+    while True:
+        byte = (await reader.readexactly(1))[0]
+        length += (byte & 0x7F) * multiplier
+        if byte & 0x80 == 0:
+            break
+        multiplier *= 128
+    body = await reader.readexactly(length) if length > 0 else b''
+    return first >> 4, first & 0x0F, body
+
+
+def mqtt_parse_string(body, offset):
+    length = struct.unpack_from('>H', body, offset)[0]
+    return body[offset + 2:offset + 2 + length], offset + 2 + length
+
+
+def mqtt_parse_connect(body):
+    _, offset = mqtt_parse_string(body, 0)
+    flags = body[offset + 1]
+    offset += 4
+    client_id, offset = mqtt_parse_string(body, offset)
+    if flags & 0x04:
+        _, offset = mqtt_parse_string(body, offset)
+        _, offset = mqtt_parse_string(body, offset)
+    username = password = b''
+    if flags & 0x80:
+        username, offset = mqtt_parse_string(body, offset)
+    if flags & 0x40:
+        password, offset = mqtt_parse_string(body, offset)
+    return client_id.decode(), username.decode(), password.decode()
+
+
+def mqtt_parse_publish(flags, body):
+    """返回 (topic, packet_id, payload)"""
+    topic, offset = mqtt_parse_string(body, 0)
+    packet_id = None
+    if (flags >> 1) & 0x03:
+        packet_id = struct.unpack_from('>H', body, offset)[0]
+        offset += 2
+    return topic.decode(), packet_id, body[offset:]
@@ -0,0 +1,205 @@
+# 会话日志工具：从串口日志提取 session dump、查看日志内容、比较两次回放的状态时间线和 CPU 时间
+import argparse
+import base64
+import json
+import struct
+import sys
+
+SESSION_LOG_MAGIC = 0x52535a58
+HEADER_FORMAT = '<IBBHII'
+RECORD_FORMAT = '<BBHI'
+
+EVENT_NAMES = {
+    1: 'mic', 2: 'json', 3: 'audio', 4: 'opened', 5: 'closed', 6: 'state', 7: 'command',
+}
+STATE_NAMES = [
+    'unknown', 'starting', 'configuring', 'idle', 'connecting', 'listening',
+    'speaking', 'upgrading', 'activating', 'fatal_error',
+]
+
+
+class SessionLog:
+    def __init__(self, data):
+        header_size = struct.calcsize(HEADER_FORMAT)
+        magic, version, self.input_channels, _, self.input_sample_rate, self.output_sample_rate = \
+            struct.unpack_from(HEADER_FORMAT, data, 0)
+        if magic != SESSION_LOG_MAGIC:
+            raise ValueError('not a session log')
+        if version != 1:
+            raise ValueError(f'unsupported session log version {version}')
+        self.events = []
+        offset = header_size
+        time_us = 0
+        record_size = struct.calcsize(RECORD_FORMAT)
+        while offset + record_size <= len(data):
+            event_type, _, payload_size, delta_us = struct.unpack_from(RECORD_FORMAT, data, offset)
+            offset += record_size
+            payload = data[offset:offset + payload_size]
+            offset += payload_size
+            time_us += delta_us
+            self.events.append((event_type, time_us, payload))
+
+    @classmethod
+    def load(cls, path):
+        with open(path, 'rb') as f:
+            return cls(f.read())
+
+    @property
+    def duration_ms(self):
+        return self.events[-1][1] / 1000 if self.events else 0
+
+    def timeline(self):
+        """
+        返回状态变化列表 [(状态名, 时间ms, 触发事件, 延迟ms)]
+        延迟为状态变化距最近一次触发事件（用户操作、下行 JSON、通道打开/关闭）的时间，
+        代表固件处理这一事件所用的时间
+        """
+        result = []
+        trigger = None
+        for event_type, time_us, payload in self.events:
+            name = EVENT_NAMES.get(event_type)
+            if name == 'command':
+                trigger = (payload.decode(errors='replace'), time_us)
+            elif name == 'json':
+                try:
+                    message = json.loads(payload)
+                    label = message.get('type', '?') + ('.' + message['state'] if 'state' in message else '')
+                except ValueError:
+                    label = 'json'
+                trigger = (label, time_us)
+            elif name in ('opened', 'closed'):
+                trigger = (name, time_us)
+            elif name == 'state':
+                state = STATE_NAMES[payload[0]] if payload[0] < len(STATE_NAMES) else str(payload[0])
+                if trigger is None:
+                    result.append((state, time_us / 1000, '', 0.0))
+                else:
+                    result.append((state, time_us / 1000, trigger[0], (time_us - trigger[1]) / 1000))
+        return result
+
+
+def extract(args):
+    with open(args.log, 'r', encoding='utf-8', errors='replace') as f:
+        lines = f.read().splitlines()
+    chunks = []
+    inside = False
+    for line in lines:
+        line = line.strip()
+        if line.startswith('SESSION_LOG_BEGIN'):
+            chunks = []
+            inside = True
+        elif line.startswith('SESSION_LOG_END'):
+            inside = False
+        elif inside and line:
+            chunks.append(line)
+    if not chunks:
+        sys.exit('no SESSION_LOG_BEGIN/END block found')
+    data = b''.join(base64.b64decode(chunk) for chunk in chunks)
+    SessionLog(data)
+    with open(args.output, 'wb') as f:
+        f.write(data)
+    print(f'{args.output}: {len(data)} bytes')
+
+
+def info(args):
+    log = SessionLog.load(args.session)
+    counts = {}
+    sizes = {}
+    for event_type, _, payload in log.events:
+        name = EVENT_NAMES.get(event_type, str(event_type))
+        counts[name] = counts.get(name, 0) + 1
+        sizes[name] = sizes.get(name, 0) + len(payload)
+    print(f'input {log.input_sample_rate} Hz x{log.input_channels}, output {log.output_sample_rate} Hz, '
+          f'{len(log.events)} records, {log.duration_ms / 1000:.1f} s')
+    for name in sorted(counts):
+        print(f'  {name:<8}{counts[name]:>8} records{sizes[name]:>12} bytes')
+    print('\nstate timeline:')
+    for state, time_ms, trigger, latency in log.timeline():
+        print(f'  {time_ms:>10.1f} ms  {state:<12} after {trigger or "-":<20} {latency:>8.1f} ms')
+
+
+def compare(args):
+    baseline = SessionLog.load(args.baseline).timeline()
+    current = SessionLog.load(args.current).timeline()
+    failures = []
+    print(f"{'#':>3}  {'state':<12}{'trigger':<20}{'baseline ms':>12}{'current ms':>12}{'change':>10}")
+    for i, (base, cur) in enumerate(zip(baseline, current)):
+        if base[0] != cur[0]:
+            failures.append(f'transition {i}: state {cur[0]} differs from baseline {base[0]}')
+            print(f'{i:>3}  {cur[0]:<12}{"(diverged from " + base[0] + ")":<20}')
+            break
+        change = cur[3] - base[3]
+        print(f'{i:>3}  {cur[0]:<12}{cur[2]:<20}{base[3]:>12.1f}{cur[3]:>12.1f}{change:>+10.1f}')
+        if change > args.max_regression_ms:
+            failures.append(f'transition {i} {cur[0]} after {cur[2]}: {cur[3]:.1f} ms, '
+                            f'baseline {base[3]:.1f} ms (+{change:.1f} ms)')
+    if len(baseline) != len(current) and not failures:
+        failures.append(f'{len(current)} state transitions, baseline has {len(baseline)}')
+    finish(failures)
+
+
+def report(args):
+    def load(path):
+        with open(path, 'r', encoding='utf-8') as f:
+            text = f.read().strip()
+        if 'SESSION_REPLAY_REPORT' in text:
+            text = text[text.rindex('SESSION_REPLAY_REPORT') + len('SESSION_REPLAY_REPORT'):].splitlines()[0]
+        return json.loads(text)
+
+    baseline = load(args.baseline)
+    current = load(args.current)
+    failures = []
+    for key in ('cpu_user_ms', 'cpu_system_ms', 'wall_ms', 'sent_audio_packets', 'sent_json_messages'):
+        print(f'{key:<22}{baseline.get(key, 0):>10}{current.get(key, 0):>10}')
+    base_cpu = baseline['cpu_user_ms'] + baseline['cpu_system_ms']
+    cur_cpu = current['cpu_user_ms'] + current['cpu_system_ms']
+    if base_cpu > 0:
+        change = cur_cpu / base_cpu - 1
+        print(f'cpu time change {change:+.1%}')
+        if change > args.tolerance:
+            failures.append(f'cpu time {cur_cpu} ms, baseline {base_cpu} ms ({change:+.1%})')
+    if baseline.get('sent_audio_packets') != current.get('sent_audio_packets'):
+        print('warning: upstream audio packet count differs, the replay may have diverged')
+    finish(failures)
+
+
+def finish(failures):
+    if failures:
+        print('\nregressions:')
+        for failure in failures:
+            print(f'  {failure}')
+        sys.exit(1)
+    print('\nno regression')
+
+
+def main():
+    parser = argparse.ArgumentParser(description='小智会话录制/回放工具')
+    subparsers = parser.add_subparsers(dest='command', required=True)
+
+    p = subparsers.add_parser('extract', help='从串口日志中提取 session dump 输出的会话日志')
+    p.add_argument('log')
+    p.add_argument('-o', '--output', required=True)
+    p.set_defaults(func=extract)
+
+    p = subparsers.add_parser('info', help='显示会话日志的统计和状态时间线')
+    p.add_argument('session')
+    p.set_defaults(func=info)
+
+    p = subparsers.add_parser('compare', help='比较两次回放录制的状态时间线和处理延迟')
+    p.add_argument('baseline')
+    p.add_argument('current')
+    p.add_argument('--max-regression-ms', type=float, default=50, help='单次状态切换允许增加的延迟')
+    p.set_defaults(func=compare)
+
+    p = subparsers.add_parser('report', help='比较两次回放报告的 CPU 时间')
+    p.add_argument('baseline')
+    p.add_argument('current')
+    p.add_argument('--tolerance', type=float, default=0.1, help='允许的 CPU 时间增加比例')
+    p.set_defaults(func=report)
+
+    args = parser.parse_args()
+    args.func(args)
+
+
+if __name__ == '__main__':
+    main()
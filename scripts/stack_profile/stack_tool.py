@@ -0,0 +1,129 @@
+# 栈用量分析工具：从串口日志提取 stack_profile 的输出，按实测用量加余量生成板子的 task_stack_sizes.h
+import argparse
+import os
+import sys
+from datetime import date
+
+HEADER_TEMPLATE = """// 由 scripts/stack_profile/stack_tool.py 生成，请勿手动修改
+// 板子: {board}，日期: {date}，余量: {margin}%，采集: {runs} 份日志
+#ifndef TASK_STACK_SIZES_H
+#define TASK_STACK_SIZES_H
+
+{defines}#endif // TASK_STACK_SIZES_H
+"""
+
+
+def parse_log(path):
+    """返回最后一次 STACK_PROFILE_BEGIN/END 之间的 (板子, [(任务, 宏, 栈大小, 最小剩余)])"""
+    with open(path, 'r', encoding='utf-8', errors='replace') as f:
+        lines = f.read().splitlines()
+    board = None
+    rows = None
+    inside = False
+    for line in lines:
+        line = line.strip()
+        if line.startswith('STACK_PROFILE_BEGIN'):
+            parts = line.split()
+            board = parts[1] if len(parts) > 1 else None
+            rows = []
+            inside = True
+        elif line.startswith('STACK_PROFILE_END'):
+            inside = False
+        elif inside:
+            fields = line.split(',')
+            if len(fields) != 4 or not fields[3].isdigit():
+                # 串口日志中偶尔夹杂其他任务的输出，跳过
+                continue
+            name, macro, size, free = fields
+            rows.append((name, None if macro == '-' else macro, None if size == '-' else int(size), int(free)))
+    if rows is None:
+        sys.exit(f'{path}: no STACK_PROFILE_BEGIN/END block found')
+    return board, rows
+
+
+def collect(paths):
+    """合并多份日志，同一个宏取所有任务和所有日志中用量最大的一次"""
+    boards = set()
+    usage = {}
+    others = {}
+    for path in paths:
+        board, rows = parse_log(path)
+        boards.add(board)
+        for name, macro, size, free in rows:
+            if macro is None:
+                others[name] = min(free, others.get(name, free))
+                continue
+            used = size - free
+            entry = usage.setdefault(macro, {'size': size, 'used': 0, 'tasks': set()})
+            entry['used'] = max(entry['used'], used)
+            entry['tasks'].add(name)
+    if len(boards) != 1:
+        sys.exit(f'logs come from different boards: {sorted(str(b) for b in boards)}')
+    return boards.pop(), usage, others
+
+
+def recommend(used, margin, minimum):
+    size = int(used * (100 + margin) / 100)
+    # 按 256 字节取整
+    size = (size + 255) // 256 * 256
+    return max(size, minimum)
+
+
+def report(args):
+    board, usage, others = collect(args.logs)
+    print(f'board: {board}')
+    print(f'{"macro":<32}{"tasks":<40}{"size":>8}{"used":>8}{"new":>8}')
+    total_saved = 0
+    for macro, entry in sorted(usage.items()):
+        new_size = recommend(entry['used'], args.margin, args.min)
+        total_saved += entry['size'] - new_size
+        print(f'{macro:<32}{",".join(sorted(entry["tasks"])):<40}{entry["size"]:>8}{entry["used"]:>8}{new_size:>8}')
+    print(f'saved: {total_saved} bytes per instance (workers are counted once)')
+    if others:
+        print('\nother tasks (minimum free bytes):')
+        for name, free in sorted(others.items(), key=lambda item: item[1]):
+            print(f'  {name:<24}{free:>8}')
+
+
+def generate(args):
+    board, usage, _ = collect(args.logs)
+    if args.board and args.board != board:
+        sys.exit(f'logs are from {board}, not {args.board}')
+    defines = ''
+    for macro, entry in sorted(usage.items()):
+        new_size = recommend(entry['used'], args.margin, args.min)
+        defines += f'// {", ".join(sorted(entry["tasks"]))}: 实测 {entry["used"]} / {entry["size"]} 字节\n'
+        defines += f'#define {macro} {new_size}\n\n'
+    output = args.output or os.path.join(os.path.dirname(__file__), '..', '..', 'main', 'boards', board,
+                                         'task_stack_sizes.h')
+    with open(output, 'w', encoding='utf-8') as f:
+        f.write(HEADER_TEMPLATE.format(board=board, date=date.today().isoformat(), margin=args.margin,
+                                       runs=len(args.logs), defines=defines))
+    print(f'{os.path.normpath(output)}: {len(usage)} stack sizes')
+
+
+def main():
+    parser = argparse.ArgumentParser(description='stack usage profiling tool')
+    subparsers = parser.add_subparsers(dest='command', required=True)
+
+    def add_common(p):
+        p.add_argument('logs', nargs='+', help='串口日志，包含 stack_profile 的输出')
+        p.add_argument('--margin', type=int, default=25, help='在实测用量上增加的余量百分比')
+        p.add_argument('--min', type=int, default=2048, help='栈大小下限（字节）')
+
+    p = subparsers.add_parser('report', help='打印各任务的实测用量和建议大小')
+    add_common(p)
+    p.set_defaults(func=report)
+
+    p = subparsers.add_parser('generate', help='生成 main/boards/<板子>/task_stack_sizes.h')
+    add_common(p)
+    p.add_argument('--board', help='校验日志来自这个板子')
+    p.add_argument('-o', '--output', help='输出路径，默认写入日志对应板子的目录')
+    p.set_defaults(func=generate)
+
+    args = parser.parse_args()
+    args.func(args)
+
+
+if __name__ == '__main__':
+    main()
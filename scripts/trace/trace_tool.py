@@ -0,0 +1,140 @@
+# 事件跟踪工具：从串口日志提取 trace dump 的输出，转换为 Perfetto / chrome://tracing 可以打开的 JSON，并统计各事件耗时
+import argparse
+import json
+import sys
+
+
+def extract_events(path):
+    """返回最后一次 TRACE_JSON_BEGIN/END 之间的事件"""
+    with open(path, 'r', encoding='utf-8', errors='replace') as f:
+        lines = f.read().splitlines()
+    events = None
+    inside = False
+    for line in lines:
+        line = line.strip()
+        if line.startswith('TRACE_JSON_BEGIN'):
+            events = []
+            inside = True
+        elif line.startswith('TRACE_JSON_END'):
+            inside = False
+        elif inside and line.startswith('{'):
+            try:
+                events.append(json.loads(line))
+            except json.JSONDecodeError:
+                # 串口日志中偶尔夹杂其他任务的输出，跳过损坏的行
+                print(f'skip malformed line: {line[:80]}', file=sys.stderr)
+    if events is None:
+        sys.exit('no TRACE_JSON_BEGIN/END block found')
+    return events
+
+
+def normalize(events):
+    """
+    每个核心的环形缓冲区独立覆盖，最早的一段可能只剩结束事件，最后可能有未结束的开始事件：
+    按时间排序后丢弃没有对应开始的结束事件，未结束的事件在最后时刻补上结束
+    """
+    metadata = [e for e in events if e['ph'] == 'M']
+    timed = sorted((e for e in events if e['ph'] != 'M'), key=lambda e: e['ts'])
+    if not timed:
+        return metadata
+    # 两个核心的缓冲区覆盖到的时间范围不同，只保留都有记录的部分
+    first_ts = {}
+    for e in timed:
+        core = e.get('args', {}).get('core')
+        if core is not None and core not in first_ts:
+            first_ts[core] = e['ts']
+    start = max(first_ts.values()) if first_ts else timed[0]['ts']
+    end = timed[-1]['ts']
+
+    result = []
+    stacks = {}
+    dropped = 0
+    for e in timed:
+        if e['ts'] < start:
+            continue
+        if e['ph'] == 'B':
+            stacks.setdefault(e['tid'], []).append(e['name'])
+        elif e['ph'] == 'E':
+            stack = stacks.get(e['tid'], [])
+            if not stack or stack[-1] != e['name']:
+                dropped += 1
+                continue
+            stack.pop()
+        result.append(e)
+    for tid, stack in stacks.items():
+        for name in reversed(stack):
+            result.append({'ph': 'E', 'name': name, 'ts': end, 'pid': 0, 'tid': tid})
+    if dropped:
+        print(f'dropped {dropped} unmatched end events', file=sys.stderr)
+    return metadata + result
+
+
+def extract(args):
+    events = normalize(extract_events(args.log))
+    with open(args.output, 'w', encoding='utf-8') as f:
+        json.dump({'traceEvents': events, 'displayTimeUnit': 'ms'}, f)
+    print(f'{args.output}: {len(events)} events')
+
+
+def stats(args):
+    with open(args.trace, 'r', encoding='utf-8') as f:
+        events = json.load(f)['traceEvents']
+    names = {e['tid']: e['args']['name'] for e in events if e['ph'] == 'M'}
+    timed = [e for e in events if e['ph'] != 'M']
+    if not timed:
+        sys.exit('empty trace')
+    duration_us = max(timed[-1]['ts'] - timed[0]['ts'], 1)
+
+    durations = {}
+    busy = {}
+    stacks = {}
+    counters = {}
+    for e in timed:
+        tid = e.get('tid', 0)
+        if e['ph'] == 'B':
+            stacks.setdefault(tid, []).append(e)
+        elif e['ph'] == 'E':
+            begin = stacks[tid].pop()
+            elapsed = e['ts'] - begin['ts']
+            durations.setdefault(e['name'], []).append(elapsed)
+            # 只累计最外层的事件，嵌套的事件已经包含在内
+            if not stacks[tid]:
+                busy[tid] = busy.get(tid, 0) + elapsed
+        elif e['ph'] == 'C':
+            counters.setdefault(e['name'], []).append(e['args']['value'])
+
+    print(f'duration: {duration_us / 1000:.1f} ms')
+    print(f'\n{"event":<24}{"count":>8}{"total ms":>12}{"avg ms":>10}{"max ms":>10}')
+    for name, values in sorted(durations.items(), key=lambda item: -sum(item[1])):
+        print(f'{name:<24}{len(values):>8}{sum(values) / 1000:>12.1f}'
+              f'{sum(values) / len(values) / 1000:>10.2f}{max(values) / 1000:>10.2f}')
+
+    print(f'\n{"task":<24}{"busy %":>8}')
+    for tid, total in sorted(busy.items(), key=lambda item: -item[1]):
+        print(f'{names.get(tid, str(tid)):<24}{total * 100 / duration_us:>8.1f}')
+
+    if counters:
+        print(f'\n{"counter":<24}{"min":>10}{"avg":>12}{"max":>10}')
+        for name, values in sorted(counters.items()):
+            print(f'{name:<24}{min(values):>10}{sum(values) / len(values):>12.1f}{max(values):>10}')
+
+
+def main():
+    parser = argparse.ArgumentParser(description='小智事件跟踪工具')
+    subparsers = parser.add_subparsers(dest='command', required=True)
+
+    p = subparsers.add_parser('extract', help='从串口日志中提取 trace dump 的输出，保存为 Chrome trace JSON')
+    p.add_argument('log')
+    p.add_argument('-o', '--output', required=True)
+    p.set_defaults(func=extract)
+
+    p = subparsers.add_parser('stats', help='统计各事件的耗时、各任务的忙碌比例和计数器范围')
+    p.add_argument('trace')
+    p.set_defaults(func=stats)
+
+    args = parser.parse_args()
+    args.func(args)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,100 @@
+# 比较界面渲染基准测试结果与基线，CPU 时间或确定性指标（重绘像素、对象数、LVGL 堆）超出容差时返回非零
+import argparse
+import json
+import sys
+
+BEGIN_MARKER = 'UI_BENCHMARK_BEGIN'
+END_MARKER = 'UI_BENCHMARK_END'
+
+# 虚拟时钟下只取决于代码和脚本的指标，任何增长都视为回归
+DETERMINISTIC_METRICS = ('flushed_pixels', 'changed_pixels', 'objects', 'heap_peak')
+
+
+def load_result(path):
+    """读取 JSON 文件，或从日志中提取 UI_BENCHMARK_BEGIN/END 之间的最后一次结果"""
+    with open(path, 'r', encoding='utf-8', errors='replace') as f:
+        text = f.read()
+    if BEGIN_MARKER in text:
+        start = text.rindex(BEGIN_MARKER) + len(BEGIN_MARKER)
+        end = text.find(END_MARKER, start)
+        if end < 0:
+            raise ValueError(f'{path}: missing {END_MARKER}')
+        text = text[start:end]
+    return json.loads(text)
+
+
+def index_steps(result):
+    steps = {}
+    for target in result.get('targets', []):
+        for step in target.get('steps', []):
+            steps[f"{target['name']}/{step['name']}"] = step
+    return steps
+
+
+def cpu_us(step):
+    return step['update_us'] + step['render_us']
+
+
+def main():
+    parser = argparse.ArgumentParser(description='界面渲染基准测试回归检查')
+    parser.add_argument('result', help='基准测试结果 JSON 或包含结果的日志')
+    parser.add_argument('--baseline', help='基线结果 JSON 或日志')
+    parser.add_argument('--tolerance', type=float, default=0.2,
+                        help='允许的 CPU 时间增长比例，默认 0.2 即 20%%')
+    parser.add_argument('--pixel-tolerance', type=float, default=0.0,
+                        help='允许的重绘像素、对象数和 LVGL 堆峰值增长比例，默认 0')
+    parser.add_argument('--min-cpu-us', type=int, default=200,
+                        help='基线 CPU 时间低于该值的步骤不检查 CPU 时间，避免计时噪声，默认 200')
+    parser.add_argument('--targets', help='只检查这些分辨率，逗号分隔，如 lcd_240x240,oled_128x64')
+    parser.add_argument('--update-baseline', action='store_true', help='检查后用本次结果覆盖基线文件')
+    args = parser.parse_args()
+
+    result = load_result(args.result)
+    current = index_steps(result)
+    if args.targets:
+        selected = tuple(name + '/' for name in args.targets.split(','))
+        current = {name: step for name, step in current.items() if name.startswith(selected)}
+    print(f"target {result.get('target')} board {result.get('board')}")
+
+    baseline = {}
+    if args.baseline:
+        baseline = index_steps(load_result(args.baseline))
+
+    failures = []
+    print(f"{'step':<32}{'cpu_us':>9}{'baseline':>10}{'change':>9}{'flushed':>10}{'changed':>10}{'objects':>9}{'heap_peak':>11}")
+    for name, step in current.items():
+        line = f"{name:<32}{cpu_us(step):>9}"
+        base = baseline.get(name)
+        if base is not None:
+            base_cpu = cpu_us(base)
+            change = cpu_us(step) / base_cpu - 1 if base_cpu > 0 else 0
+            line += f"{base_cpu:>10}{change:>+9.1%}"
+            if base_cpu >= args.min_cpu_us and change > args.tolerance:
+                failures.append(f'{name}: cpu {cpu_us(step)} us, baseline {base_cpu} us ({change:+.1%})')
+            for metric in DETERMINISTIC_METRICS:
+                if step[metric] > base[metric] * (1 + args.pixel_tolerance):
+                    failures.append(f'{name}: {metric} {step[metric]}, baseline {base[metric]}')
+        else:
+            line += f"{'-':>10}{'-':>9}"
+        line += f"{step['flushed_pixels']:>10}{step['changed_pixels']:>10}{step['objects']:>9}{step['heap_peak']:>11}"
+        print(line)
+
+    for name in baseline:
+        if name not in current and (not args.targets or name.startswith(selected)):
+            print(f'warning: {name} missing from result')
+
+    if args.update_baseline and args.baseline and not failures:
+        with open(args.baseline, 'w', encoding='utf-8') as f:
+            json.dump(result, f, indent=2)
+        print(f'baseline updated: {args.baseline}')
+
+    if failures:
+        print('\nregressions:')
+        for failure in failures:
+            print(f'  {failure}')
+        sys.exit(1)
+    print('\nno regression')
+
+
+if __name__ == '__main__':
+    main()